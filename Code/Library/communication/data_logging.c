@@ -47,6 +47,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <math.h>
 
 //------------------------------------------------------------------------------
@@ -123,6 +124,27 @@ static void data_logging_print_error_signification(data_logging_t* data_logging)
  */
 static void data_logging_f_seek(data_logging_t* data_logging);
 
+/**
+ * \brief	Set the file name from the name proposed and the sysid, unless a valid name was already proposed
+ *
+ * \param	data_logging			The pointer to the data logging structure
+ * \param	file_name				The name of the file to create
+ * \param	sysid					The sysid of the MAV
+ */
+static void data_logging_set_file_name(data_logging_t* data_logging, const char* file_name, uint32_t sysid);
+
+/**
+ * \brief	Probe the file names until a free one is found and open it
+ *
+ * \details	Resumable: yields once it has run for longer than the time slice, 
+ *			the next invocation probes the next file name
+ *
+ * \param	data_logging			The pointer to the data logging structure
+ *
+ * \return	TASK_RUN_BLOCKED until the search is over
+ */
+static task_return_t data_logging_open_new_log_file(data_logging_t* data_logging);
+
 //------------------------------------------------------------------------------
 // PRIVATE FUNCTIONS IMPLEMENTATION
 //------------------------------------------------------------------------------
@@ -492,6 +514,95 @@ static void data_logging_f_seek(data_logging_t* data_logging)
 	}
 }
 
+static void data_logging_set_file_name(data_logging_t* data_logging, const char* file_name, uint32_t sysid)
+{
+	data_logging->sys_id = sysid;
+	
+	if (!data_logging->file_name_init)
+	{
+		snprintf(data_logging->file_name, data_logging->buffer_name_size, "%s_%ld", file_name, sysid);
+	}
+	data_logging->file_name_init = true;
+}
+
+static task_return_t data_logging_open_new_log_file(data_logging_t* data_logging)
+{
+	coroutine_t* cr = &data_logging->file_search;
+	
+	COROUTINE_BEGIN(cr);
+	
+	data_logging->file_number = 0;
+	
+	do 
+	{
+		if (data_logging->file_number > 0)
+		{
+			if (snprintf(data_logging->name_n_extension, data_logging->buffer_name_size, "%s%s.txt", data_logging->file_name, data_logging->file_add) >= data_logging->buffer_name_size)
+			{
+				print_util_dbg_print("Name error: The name is too long! It should be, with the extension, maximum ");
+				print_util_dbg_print_num(data_logging->buffer_name_size,10);
+				print_util_dbg_print(" and it is ");
+				print_util_dbg_print_num(strlen(data_logging->file_name),10);
+				print_util_dbg_print("\r\n");
+			}
+		}
+		else
+		{
+			if (snprintf(data_logging->name_n_extension, data_logging->buffer_name_size, "%s.txt", data_logging->file_name) >= data_logging->buffer_name_size)
+			{
+				print_util_dbg_print("Name error: The name is too long! It should be maximum ");
+				print_util_dbg_print_num(data_logging->buffer_name_size,10);
+				print_util_dbg_print(" characters and it is ");
+				print_util_dbg_print_num(strlen(data_logging->file_name),10);
+				print_util_dbg_print(" characters.\r\n");
+			}
+		}
+		
+		data_logging->fr = f_open(&data_logging->fil, data_logging->name_n_extension, FA_WRITE | FA_CREATE_NEW);
+		
+		if (data_logging->debug)
+		{
+			print_util_dbg_print("f_open result:");
+			data_logging_print_error_signification(data_logging);
+		}
+		
+		++data_logging->file_number;
+		
+		if (data_logging->fr == FR_EXIST)
+		{
+			if(snprintf(data_logging->file_add,data_logging->buffer_add_size,"_%ld",data_logging->file_number) >= data_logging->buffer_add_size)
+			{
+				print_util_dbg_print("Error file extension! Extension too long.\r\n");
+			}
+			
+			// Let the other tasks run before probing the next name
+			COROUTINE_YIELD_IF_SLICE_SPENT(cr);
+		}
+		
+	} while( (data_logging->file_number < MAX_NUMBER_OF_LOGGED_FILE) && (data_logging->fr == FR_EXIST) );
+	
+	if (data_logging->fr == FR_OK)
+	{
+		data_logging_f_seek(data_logging);
+	}
+	
+	if (data_logging->fr == FR_OK)
+	{
+		data_logging->file_opened = true;
+		
+		if (data_logging->debug)
+		{
+			print_util_dbg_print("File ");
+			print_util_dbg_print(data_logging->name_n_extension);
+			print_util_dbg_print(" opened. \r\n");
+		}
+	}
+	
+	COROUTINE_END(cr);
+	
+	return TASK_RUN_SUCCESS;
+}
+
 //------------------------------------------------------------------------------
 // PUBLIC FUNCTIONS IMPLEMENTATION
 //------------------------------------------------------------------------------
@@ -542,6 +653,10 @@ void data_logging_init(data_logging_t* data_logging, const data_logging_conf_t*
 	
 	data_logging->file_name = malloc(data_logging->buffer_name_size);
 	data_logging->name_n_extension = malloc(data_logging->buffer_name_size);
+	data_logging->file_add = malloc(data_logging->buffer_add_size);
+	
+	data_logging->file_number = 0;
+	coroutine_init(&data_logging->file_search, COROUTINE_TIME_SLICE);
 	
 	data_logging->fr = f_mount(&data_logging->fs, "", 1);
 	
@@ -575,91 +690,31 @@ void data_logging_init(data_logging_t* data_logging, const data_logging_conf_t*
 
 void data_logging_create_new_log_file(data_logging_t* data_logging, const char* file_name, uint32_t sysid)
 {
-	int32_t i = 0;
-	
-	char *file_add = malloc(data_logging->buffer_add_size);
-	
-	data_logging->sys_id = sysid;
-	
-	if (!data_logging->file_name_init)
-	{
-		snprintf(data_logging->file_name, data_logging->buffer_name_size, "%s_%ld", file_name, sysid);
-	}
-	data_logging->file_name_init = true;
+	data_logging_set_file_name(data_logging, file_name, sysid);
 	
 	if (data_logging->log_data)
 	{
-		do 
-		{
-			if (i > 0)
-			{
-				if (snprintf(data_logging->name_n_extension, data_logging->buffer_name_size, "%s%s.txt", data_logging->file_name, file_add) >= data_logging->buffer_name_size)
-				{
-					print_util_dbg_print("Name error: The name is too long! It should be, with the extension, maximum ");
-					print_util_dbg_print_num(data_logging->buffer_name_size,10);
-					print_util_dbg_print(" and it is ");
-					print_util_dbg_print_num(sizeof(file_name),10);
-					print_util_dbg_print("\r\n");
-				}
-			}
-			else
-			{
-				if (snprintf(data_logging->name_n_extension, data_logging->buffer_name_size, "%s.txt", data_logging->file_name) >= data_logging->buffer_name_size)
-				{
-					print_util_dbg_print("Name error: The name is too long! It should be maximum ");
-					print_util_dbg_print_num(data_logging->buffer_name_size,10);
-					print_util_dbg_print(" characters and it is ");
-					print_util_dbg_print_num(sizeof(file_name),10);
-					print_util_dbg_print(" characters.\r\n");
-				}
-			}
+		coroutine_reset(&data_logging->file_search);
 		
-			data_logging->fr = f_open(&data_logging->fil, data_logging->name_n_extension, FA_WRITE | FA_CREATE_NEW);
-			
-			if (data_logging->debug)
-			{
-				print_util_dbg_print("f_open result:");
-				data_logging_print_error_signification(data_logging);
-			}
-		
-			++i;
-		
-			if (data_logging->fr == FR_EXIST)
-			{
-
-				if(snprintf(file_add,data_logging->buffer_add_size,"_%ld",i) >= data_logging->buffer_add_size)
-				{
-					print_util_dbg_print("Error file extension! Extension too long.\r\n");
-				}
-			}
-		
-		//}while((i < MAX_NUMBER_OF_LOGGED_FILE)&&(data_logging->fr != FR_OK)&&(data_logging->fr != FR_NOT_READY));
-		} while( (i < MAX_NUMBER_OF_LOGGED_FILE) && (data_logging->fr == FR_EXIST) );
-	
-		if (data_logging->fr == FR_OK)
+		while (data_logging_open_new_log_file(data_logging) == TASK_RUN_BLOCKED)
 		{
-			data_logging_f_seek(data_logging);
-		}
-	
-		if (data_logging->fr == FR_OK)
-		{
-			data_logging->file_opened = true;
-		
-			if (data_logging->debug)
-			{
-				print_util_dbg_print("File ");
-				print_util_dbg_print(data_logging->name_n_extension);
-				print_util_dbg_print(" opened. \r\n");
-			}
+			;
 		}
 	}
 }
 
 task_return_t data_logging_update(data_logging_t* data_logging)
 {
+	task_return_t result = TASK_RUN_SUCCESS;
+	
 	if (data_logging->log_data == 1)
 	{
-		if (data_logging->file_opened)
+		if (coroutine_is_running(&data_logging->file_search))
+		{
+			// Resume the search of a free file name
+			result = data_logging_open_new_log_file(data_logging);
+		}
+		else if (data_logging->file_opened)
 		{
 			if (data_logging->file_init)
 			{
@@ -707,7 +762,8 @@ task_return_t data_logging_update(data_logging_t* data_logging)
 				{
 					data_logging->sys_mounted = true;
 					
-					data_logging_create_new_log_file(data_logging,data_logging->file_name,data_logging->sys_id);
+					data_logging_set_file_name(data_logging,data_logging->file_name,data_logging->sys_id);
+					result = data_logging_open_new_log_file(data_logging);
 				}
 				else
 				{
@@ -719,6 +775,8 @@ task_return_t data_logging_update(data_logging_t* data_logging)
 	else
 	{
 		data_logging->loop_count = 0;
+		coroutine_reset(&data_logging->file_search);
+		
 		if (data_logging->file_opened)
 		{
 			if (data_logging->fr != FR_NO_FILE)
@@ -782,7 +840,7 @@ task_return_t data_logging_update(data_logging_t* data_logging)
 		}
 		
 	}
-	return TASK_RUN_SUCCESS;
+	return result;
 }
 
 void data_logging_add_parameter_uint8(data_logging_t* data_logging, uint8_t* val, const char* param_name)
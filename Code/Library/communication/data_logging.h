@@ -49,6 +49,7 @@ extern "C" {
 
 #include "fat_fs/ff.h"
 #include "tasks.h"
+#include "coroutine.h"
 
 
 #define MAX_DATA_LOGGING_COUNT 50								///< The max number of data logging parameters
@@ -116,6 +117,10 @@ typedef struct
 
 	char *file_name;											///< The file name
 	char *name_n_extension;										///< Stores the name of the file
+	char *file_add;												///< Stores the number appended to the file name
+
+	int32_t file_number;										///< The number of the file name being probed
+	coroutine_t file_search;									///< The search of a free file name, resumed at each update
 
 	bool file_init;												///< A flag to tell whether a file is init or not
 	bool file_opened;											///< A flag to tell whether a file is opened or not
@@ -146,6 +151,9 @@ void data_logging_init(data_logging_t* data_logging, const data_logging_conf_t*
 /**
  * \brief	Create and open a new file
  *
+ * \details	Blocks until a free file name is found, data_logging_update() 
+ *			searches it over several invocations instead
+ *
  * \param	data_logging			The pointer to the data logging structure
  * \param	file_name				The name of the file to create
  * \param	sysid					The sysid of the MAV
@@ -42,6 +42,7 @@
 
 
 #include "mavlink_communication.h"
+#include "scheduler_analysis.h"
 #include "print_util.h"
 #include <stdlib.h>
 
@@ -87,7 +88,11 @@ static void mavlink_communication_toggle_telemetry_stream(scheduler_t* scheduler
 			for (int32_t i = 0; i < mavlink_task_set->task_count; i++) 
 			{
 				task_entry_t* task = scheduler_get_task_by_index(scheduler, i);
-				scheduler_run_task_now(task);
+				
+				if (task->descriptor->task_id < MAVLINK_COMMUNICATION_TASK_ID_NOT_STREAM)
+				{
+					scheduler_run_task_now(task);
+				}
 			}					
 		} 
 		else 
@@ -96,6 +101,9 @@ static void mavlink_communication_toggle_telemetry_stream(scheduler_t* scheduler
 		
 			if ( task != NULL )
 			{
+				task_run_mode_t previous_run_mode = task->run_mode;
+				uint32_t previous_period = task->repeat_period;
+
 				if (request.start_stop) 
 				{
 					scheduler_change_run_mode(task, RUN_REGULAR);
@@ -109,6 +117,22 @@ static void mavlink_communication_toggle_telemetry_stream(scheduler_t* scheduler
 				{
 					scheduler_change_task_period(task, SCHEDULER_TIMEBASE / (uint32_t)request.req_message_rate);
 				}
+
+				// Refuse the requests which add load to a task set which does not fit
+				if ( ( task->run_mode != RUN_NEVER ) && ( ( previous_run_mode == RUN_NEVER ) || ( task->repeat_period < previous_period ) ) )
+				{
+					if ( scheduler_analysis_admission_control(scheduler) == false )
+					{
+						print_util_dbg_print("Stream request refused, the telemetry would not fit in its CPU budget.\r\n");
+						scheduler_change_task_period(task, previous_period);
+						scheduler_change_run_mode(task, previous_run_mode);
+						scheduler_analysis_admission_control(scheduler);
+					}
+				}
+				else
+				{
+					scheduler_analysis_admission_control(scheduler);
+				}
 			}
 			else
 			{
@@ -177,8 +201,6 @@ void mavlink_communication_init(mavlink_communication_t* mavlink_communication,
 
 task_return_t mavlink_communication_update(mavlink_communication_t* mavlink_communication) 
 {
-	task_return_t result = 0;
-
 	mavlink_stream_t* mavlink_stream = &mavlink_communication->mavlink_stream;
 	mavlink_message_handler_t* handler = &mavlink_communication->message_handler;
 
@@ -195,10 +217,10 @@ task_return_t mavlink_communication_update(mavlink_communication_t* mavlink_comm
 	// Send messages
 	if (mavlink_stream->tx->buffer_empty(mavlink_stream->tx->data) == true) 
 	{
-		result = scheduler_update(&mavlink_communication->scheduler);
+		scheduler_update(&mavlink_communication->scheduler);
 	}
 	
-	return result;
+	return TASK_RUN_SUCCESS;
 }
 
 
@@ -54,6 +54,25 @@ extern "C" {
 #include "onboard_parameters.h"
 
 
+/**
+ * \brief		Task IDs of the MAVLink scheduler tasks that do not use the ID of a message
+ * 
+ * \details 	A stream task is identified by the ID of the message it sends, which the ground 
+ * 				station starts and stops with REQUEST_DATA_STREAM. The tasks below are given IDs 
+ * 				above the 8 bit message IDs, so that they never take the ID of a message stream 
+ * 				and cannot be reached by a stream request.
+ */
+typedef enum
+{
+	MAVLINK_COMMUNICATION_TASK_ID_ADAPTATION = 256,					///<	Noise adaptation of the track following, sent as NAMED_VALUE_FLOAT
+	MAVLINK_COMMUNICATION_TASK_ID_VIBRATION_PEAKS,					///<	Vibration peaks, sent as DEBUG_VECT
+	MAVLINK_COMMUNICATION_TASK_ID_BUDGET,							///<	Scheduler budget, sent as DEBUG_VECT
+	MAVLINK_COMMUNICATION_TASK_ID_NOT_STREAM = 512,					///<	First ID of the tasks that send no message
+	MAVLINK_COMMUNICATION_TASK_ID_PARAMETERS_WRITE = MAVLINK_COMMUNICATION_TASK_ID_NOT_STREAM,	///<	Writing of the onboard parameters to flash
+	MAVLINK_COMMUNICATION_TASK_ID_SCENARIO,							///<	Setting of a waypoint scenario
+} mavlink_communication_task_id_t;
+
+
 /**
  * \brief 		Pointer a module's data structure
  * 
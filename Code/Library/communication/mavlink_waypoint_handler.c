@@ -54,11 +54,22 @@
 /**
  * \brief	Sets a scenario for multiple MAV case
  *
+ * \details	The scenario is set by the scheduler, the command is refused while the previous one is not set
+ *
  * \param	waypoint_handler		The pointer to the structure of the MAVLink waypoint handler
  * \param	packet					The pointer to the structure of the MAVLink command message long
  */
 static mav_result_t waypoint_handler_set_scenario(mavlink_waypoint_handler_t* waypoint_handler, mavlink_command_long_t* packet);
 
+/**
+ * \brief	Sets the scenario requested by the last command
+ *
+ * \param	waypoint_handler		The pointer to the structure of the MAVLink waypoint handler
+ *
+ * \return	TASK_RUN_BLOCKED until the scenario is set
+ */
+static task_return_t waypoint_handler_scenario_update(mavlink_waypoint_handler_t* waypoint_handler);
+
 /**
  * \brief	Sets a circle scenario, where two waypoints are set at opposite side of the circle
  *
@@ -70,10 +81,15 @@ static void waypoint_handler_set_circle_scenario(mavlink_waypoint_handler_t* way
 /**
  * \brief	Sets a circle scenario, where n waypoints are set at random position on a circle
  *
+ * \details	Resumable: yields once it has run for longer than the time slice, 
+ *			the navigation plan is only activated once all the waypoints are set
+ *
  * \param	waypoint_handler		The pointer to the structure of the MAVLink waypoint handler
  * \param	packet					The pointer to the structure of the MAVLink command message long
+ *
+ * \return	TASK_RUN_BLOCKED until all the waypoints are set
  */
-static void waypoint_handler_set_circle_uniform_scenario(mavlink_waypoint_handler_t* waypoint_handler, mavlink_command_long_t* packet);
+static task_return_t waypoint_handler_set_circle_uniform_scenario(mavlink_waypoint_handler_t* waypoint_handler, mavlink_command_long_t* packet);
 
 /**
  * \brief	Sets a stream scenario, where two flows of MAVs go in opposite ways
@@ -183,27 +199,54 @@ static mav_result_t waypoint_handler_set_scenario(mavlink_waypoint_handler_t* wa
 {
 	mav_result_t result;
 	
-	if (packet->param1 == 1)
+	if ((packet->param1 != 1) && (packet->param1 != 2) && (packet->param1 != 3))
 	{
-		waypoint_handler_set_circle_scenario(waypoint_handler, packet);
+		result = MAV_RESULT_UNSUPPORTED;
+	}
+	else if (coroutine_is_running(&waypoint_handler->scenario))
+	{
+		result = MAV_RESULT_TEMPORARILY_REJECTED;
+	}
+	else
+	{
+		task_entry_t* scenario_task = scheduler_get_task_by_id(&waypoint_handler->mavlink_communication->scheduler, MAVLINK_COMMUNICATION_TASK_ID_SCENARIO);
+		
+		waypoint_handler->scenario_packet = *packet;
+		
+		if (scenario_task != NULL)
+		{
+			scheduler_run_task_now(scenario_task);
+		}
+		else
+		{
+			while (waypoint_handler_scenario_update(waypoint_handler) == TASK_RUN_BLOCKED)
+			{
+				;
+			}
+		}
 		
 		result = MAV_RESULT_ACCEPTED;
 	}
+	
+	return result;
+}
+
+static task_return_t waypoint_handler_scenario_update(mavlink_waypoint_handler_t* waypoint_handler)
+{
+	task_return_t result = TASK_RUN_SUCCESS;
+	mavlink_command_long_t* packet = &waypoint_handler->scenario_packet;
+	
+	if (packet->param1 == 1)
+	{
+		waypoint_handler_set_circle_scenario(waypoint_handler, packet);
+	}
 	else if (packet->param1 == 2)
 	{
-		waypoint_handler_set_circle_uniform_scenario(waypoint_handler, packet);
-		
-		result = MAV_RESULT_ACCEPTED;
+		result = waypoint_handler_set_circle_uniform_scenario(waypoint_handler, packet);
 	}
 	else if (packet->param1 == 3)
 	{
 		waypoint_handler_set_stream_scenario(waypoint_handler, packet);
-		
-		result = MAV_RESULT_ACCEPTED;
-	}
-	else
-	{
-		result = MAV_RESULT_UNSUPPORTED;
 	}
 	
 	return result;
@@ -307,9 +350,9 @@ static void waypoint_handler_set_circle_scenario(mavlink_waypoint_handler_t* way
 	}
 }
 
-static void waypoint_handler_set_circle_uniform_scenario(mavlink_waypoint_handler_t* waypoint_handler, mavlink_command_long_t* packet)
+static task_return_t waypoint_handler_set_circle_uniform_scenario(mavlink_waypoint_handler_t* waypoint_handler, mavlink_command_long_t* packet)
 {
-	int16_t i;
+	coroutine_t* cr = &waypoint_handler->scenario;
 	
 	float circle_radius = packet->param2;
 	float altitude = -packet->param4;
@@ -322,13 +365,20 @@ static void waypoint_handler_set_circle_uniform_scenario(mavlink_waypoint_handle
 	local_coordinates_t waypoint_transfo;
 	global_position_t waypoint_global;
 	
+	waypoint_transfo.origin = waypoint_handler->position_estimator->local_position.origin;
+	
+	COROUTINE_BEGIN(cr);
+	
 	waypoint_handler->number_of_waypoints = 0;
 	waypoint_handler->current_waypoint_count = -1;
 	
-	waypoint_transfo.origin = waypoint_handler->position_estimator->local_position.origin;
+	// The navigation must not follow a partial list
+	waypoint_handler->state->nav_plan_active = false;
 	
-	for (i = 0; i < 10; ++i)
+	for (waypoint_handler->scenario_waypoint = 0; waypoint_handler->scenario_waypoint < 10; ++waypoint_handler->scenario_waypoint)
 	{
+		int16_t i = waypoint_handler->scenario_waypoint;
+		
 		waypoint_handler->number_of_waypoints++;
 		
 		x = 2.0f * PI * rand();
@@ -371,6 +421,8 @@ static void waypoint_handler_set_circle_uniform_scenario(mavlink_waypoint_handle
 		waypoint.param4 = rad_to_deg(maths_calc_smaller_angle(PI + atan2(y,x))); // Desired yaw angle at MISSION (rotary wing)
 	
 		waypoint_handler->waypoint_list[i] = waypoint;
+		
+		COROUTINE_YIELD_IF_SLICE_SPENT(cr);
 	}
 	
 	if (packet->param5 == 1)
@@ -388,6 +440,10 @@ static void waypoint_handler_set_circle_uniform_scenario(mavlink_waypoint_handle
 			waypoint_handler->hold_waypoint_set = false;
 		}
 	}
+	
+	COROUTINE_END(cr);
+	
+	return TASK_RUN_SUCCESS;
 }
 
 static void waypoint_handler_set_stream_scenario(mavlink_waypoint_handler_t* waypoint_handler, mavlink_command_long_t* packet)
@@ -1072,6 +1128,19 @@ void waypoint_handler_init(mavlink_waypoint_handler_t* waypoint_handler, positio
 	waypoint_handler->waypoint_sending = false;
 	waypoint_handler->waypoint_receiving = false;
 	
+	coroutine_init(&waypoint_handler->scenario, COROUTINE_TIME_SLICE);
+	waypoint_handler->scenario_waypoint = 0;
+	
+	// Set the scenarios, run on request, the period only matters to the admission control
+	scheduler_add_task(	&mavlink_communication->scheduler, 
+						100000, 
+						RUN_NEVER, 
+						PERIODIC_ABSOLUTE,
+						PRIORITY_LOW,
+						(task_function_t)&waypoint_handler_scenario_update, 
+						(task_argument_t)waypoint_handler, 
+						MAVLINK_COMMUNICATION_TASK_ID_SCENARIO);
+	
 	// Add callbacks for waypoint handler messages requests
 	mavlink_message_handler_msg_callback_t callback;
 
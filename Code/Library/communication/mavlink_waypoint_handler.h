@@ -55,6 +55,7 @@ extern "C" {
 #include "mavlink_communication.h"
 #include "state.h"
 #include "qfilter.h"
+#include "coroutine.h"
 
 #define MAX_WAYPOINTS 10		///< The maximal size of the waypoint list
 
@@ -112,6 +113,10 @@ typedef struct
 	mavlink_communication_t* mavlink_communication;				///< The pointer to the MAVLink communication structure
 	const mavlink_stream_t* mavlink_stream;						///< Pointer to MAVLink stream
 
+	coroutine_t scenario;										///< Setting of the scenario, resumed by the scheduler
+	mavlink_command_long_t scenario_packet;						///< The command of the scenario being set
+	int16_t scenario_waypoint;									///< The number of the scenario waypoint being set
+
 }mavlink_waypoint_handler_t;
 
 /**
@@ -53,6 +53,7 @@ void neighbors_selection_init(neighbors_t* neighbors, position_estimator_t *posi
 	neighbors->number_of_neighbors = 0;
 	neighbors->position_estimator = position_estimator;
 	neighbors->mavlink_stream = mavlink_stream;
+	neighbors->new_message_task = NULL;
 	
 	// Add callbacks for onboard parameters requests
 	mavlink_message_handler_msg_callback_t callback;
@@ -67,6 +68,43 @@ void neighbors_selection_init(neighbors_t* neighbors, position_estimator_t *posi
 	print_util_dbg_print("Neighbor selection initialized.\r\n");
 }
 
+/**
+ * \brief	Estimate the clock offset of a neighbor and map the timestamp of its message to local time
+ *
+ * \details	The offset is the smallest (local reception time - neighbor timestamp) seen so far,
+ *			i.e. the one of the message with the shortest transmission delay. It slowly follows
+ *			larger values so that the clock drift between the two vehicles is tracked.
+ *
+ * \param	neighbor			The pointer to the neighbor
+ * \param	time_boot_ms		The timestamp of the message, in the clock of the neighbor in ms
+ * \param	time_received		The time at which the message was received in ms
+ * \param	new_neighbor		The flag that tells that the neighbor was not known before
+ */
+static void neighbors_selection_update_clock_offset(track_neighbor_t* neighbor, uint32_t time_boot_ms, uint32_t time_received, bool new_neighbor)
+{
+	float offset_sample = (float)((int32_t)(time_received - time_boot_ms));
+	
+	if (new_neighbor || (time_boot_ms < neighbor->time_boot_ms))
+	{
+		// First message, or the neighbor rebooted
+		neighbor->clock_offset = offset_sample;
+	}
+	else if (offset_sample < neighbor->clock_offset)
+	{
+		// Shorter transmission delay than ever seen
+		neighbor->clock_offset = offset_sample;
+	}
+	else
+	{
+		neighbor->clock_offset += NEIGHBOR_CLOCK_OFFSET_DRIFT_GAIN * (offset_sample - neighbor->clock_offset);
+	}
+	
+	neighbor->time_boot_ms = time_boot_ms;
+	
+	// The offset never exceeds the last sample, so the capture time is never in the future
+	neighbor->time_msg_sent = time_boot_ms + (int32_t)neighbor->clock_offset;
+}
+
 void neighbors_selection_read_message_from_neighbors(neighbors_t *neighbors, uint32_t sysid, mavlink_message_t* msg)
 {
 	
@@ -106,6 +144,7 @@ void neighbors_selection_read_message_from_neighbors(neighbors_t *neighbors, uin
 		local_pos_neighbor.pos[2] = -packet.relative_alt / 1000.0f;
 		
 		bool ID_found = false;
+		bool new_neighbor = false;
 		i = 0;
 		while ((!ID_found)&&(i < neighbors->number_of_neighbors))
 		{
@@ -121,6 +160,8 @@ void neighbors_selection_read_message_from_neighbors(neighbors_t *neighbors, uin
 		
 		if (i >= neighbors->number_of_neighbors)
 		{
+			new_neighbor = true;
+			
 			if (neighbors->number_of_neighbors < MAX_NUM_NEIGHBORS)
 			{
 				actual_neighbor = neighbors->number_of_neighbors;
@@ -150,5 +191,13 @@ void neighbors_selection_read_message_from_neighbors(neighbors_t *neighbors, uin
 		
 		neighbors->neighbors_list[actual_neighbor].time_msg_received = time_keeper_get_millis();
 		
+		neighbors_selection_update_clock_offset(&neighbors->neighbors_list[actual_neighbor], packet.time_boot_ms, neighbors->neighbors_list[actual_neighbor].time_msg_received, new_neighbor);
+		
+		// Release the consumer of the neighbor positions without waiting for its period
+		if ( neighbors->new_message_task != NULL )
+		{
+			scheduler_signal_task(neighbors->new_message_task);
+		}
+		
 	}
 }
@@ -55,6 +55,7 @@ extern "C" {
 #include "barometer.h"
 
 #define MAX_NUM_NEIGHBORS 15										///< The maximum number of neighbors
+#define NEIGHBOR_CLOCK_OFFSET_DRIFT_GAIN 0.0625f					///< The gain at which the clock offset estimate follows slower messages (clock drift)
 
 /**
  * \brief The track neighbor structure
@@ -65,6 +66,9 @@ typedef struct
 	float position[3];												///< The 3D position of the neighbor in m
 	float velocity[3];												///< The 3D velocity of the neighbor in m/s
 	uint32_t time_msg_received;										///< The time at which the message was received in ms
+	uint32_t time_msg_sent;											///< The time at which the neighbor captured its position, in local time in ms
+	uint32_t time_boot_ms;											///< The timestamp of the last message, in the clock of the neighbor in ms
+	float clock_offset;												///< The estimated offset between the local clock and the clock of the neighbor in ms
 } track_neighbor_t;													///< The structure of information about a neighbor 
 
 /**
@@ -79,6 +83,7 @@ typedef struct
 		float near_miss_dist_sqr;									///< The square of the near-miss distance
 		position_estimator_t* position_estimator;					///< The pointer to the position estimator structure
 		const mavlink_stream_t* mavlink_stream;						///< The pointer to the MAVLink stream
+		task_entry_t* new_message_task;								///< The task signalled on each message from a neighbor, NULL if none
 } neighbors_t;
 
 /**
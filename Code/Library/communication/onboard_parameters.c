@@ -89,6 +89,46 @@ static void onboard_parameters_send_parameter(onboard_parameters_t* onboard_para
 static void onboard_parameters_receive_parameter(onboard_parameters_t* onboard_parameters, uint32_t sysid, mavlink_message_t* msg);
 
 
+/**
+ * \brief	Issues a command to the flash controller, without waiting for its completion
+ *
+ * \param	command					The flash command
+ */
+static void onboard_parameters_flashc_issue_command(uint32_t command);
+
+
+/**
+ * \brief	Checks whether the flash controller is ready and collects the errors of the last command
+ *
+ * \param   onboard_parameters		Pointer to module structure
+ *
+ * \return	True if the flash controller is ready
+ */
+static bool onboard_parameters_flashc_is_ready(onboard_parameters_t* onboard_parameters);
+
+
+/**
+ * \brief	Fills the page buffer with the user page, the parameters replacing its current content
+ *
+ * \param   onboard_parameters		Pointer to module structure
+ * \param	bytes_to_write			Size of the parameters on the user page
+ */
+static void onboard_parameters_fill_page_buffer(const onboard_parameters_t* onboard_parameters, uint32_t bytes_to_write);
+
+
+/**
+ * \brief	Writes the parameters to the user page of the flash memory
+ *
+ * \details	Resumable: yields while the flash controller erases or writes 
+ *			the page, the other tasks run between the flash commands
+ *
+ * \param   onboard_parameters		Pointer to module structure
+ *
+ * \return	TASK_RUN_BLOCKED until the write is over
+ */
+static task_return_t onboard_parameters_write_update(onboard_parameters_t* onboard_parameters);
+
+
 //------------------------------------------------------------------------------
 // PRIVATE FUNCTIONS IMPLEMENTATION
 //------------------------------------------------------------------------------
@@ -197,6 +237,123 @@ static void onboard_parameters_send_parameter(onboard_parameters_t* onboard_para
 }
 
 
+static void onboard_parameters_flashc_issue_command(uint32_t command)
+{
+	// As flashc_issue_command() for the user page, which also waits for the end of the command
+	AVR32_FLASHC.fcmd = ( AVR32_FLASHC_FCMD_KEY_KEY << AVR32_FLASHC_FCMD_KEY_OFFSET ) | ( command << AVR32_FLASHC_FCMD_CMD_OFFSET );
+}
+
+
+static bool onboard_parameters_flashc_is_ready(onboard_parameters_t* onboard_parameters)
+{
+	// Single read, the error flags are cleared by reading the status
+	uint32_t status = AVR32_FLASHC.fsr;
+	
+	onboard_parameters->flash_error |= status & ( AVR32_FLASHC_FSR_LOCKE_MASK | AVR32_FLASHC_FSR_PROGE_MASK );
+	
+	return ( ( status & AVR32_FLASHC_FSR_FRDY_MASK ) != 0 );
+}
+
+
+static void onboard_parameters_fill_page_buffer(const onboard_parameters_t* onboard_parameters, uint32_t bytes_to_write)
+{
+	volatile uint64_t* page = (volatile uint64_t*) AVR32_FLASHC_USER_PAGE_ADDRESS;
+	const uint8_t* data = (const uint8_t*) &onboard_parameters->flash_data;
+	uint32_t data_start = MAVERIC_FLASHC_USER_PAGE_START_ADDRESS - AVR32_FLASHC_USER_PAGE_ADDRESS;
+	
+	for (uint32_t i = 0; i < AVR32_FLASHC_USER_PAGE_SIZE / sizeof(uint64_t); i++)
+	{
+		union
+		{
+			uint64_t u64;
+			uint8_t u8[sizeof(uint64_t)];
+		} dword;
+		
+		// The bytes around the parameters, as the protected fuses at the end of the page, are written back
+		dword.u64 = page[i];
+		
+		for (uint32_t j = 0; j < sizeof(uint64_t); j++)
+		{
+			uint32_t k = i * sizeof(uint64_t) + j;
+			
+			if ( ( k >= data_start ) && ( k < data_start + bytes_to_write ) )
+			{
+				dword.u8[j] = data[k - data_start];
+			}
+		}
+		
+		// Writes to the flash go to the page buffer
+		page[i] = dword.u64;
+	}
+}
+
+
+static task_return_t onboard_parameters_write_update(onboard_parameters_t* onboard_parameters)
+{
+	coroutine_t* cr = &onboard_parameters->flash_write;
+	onboard_parameters_set_t* param_set = onboard_parameters->param_set;
+	nvram_data_t* local_array = &onboard_parameters->flash_data;
+	
+	// (1 param_count + parameters + 2 checksums) floats
+	uint32_t bytes_to_write = 4 * (param_set->param_count + 3);
+	
+	COROUTINE_BEGIN(cr);
+	
+	if (bytes_to_write >= MAVERIC_FLASHC_USER_PAGE_FREE_SPACE)
+	{
+		print_util_dbg_print("Attempted to write too many parameters on flash user page, aborted.\r\n");
+		coroutine_reset(cr);
+		return TASK_RUN_ERROR;
+	}
+	
+	print_util_dbg_print("Begin write to flashc...\r\n");
+	
+	float cksum1, cksum2;
+	cksum1 = 0;
+	cksum2 = 0;
+	
+	local_array->values[0] = param_set->param_count;
+	cksum1 += local_array->values[0];
+	cksum2 += cksum1;
+	
+	for (uint32_t i = 1; i <= param_set->param_count; i++)
+	{
+		local_array->values[i] = *(param_set->parameters[i-1].param);
+		
+		cksum1 += local_array->values[i];
+		cksum2 += cksum1;
+	}
+	local_array->values[param_set->param_count + 1] = cksum1;
+	local_array->values[param_set->param_count + 2] = cksum2;
+	
+	// Same sequence as flashc_memcpy() on the user page
+	onboard_parameters->flash_error = 0;
+	COROUTINE_WAIT_UNTIL(cr, onboard_parameters_flashc_is_ready(onboard_parameters));
+	onboard_parameters_flashc_issue_command(AVR32_FLASHC_FCMD_CMD_CPB);
+	COROUTINE_WAIT_UNTIL(cr, onboard_parameters_flashc_is_ready(onboard_parameters));
+	
+	onboard_parameters_fill_page_buffer(onboard_parameters, bytes_to_write);
+	
+	onboard_parameters_flashc_issue_command(AVR32_FLASHC_FCMD_CMD_EUP);
+	COROUTINE_WAIT_UNTIL(cr, onboard_parameters_flashc_is_ready(onboard_parameters));
+	onboard_parameters_flashc_issue_command(AVR32_FLASHC_FCMD_CMD_WUP);
+	COROUTINE_WAIT_UNTIL(cr, onboard_parameters_flashc_is_ready(onboard_parameters));
+	
+	if (onboard_parameters->flash_error == 0)
+	{
+		print_util_dbg_print("Write to flashc completed.\r\n");
+	}
+	else
+	{
+		print_util_dbg_print("Write to flashc failed.\r\n");
+	}
+	
+	COROUTINE_END(cr);
+	
+	return TASK_RUN_SUCCESS;
+}
+
+
 //------------------------------------------------------------------------------
 // PUBLIC FUNCTIONS IMPLEMENTATION
 //------------------------------------------------------------------------------
@@ -208,6 +365,11 @@ void onboard_parameters_init(onboard_parameters_t* onboard_parameters, const onb
 
 	// Init debug mode
 	onboard_parameters->debug = config->debug;
+	
+	// Init flash write
+	onboard_parameters->scheduler = scheduler;
+	onboard_parameters->flash_error = 0;
+	coroutine_init(&onboard_parameters->flash_write, COROUTINE_TIME_SLICE);
 
 	// Allocate memory for the onboard parameters
 	onboard_parameters->param_set = malloc( sizeof(onboard_parameters_set_t) + sizeof(onboard_parameters_entry_t[config->max_param_count]) );
@@ -233,6 +395,16 @@ void onboard_parameters_init(onboard_parameters_t* onboard_parameters, const onb
 						(task_function_t)&onboard_parameters_send_scheduled_parameters, 
 						(task_argument_t)onboard_parameters, 
 						MAVLINK_MSG_ID_PARAM_VALUE);
+	
+	// Write to flash, run on request, the period only matters to the admission control
+	scheduler_add_task(	scheduler, 
+						100000, 
+						RUN_NEVER, 
+						PERIODIC_ABSOLUTE,
+						PRIORITY_LOW,
+						(task_function_t)&onboard_parameters_write_update, 
+						(task_argument_t)onboard_parameters, 
+						MAVLINK_COMMUNICATION_TASK_ID_PARAMETERS_WRITE);
 
 	// Add callbacks for onboard parameters requests
 	mavlink_message_handler_msg_callback_t callback;
@@ -453,9 +625,22 @@ mav_result_t onboard_parameters_preflight_storage(onboard_parameters_t* onboard_
 	 	// write parameters to flash
 	 	//print_util_dbg_print("No Writing to flashc\n");
 	 	print_util_dbg_print("Writing to flashc\r\n");
-	 	onboard_parameters_write_parameters_to_flashc(onboard_parameters);
+		task_entry_t* write_task = scheduler_get_task_by_id(onboard_parameters->scheduler, MAVLINK_COMMUNICATION_TASK_ID_PARAMETERS_WRITE);
 		
-		result = MAV_RESULT_ACCEPTED;
+		if (coroutine_is_running(&onboard_parameters->flash_write))
+		{
+			result = MAV_RESULT_TEMPORARILY_REJECTED;
+		}
+		else if (write_task != NULL)
+		{
+			scheduler_run_task_now(write_task);
+			result = MAV_RESULT_ACCEPTED;
+		}
+		else
+		{
+			onboard_parameters_write_parameters_to_flashc(onboard_parameters);
+			result = MAV_RESULT_ACCEPTED;
+		}
 	}
 
 	return result;
@@ -506,44 +691,10 @@ bool onboard_parameters_read_parameters_from_flashc(onboard_parameters_t* onboar
 
 void onboard_parameters_write_parameters_to_flashc(onboard_parameters_t* onboard_parameters)
 {
-	onboard_parameters_set_t* param_set = onboard_parameters->param_set;
-
-	float cksum1, cksum2;
-	cksum1 = 0;
-	cksum2 = 0;
-
-	uint8_t i;
-	size_t bytes_to_write = 0;
-	
-	nvram_data_t* nvram_array = (nvram_data_t*) MAVERIC_FLASHC_USER_PAGE_START_ADDRESS;
-	nvram_data_t local_array;
+	coroutine_reset(&onboard_parameters->flash_write);
 	
-	local_array.values[0] = param_set->param_count;
-	cksum1 += local_array.values[0];
-	cksum2 += cksum1;
-	
-	print_util_dbg_print("Begin write to flashc...\r\n");
-	
-	for (i = 1; i <= param_set->param_count; i++)
-	{
-		// local_array.values[i] = onboard_parameters_read_parameter(onboard_parameters, i-1);
-		local_array.values[i] = *(param_set->parameters[i-1].param);
-		
-		cksum1 += local_array.values[i];
-		cksum2 += cksum1;
-	}
-	local_array.values[param_set->param_count + 1] = cksum1;
-	local_array.values[param_set->param_count + 2] = cksum2;
-
-	bytes_to_write = 4 * (param_set->param_count + 3);	// (1 param_count + parameters + 2 checksums) floats
-	
-	if(bytes_to_write < MAVERIC_FLASHC_USER_PAGE_FREE_SPACE)
-	{
-		flashc_memcpy((void *)nvram_array, &local_array, bytes_to_write, true);
-		print_util_dbg_print("Write to flashc completed.\r\n");
-	}
-	else
+	while (onboard_parameters_write_update(onboard_parameters) == TASK_RUN_BLOCKED)
 	{
-		print_util_dbg_print("Attempted to write too many parameters on flash user page, aborted.\r\n");
+		;
 	}
 }
\ No newline at end of file
@@ -50,6 +50,7 @@ extern "C" {
 #include "mavlink_stream.h"
 #include "mavlink_message_handler.h"
 #include "scheduler.h"
+#include "coroutine.h"
 
 #include <stdbool.h>
 
@@ -88,6 +89,16 @@ typedef struct
 } onboard_parameters_set_t;
 
 
+/**
+ * \brief	TODO: Modify the name of this structure to make it sized as the free flash memory to store these parameters
+ */															
+typedef struct												
+{
+	//float values[MAVERIC_FLASHC_USER_PAGE_FREE_SPACE];
+	float values[MAX_ONBOARD_PARAM_COUNT + 3];					///< Number of parameters, parameters and two checksums
+} nvram_data_t;
+
+
 /**
  * \brief		Main structure of the module onboard parameters
  * 
@@ -99,6 +110,10 @@ typedef struct
 	const mavlink_stream_t* mavlink_stream;					///< Pointer to mavlink_stream
 	bool debug;												///< Indicates if debug messages should be printed for each param change
 	onboard_parameters_set_t* param_set;					///< Pointer to a set of parameters, needs memory allocation
+	scheduler_t* scheduler;									///< Pointer to the scheduler running the flash write
+	coroutine_t flash_write;								///< Write of the parameters to flash, resumed by the scheduler
+	nvram_data_t flash_data;								///< Parameters being written to flash
+	uint32_t flash_error;									///< Lock and programming errors of the flash write
 } onboard_parameters_t;											
 
 
@@ -112,16 +127,6 @@ typedef struct
 } onboard_parameters_conf_t;
 
 
-/**
- * \brief	TODO: Modify the name of this structure to make it sized as the free flash memory to store these parameters
- */															
-typedef struct												
-{
-	//float values[MAVERIC_FLASHC_USER_PAGE_FREE_SPACE];
-	float values[MAX_ONBOARD_PARAM_COUNT];
-} nvram_data_t;
-
-
 /**
 * \brief	Initialisation of the Parameter_Set structure by setting the number of onboard parameter to 0
 * 
@@ -165,6 +170,9 @@ void onboard_parameters_add_parameter_float(onboard_parameters_t* onboard_parame
 /**
  * \brief	Read/Write from/to flash depending on the parameters of the MAVLink command message
  *
+ * \details	The write is run by the scheduler over several updates, it is 
+ *			refused while the previous one is not over
+ *
  * \param   onboard_parameters		Pointer to module structure
  * \param   msg 					Incoming MAVLink message
  * 
@@ -185,6 +193,8 @@ bool onboard_parameters_read_parameters_from_flashc(onboard_parameters_t* onboar
 /**
  * \brief	Write onboard parameters to the RAM memory from the user page in the flash memory
  * 
+ * \details	Blocks until the write is over
+ * 
  * \param   onboard_parameters		Pointer to module structure
  */
 void onboard_parameters_write_parameters_to_flashc(onboard_parameters_t* onboard_parameters);
@@ -58,10 +58,11 @@
 // PUBLIC FUNCTIONS IMPLEMENTATION
 //------------------------------------------------------------------------------
 
-void state_init(state_t *state, state_t* state_config, const analog_monitor_t* analog_monitor)
+void state_init(state_t *state, state_t* state_config, const analog_monitor_t* analog_monitor, const scheduler_t* scheduler)
 {
 	// Init dependencies
 	state->analog_monitor = analog_monitor;
+	state->scheduler = scheduler;
 	
 	// Init parameters
 	state->autopilot_type = state_config->autopilot_type;
@@ -50,6 +50,7 @@ extern "C" {
 #include "stdint.h"
 #include "mav_modes.h"
 #include "analog_monitor.h"
+#include "scheduler.h"
 #include <stdbool.h>
 
 /**
@@ -100,6 +101,7 @@ typedef struct
 	uint32_t use_mode_from_remote;						///< Flag to tell whether the modes are coming from the remote or not
 	
 	const analog_monitor_t* analog_monitor;				///< The pointer to the analog monitor structure
+	const scheduler_t* scheduler;						///< The pointer to the main scheduler, for the CPU load
 } state_t;
 
 
@@ -109,8 +111,9 @@ typedef struct
  * \param	state			The pointer to the state structure
  * \param	state_config	The pointer to the state configuration structure
  * \param	analog_monitor	The pointer to the analog monitor structure
+ * \param	scheduler		The pointer to the main scheduler
  */
-void state_init(state_t *state, state_t* state_config, const analog_monitor_t* analog_monitor);
+void state_init(state_t *state, state_t* state_config, const analog_monitor_t* analog_monitor, const scheduler_t* scheduler);
 
 /**
  * \brief					Makes the switch to active mode
@@ -74,7 +74,7 @@ void state_machine_init(state_machine_t *state_machine, state_t* state, mavlink_
 task_return_t state_machine_set_mav_mode_n_state(state_machine_t* state_machine);
 
 
-void state_machine_update(state_machine_t* state_machine);
+task_return_t state_machine_update(state_machine_t* state_machine);
 
 
 #ifdef __cplusplus
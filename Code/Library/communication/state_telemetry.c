@@ -241,6 +241,7 @@ void state_telemetry_send_status(const state_t* state, const mavlink_stream_t* m
 {
 	float battery_voltage = state->analog_monitor->avg[ANALOG_RAIL_11];		// bat voltage (mV), actual battery pack plugged to the board
 	float battery_remaining = state->analog_monitor->avg[ANALOG_RAIL_10] / 12.4f * 100.0f;
+	uint16_t load = (uint16_t)(1000.0f * scheduler_get_cpu_load(state->scheduler));
 	
 	mavlink_msg_sys_status_pack(mavlink_stream->sysid,
 								mavlink_stream->compid,
@@ -248,7 +249,7 @@ void state_telemetry_send_status(const state_t* state, const mavlink_stream_t* m
 								state->sensor_present, 						// sensors present
 								state->sensor_enabled, 						// sensors enabled
 								state->sensor_health, 						// sensors health
-								0,                  									// load
+								load,                  									// load (0.1%)
 								(int32_t)(1000.0f * battery_voltage), 					// bat voltage (mV)
 								0,               										// current (mA)
 								battery_remaining,										// battery remaining
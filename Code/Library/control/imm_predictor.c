@@ -0,0 +1,333 @@
+/*******************************************************************************
+ * \file imm_predictor.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements an interacting multiple model (IMM) predictor
+ *
+ ******************************************************************************/
+
+#include <math.h>
+#include <stddef.h>
+#include "imm_predictor.h"
+#include "linear_algebra.h"
+#include "maths.h"
+
+
+// Compute the state propagation matrix of a model
+static matrix_3x3_t imm_propagation_matrix(imm_model_t model, float turn_rate, float delta_t)
+{
+    matrix_3x3_t propagation = ident_3x3;
+    float omega_t = turn_rate * delta_t;
+
+    switch(model) {
+        case IMM_MODEL_CV:
+            // The acceleration is forced to zero
+            propagation.v[0][1] = delta_t;
+            propagation.v[2][2] = 0.0f;
+            break;
+
+        case IMM_MODEL_CT:
+            // Harmonic oscillator, exp(A * dt) with A = [0 1 0; 0 0 1; 0 -w^2 0]
+            if(fabsf(omega_t) > 1.0e-3f) {
+                float s = sinf(omega_t);
+                float c = cosf(omega_t);
+
+                propagation.v[0][1] = s / turn_rate;
+                propagation.v[0][2] = (1.0f - c) / (turn_rate * turn_rate);
+                propagation.v[1][1] = c;
+                propagation.v[1][2] = s / turn_rate;
+                propagation.v[2][1] = - turn_rate * s;
+                propagation.v[2][2] = c;
+                break;
+            }
+            // Turn rate too small, same as constant acceleration
+            // no break
+
+        case IMM_MODEL_CA:
+        default:
+            propagation.v[0][1] = delta_t;
+            propagation.v[0][2] = delta_t * delta_t / 2.0f;
+            propagation.v[1][2] = delta_t;
+            break;
+    }
+
+    return propagation;
+}
+
+
+// Compute the process noise covariance matrix of a model
+static matrix_3x3_t imm_process_noise(const imm_predictor_t* imm, imm_model_t model, float delta_t)
+{
+    matrix_3x3_t process_noise = zero_3x3;
+    float dt2 = delta_t * delta_t;
+    float dt3 = dt2 * delta_t;
+
+    // Continuous white noise, so the result does not depend on the rate
+    // at which imm_predict() is called
+    if(model == IMM_MODEL_CV) {
+        process_noise.v[0][0] = imm->cv_noise * dt3 / 3.0f;
+        process_noise.v[0][1] = imm->cv_noise * dt2 / 2.0f;
+        process_noise.v[1][0] = process_noise.v[0][1];
+        process_noise.v[1][1] = imm->cv_noise * delta_t;
+    } else {
+        process_noise.v[0][0] = imm->ca_noise * dt3 * dt2 / 20.0f;
+        process_noise.v[0][1] = imm->ca_noise * dt2 * dt2 / 8.0f;
+        process_noise.v[0][2] = imm->ca_noise * dt3 / 6.0f;
+        process_noise.v[1][1] = imm->ca_noise * dt3 / 3.0f;
+        process_noise.v[1][2] = imm->ca_noise * dt2 / 2.0f;
+        process_noise.v[2][2] = imm->ca_noise * delta_t;
+        process_noise.v[1][0] = process_noise.v[0][1];
+        process_noise.v[2][0] = process_noise.v[0][2];
+        process_noise.v[2][1] = process_noise.v[1][2];
+    }
+
+    return process_noise;
+}
+
+
+// Compute the determinant of a 3x3 matrix
+static float imm_det3(const matrix_3x3_t* m)
+{
+    return m->v[0][0] * (m->v[1][1] * m->v[2][2] - m->v[1][2] * m->v[2][1])
+         - m->v[0][1] * (m->v[1][0] * m->v[2][2] - m->v[1][2] * m->v[2][0])
+         + m->v[0][2] * (m->v[1][0] * m->v[2][1] - m->v[1][1] * m->v[2][0]);
+}
+
+
+// Combine the states of all models according to their probabilities
+static void imm_combine(imm_predictor_t* imm)
+{
+    for(int axis = 0; axis < IMM_AXES; axis++) {
+        for(int i = 0; i < 3; i++) {
+            imm->estimate[axis].v[i] = 0.0f;
+
+            for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+                imm->estimate[axis].v[i] += imm->probability[model] * imm->state[axis][model].v[i];
+            }
+        }
+    }
+}
+
+
+// Mix the models for the next measurement (interaction step)
+static void imm_mix(imm_predictor_t* imm)
+{
+    float predicted_probability[IMM_MODEL_COUNT];
+    float mixing[IMM_MODEL_COUNT][IMM_MODEL_COUNT];
+
+    // c_j = sum_i p_ij * mu_i & mu_i|j = p_ij * mu_i / c_j
+    for(int j = 0; j < IMM_MODEL_COUNT; j++) {
+        predicted_probability[j] = 0.0f;
+        for(int i = 0; i < IMM_MODEL_COUNT; i++) {
+            predicted_probability[j] += imm->transition[i][j] * imm->probability[i];
+        }
+        for(int i = 0; i < IMM_MODEL_COUNT; i++) {
+            mixing[i][j] = imm->transition[i][j] * imm->probability[i] / predicted_probability[j];
+        }
+    }
+
+    for(int axis = 0; axis < IMM_AXES; axis++) {
+        vector_3_t state[IMM_MODEL_COUNT];
+        matrix_3x3_t covariance[IMM_MODEL_COUNT];
+
+        for(int j = 0; j < IMM_MODEL_COUNT; j++) {
+            // Mixed state, x0_j = sum_i mu_i|j * x_i
+            state[j] = (vector_3_t){.v = {0.0f, 0.0f, 0.0f}};
+            for(int i = 0; i < IMM_MODEL_COUNT; i++) {
+                state[j] = vadd3(state[j], svmul3(mixing[i][j], imm->state[axis][i]));
+            }
+
+            // Mixed covariance, P0_j = sum_i mu_i|j * (P_i + (x_i - x0_j) * (x_i - x0_j)^T)
+            covariance[j] = zero_3x3;
+            for(int i = 0; i < IMM_MODEL_COUNT; i++) {
+                vector_3_t spread = vsub3(imm->state[axis][i], state[j]);
+
+                covariance[j] = madd3(covariance[j],
+                                      smmul3(mixing[i][j], madd3(imm->covariance[axis][i], tp3(spread, spread))));
+            }
+        }
+
+        for(int j = 0; j < IMM_MODEL_COUNT; j++) {
+            imm->state[axis][j] = state[j];
+            imm->covariance[axis][j] = covariance[j];
+        }
+    }
+
+    for(int j = 0; j < IMM_MODEL_COUNT; j++) {
+        imm->probability[j] = predicted_probability[j];
+    }
+}
+
+
+// Initialise the IMM predictor, waiting for a first measurement
+uint8_t imm_init(
+            imm_predictor_t* imm,
+            float switch_probability,
+            float cv_noise,
+            float ca_noise,
+            float turn_rate)
+{
+    // Make sure the input is set as expected
+    if(imm == NULL) {
+        return 0;
+    }
+
+    for(int i = 0; i < IMM_MODEL_COUNT; i++) {
+        for(int j = 0; j < IMM_MODEL_COUNT; j++) {
+            imm->transition[i][j] = (i == j) ? (1.0f - switch_probability)
+                                             : switch_probability / (IMM_MODEL_COUNT - 1);
+        }
+    }
+
+    imm->cv_noise = cv_noise;
+    imm->ca_noise = ca_noise;
+    imm->turn_rate = turn_rate;
+
+    // Position & velocity are measured, the third row is unused
+    imm->design_matrix = zero_3x3;
+    imm->design_matrix.v[0][0] = 1.0f;
+    imm->design_matrix.v[1][1] = 1.0f;
+    imm->design_matrix_trans = trans3(imm->design_matrix);
+
+    imm->measurement_covariance = zero_3x3;
+    imm->measurement_covariance.v[0][0] = 0.01f;
+    imm->measurement_covariance.v[1][1] = 0.1f;
+    imm->measurement_covariance.v[2][2] = 1.0f;
+
+    imm->initialised = 0;
+
+    return 1;
+}
+
+
+// Start again from a measurement, with equal mode probabilities
+uint8_t imm_reset(imm_predictor_t* imm, const float measurement[IMM_AXES][2])
+{
+    // Make sure the input is set as expected
+    if(imm == NULL) {
+        return 0;
+    }
+
+    for(int axis = 0; axis < IMM_AXES; axis++) {
+        for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+            imm->state[axis][model].v[0] = measurement[axis][0];
+            imm->state[axis][model].v[1] = measurement[axis][1];
+            imm->state[axis][model].v[2] = 0.0f;
+
+            imm->covariance[axis][model] = zero_3x3;
+            imm->covariance[axis][model].v[0][0] = imm->measurement_covariance.v[0][0];
+            imm->covariance[axis][model].v[1][1] = imm->measurement_covariance.v[1][1];
+            imm->covariance[axis][model].v[2][2] = (model == IMM_MODEL_CV) ? 0.0f : 1.0f;
+        }
+    }
+
+    for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+        imm->probability[model] = 1.0f / IMM_MODEL_COUNT;
+    }
+
+    imm_combine(imm);
+    imm->initialised = 1;
+
+    return 1;
+}
+
+
+// Executes the prediction step of every model
+uint8_t imm_predict(imm_predictor_t* imm, float delta_t)
+{
+    // Make sure the input is set as expected
+    if(imm == NULL || !imm->initialised) {
+        return 0;
+    }
+
+    for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+        matrix_3x3_t propagation = imm_propagation_matrix(model, imm->turn_rate, delta_t);
+        matrix_3x3_t propagation_trans = trans3(propagation);
+        matrix_3x3_t process_noise = imm_process_noise(imm, model, delta_t);
+
+        for(int axis = 0; axis < IMM_AXES; axis++) {
+            // x_{k} = F * x_{k-1}
+            imm->state[axis][model] = mvmul3(propagation, imm->state[axis][model]);
+
+            // P_{k} = F * P_{k-1} * F^T + Q
+            imm->covariance[axis][model] =
+                madd3(mmul3(propagation, mmul3(imm->covariance[axis][model], propagation_trans)),
+                      process_noise);
+        }
+    }
+
+    imm_combine(imm);
+
+    return 1;
+}
+
+
+// Executes the correction step of every model
+uint8_t imm_correct(imm_predictor_t* imm, const float measurement[IMM_AXES][2])
+{
+    // Make sure the input is set as expected
+    if(imm == NULL || !imm->initialised) {
+        return 0;
+    }
+
+    float log_likelihood[IMM_MODEL_COUNT];
+    float max_log_likelihood = -INFINITY;
+
+    for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+        log_likelihood[model] = 0.0f;
+
+        for(int axis = 0; axis < IMM_AXES; axis++) {
+            vector_3_t* state = &imm->state[axis][model];
+            matrix_3x3_t* covariance = &imm->covariance[axis][model];
+            vector_3_t last_measurement = {.v = {measurement[axis][0], measurement[axis][1], 0.0f}};
+
+            // y = z - H * x
+            vector_3_t residual = vsub3(last_measurement, mvmul3(imm->design_matrix, *state));
+
+            // S = H * P * H^T + R
+            matrix_3x3_t residual_covariance =
+                madd3(mmul3(imm->design_matrix, mmul3(*covariance, imm->design_matrix_trans)),
+                      imm->measurement_covariance);
+            matrix_3x3_t residual_covariance_inv = inv3(residual_covariance);
+
+            // K = P * H^T * S^-1
+            matrix_3x3_t gain = mmul3(*covariance, mmul3(imm->design_matrix_trans, residual_covariance_inv));
+
+            // x = x + K * y & P = (I - K * H) * P
+            *state = vadd3(*state, mvmul3(gain, residual));
+            *covariance = mmul3(msub3(ident_3x3, mmul3(gain, imm->design_matrix)), *covariance);
+
+            // Gaussian likelihood of the residual, without the constant term
+            log_likelihood[model] -= 0.5f * (sp3(residual, mvmul3(residual_covariance_inv, residual))
+                                             + logf(imm_det3(&residual_covariance)));
+        }
+
+        if(log_likelihood[model] > max_log_likelihood) {
+            max_log_likelihood = log_likelihood[model];
+        }
+    }
+
+    // mu_j = c_j * L_j / sum(c_i * L_i)
+    float sum = 0.0f;
+    for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+        imm->probability[model] *= expf(log_likelihood[model] - max_log_likelihood);
+        sum += imm->probability[model];
+    }
+    for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+        imm->probability[model] = maths_f_max(imm->probability[model] / sum, IMM_MIN_PROBABILITY);
+    }
+
+    sum = 0.0f;
+    for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+        sum += imm->probability[model];
+    }
+    for(int model = 0; model < IMM_MODEL_COUNT; model++) {
+        imm->probability[model] /= sum;
+    }
+
+    imm_mix(imm);
+    imm_combine(imm);
+
+    return 1;
+}
@@ -0,0 +1,141 @@
+/*******************************************************************************
+ * \file imm_predictor.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements an interacting multiple model (IMM) predictor
+ *
+ * Three motion models run in parallel on each axis and are mixed according
+ * to a Markov switching matrix:
+ *  - constant velocity (CV), for straight flight
+ *  - constant acceleration (CA), same structure as kalman_predictor.c
+ *  - coordinated turn (CT), with a known turn rate omega. In a turn each
+ *    horizontal axis oscillates at omega, so the model is written per axis
+ *    as a harmonic oscillator (jerk = -omega^2 * velocity), which keeps the
+ *    (position, velocity, acceleration) state of the other models.
+ *
+ * The mode probabilities are shared by all axes, the likelihoods of the
+ * three axes are multiplied together.
+ *
+ ******************************************************************************/
+
+#ifndef IMM_PREDICTOR_H
+#define IMM_PREDICTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "small_matrix.h"
+
+#define IMM_MODEL_COUNT 3           ///< Number of motion models
+#define IMM_AXES 3                  ///< Models are filtered independently along x, y and z
+#define IMM_MIN_PROBABILITY 1.0e-3f ///< Lower bound of a mode probability, so no model is lost
+
+
+/**
+ * \brief   Motion models of the IMM predictor
+ */
+typedef enum {
+    IMM_MODEL_CV = 0,               ///< Constant velocity
+    IMM_MODEL_CA = 1,               ///< Constant acceleration
+    IMM_MODEL_CT = 2,               ///< Coordinated turn
+} imm_model_t;
+
+
+/**
+ * \brief   Structure that contains the IMM predictor
+ *
+ * \param   state                   State (position, velocity, acceleration)
+ *                                    of each model along each axis
+ * \param   covariance              State covariance of each model along
+ *                                    each axis
+ * \param   probability             Probability of each model
+ * \param   transition              Markov switching matrix between two
+ *                                    measurements, transition[i][j] is the
+ *                                    probability to switch from model i to j
+ * \param   estimate                Combined state along each axis
+ * \param   design_matrix           Maps the state space to the measurement
+ *                                    space (position & velocity are measured)
+ * \param   design_matrix_trans     Transpose of the design matrix
+ * \param   measurement_covariance  Measurement covariance matrix
+ * \param   cv_noise                Spectral density of the acceleration
+ *                                    noise of the CV model (m^2/s^3)
+ * \param   ca_noise                Spectral density of the jerk noise of the
+ *                                    CA and CT models (m^2/s^5)
+ * \param   turn_rate               Turn rate of the CT model (rad/s)
+ * \param   initialised             Whether a first measurement was received
+ */
+typedef struct imm_predictor_t {
+    vector_3_t state[IMM_AXES][IMM_MODEL_COUNT];
+    matrix_3x3_t covariance[IMM_AXES][IMM_MODEL_COUNT];
+    float probability[IMM_MODEL_COUNT];
+    float transition[IMM_MODEL_COUNT][IMM_MODEL_COUNT];
+    vector_3_t estimate[IMM_AXES];
+    matrix_3x3_t design_matrix;
+    matrix_3x3_t design_matrix_trans;
+    matrix_3x3_t measurement_covariance;
+    float cv_noise;
+    float ca_noise;
+    float turn_rate;
+    uint8_t initialised;
+} imm_predictor_t;
+
+
+/**
+ * \brief   Initialise the IMM predictor, waiting for a first measurement
+ *
+ * \param   imm                     Pointer to the IMM predictor
+ * \param   switch_probability      Probability to leave a model between two
+ *                                    measurements
+ * \param   cv_noise                Spectral density of the acceleration
+ *                                    noise of the CV model (m^2/s^3)
+ * \param   ca_noise                Spectral density of the jerk noise of the
+ *                                    CA and CT models (m^2/s^5)
+ * \param   turn_rate               Turn rate of the CT model (rad/s)
+ */
+uint8_t imm_init(
+            imm_predictor_t* imm,
+            float switch_probability,
+            float cv_noise,
+            float ca_noise,
+            float turn_rate);
+
+
+/**
+ * \brief   Start again from a measurement, with equal mode probabilities
+ *
+ * \param   imm                     Pointer to the IMM predictor
+ * \param   measurement             Measurement, indexed [axis][component]
+ *                                    (position, velocity)
+ */
+uint8_t imm_reset(imm_predictor_t* imm, const float measurement[IMM_AXES][2]);
+
+
+/**
+ * \brief   Executes the prediction step of every model and updates the
+ *            combined estimate
+ *
+ * \param   imm                     Pointer to the IMM predictor
+ * \param   delta_t                 Integration time
+ */
+uint8_t imm_predict(imm_predictor_t* imm, float delta_t);
+
+
+/**
+ * \brief   Executes the correction step of every model, updates the mode
+ *            probabilities and mixes the models for the next measurement
+ *
+ * \param   imm                     Pointer to the IMM predictor
+ * \param   measurement             Measurement, indexed [axis][component]
+ *                                    (position, velocity)
+ */
+uint8_t imm_correct(imm_predictor_t* imm, const float measurement[IMM_AXES][2]);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
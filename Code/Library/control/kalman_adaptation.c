@@ -0,0 +1,140 @@
+/*******************************************************************************
+ * \file kalman_adaptation.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements an innovation-based adaptive estimation of the
+ *        process & measurement noise of the Kalman predictor
+ *
+ ******************************************************************************/
+
+#include "kalman_adaptation.h"
+#include "maths.h"
+
+
+// Move an estimate towards its target, up by at most KALMAN_ADAPTATION_RATE
+// and down by at most KALMAN_ADAPTATION_TIGHTEN_RATE
+static float kalman_adaptation_step(float estimate, float target, float min_value, float max_value)
+{
+    float ratio = target / estimate;
+
+    ratio = maths_f_min(maths_f_max(ratio, 1.0f / (1.0f + KALMAN_ADAPTATION_TIGHTEN_RATE)), 1.0f + KALMAN_ADAPTATION_RATE);
+
+    return maths_f_min(maths_f_max(estimate * ratio, min_value), max_value);
+}
+
+
+// Take an estimate over once it moved far enough from the value in use
+static uint8_t kalman_adaptation_apply(float* value, float estimate, int32_t enabled)
+{
+    if(enabled && maths_f_abs(estimate - *value) <= KALMAN_ADAPTATION_HYSTERESIS * *value) {
+        return 0;
+    }
+
+    if(estimate == *value) {
+        return 0;
+    }
+
+    *value = estimate;
+
+    return 1;
+}
+
+
+// Initialise the adaptive estimation with an empty window
+uint8_t kalman_adaptation_init(
+            kalman_adaptation_t* adaptation,
+            float max_acc,
+            float position_variance,
+            float velocity_variance)
+{
+    // Make sure the input is set as expected
+    if(adaptation == NULL) {
+        return 0;
+    }
+
+    adaptation->enabled = 1;
+
+    adaptation->max_acc = max_acc;
+    adaptation->position_variance = position_variance;
+    adaptation->velocity_variance = velocity_variance;
+    adaptation->max_acc_estimate = max_acc;
+    adaptation->position_variance_estimate = position_variance;
+    adaptation->velocity_variance_estimate = velocity_variance;
+    adaptation->normalised_innovation = 1.0f;
+
+    adaptation->count = 0;
+    adaptation->head = KALMAN_ADAPTATION_WINDOW - 1;
+    adaptation->sum_normalised = 0.0f;
+    adaptation->sum_position = 0.0f;
+    adaptation->sum_velocity = 0.0f;
+
+    return 1;
+}
+
+
+// Add an accepted innovation to the window and update the estimates
+uint8_t kalman_adaptation_update(
+            kalman_adaptation_t* adaptation,
+            float normalised_innovation,
+            float position_excess,
+            float velocity_excess)
+{
+    uint8_t changed = 0;
+
+    // Make sure the input is set as expected
+    if(adaptation == NULL) {
+        return 0;
+    }
+
+    if(adaptation->enabled) {
+        uint8_t slot = (adaptation->head + 1) % KALMAN_ADAPTATION_WINDOW;
+
+        // The oldest innovation leaves the window
+        if(adaptation->count == KALMAN_ADAPTATION_WINDOW) {
+            adaptation->sum_normalised -= adaptation->sample_normalised[slot];
+            adaptation->sum_position -= adaptation->sample_position[slot];
+            adaptation->sum_velocity -= adaptation->sample_velocity[slot];
+        } else {
+            adaptation->count++;
+        }
+
+        adaptation->sample_normalised[slot] = normalised_innovation;
+        adaptation->sample_position[slot] = position_excess;
+        adaptation->sample_velocity[slot] = velocity_excess;
+        adaptation->sum_normalised += normalised_innovation;
+        adaptation->sum_position += position_excess;
+        adaptation->sum_velocity += velocity_excess;
+        adaptation->head = slot;
+
+        adaptation->normalised_innovation = adaptation->sum_normalised / adaptation->count;
+
+        // Only match the covariances over a full window
+        if(adaptation->count == KALMAN_ADAPTATION_WINDOW) {
+            // Q scales with max_acc^2
+            adaptation->max_acc_estimate =
+                kalman_adaptation_step(adaptation->max_acc_estimate,
+                                       adaptation->max_acc_estimate * maths_fast_sqrt(adaptation->normalised_innovation),
+                                       KALMAN_ADAPTATION_MIN_MAX_ACC,
+                                       KALMAN_ADAPTATION_MAX_MAX_ACC);
+
+            // R = E[y y^T] - H P H^T
+            adaptation->position_variance_estimate =
+                kalman_adaptation_step(adaptation->position_variance_estimate,
+                                       maths_f_max(adaptation->sum_position / KALMAN_ADAPTATION_WINDOW, KALMAN_ADAPTATION_MIN_VARIANCE),
+                                       KALMAN_ADAPTATION_MIN_VARIANCE,
+                                       KALMAN_ADAPTATION_MAX_VARIANCE);
+            adaptation->velocity_variance_estimate =
+                kalman_adaptation_step(adaptation->velocity_variance_estimate,
+                                       maths_f_max(adaptation->sum_velocity / KALMAN_ADAPTATION_WINDOW, KALMAN_ADAPTATION_MIN_VARIANCE),
+                                       KALMAN_ADAPTATION_MIN_VARIANCE,
+                                       KALMAN_ADAPTATION_MAX_VARIANCE);
+        }
+    }
+
+    changed |= kalman_adaptation_apply(&adaptation->max_acc, adaptation->max_acc_estimate, adaptation->enabled);
+    changed |= kalman_adaptation_apply(&adaptation->position_variance, adaptation->position_variance_estimate, adaptation->enabled);
+    changed |= kalman_adaptation_apply(&adaptation->velocity_variance, adaptation->velocity_variance_estimate, adaptation->enabled);
+
+    return changed;
+}
@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * \file kalman_adaptation.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements an innovation-based adaptive estimation of the
+ *        process & measurement noise of the Kalman predictor
+ *
+ * The statistics of the last KALMAN_ADAPTATION_WINDOW accepted innovations
+ * are matched with their predicted covariance (covariance matching):
+ *  - the position & velocity measurement variances are the mean squared
+ *    innovations minus the predicted state variances, E[y y^T] - H P H^T
+ *  - the maximal acceleration, which scales the process noise, follows the
+ *    mean normalised innovation squared y^T S^-1 y / m of the position &
+ *    velocity, which is 1 when the noise is well tuned: above 1 the target
+ *    is more aggressive than the model, below 1 it is smoother.
+ *
+ * The estimates grow by at most KALMAN_ADAPTATION_RATE per innovation and
+ * shrink by at most KALMAN_ADAPTATION_TIGHTEN_RATE, so the model opens up
+ * at the start of a manoeuvre faster than it tightens after it. They stay
+ * within fixed bounds. The values used by the predictor only follow
+ * the estimates once they moved by more than KALMAN_ADAPTATION_HYSTERESIS,
+ * which keeps the steady-state gain cache valid in between.
+ *
+ ******************************************************************************/
+
+#ifndef KALMAN_ADAPTATION_H
+#define KALMAN_ADAPTATION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define KALMAN_ADAPTATION_WINDOW 16                 ///< Number of innovations in the window
+#define KALMAN_ADAPTATION_RATE 0.05f                ///< Maximal relative increase of an estimate per innovation
+#define KALMAN_ADAPTATION_TIGHTEN_RATE 0.0125f      ///< Maximal relative decrease of an estimate per innovation
+#define KALMAN_ADAPTATION_HYSTERESIS 0.25f          ///< Relative change of an estimate before it is used by the predictor
+#define KALMAN_ADAPTATION_MIN_MAX_ACC 1.0f          ///< Lower bound of the maximal acceleration (m/s^2)
+#define KALMAN_ADAPTATION_MAX_MAX_ACC 20.0f         ///< Upper bound of the maximal acceleration (m/s^2)
+#define KALMAN_ADAPTATION_MIN_VARIANCE 1.0e-3f      ///< Lower bound of a measurement variance
+#define KALMAN_ADAPTATION_MAX_VARIANCE 25.0f        ///< Upper bound of a measurement variance
+
+
+/**
+ * \brief   Structure that contains the adaptive noise estimation
+ *
+ * \param   enabled                 Whether the estimates follow the innovations,
+ *                                    otherwise the estimates are used as set
+ * \param   max_acc                 Maximal acceleration used by the predictor
+ * \param   position_variance       Position measurement variance used by the
+ *                                    predictor
+ * \param   velocity_variance       Velocity measurement variance used by the
+ *                                    predictor
+ * \param   max_acc_estimate        Estimated maximal acceleration (m/s^2)
+ * \param   position_variance_estimate  Estimated position measurement
+ *                                    variance (m^2)
+ * \param   velocity_variance_estimate  Estimated velocity measurement
+ *                                    variance (m^2/s^2)
+ * \param   normalised_innovation   Mean normalised innovation squared over
+ *                                    the window
+ * \param   count                   Number of innovations in the window
+ * \param   head                    Index of the newest innovation
+ * \param   sample_normalised       Normalised innovation squared of each
+ *                                    innovation
+ * \param   sample_position         Squared position innovation minus the
+ *                                    predicted position variance
+ * \param   sample_velocity         Squared velocity innovation minus the
+ *                                    predicted velocity variance
+ * \param   sum_normalised          Sum of sample_normalised over the window
+ * \param   sum_position            Sum of sample_position over the window
+ * \param   sum_velocity            Sum of sample_velocity over the window
+ */
+typedef struct kalman_adaptation_t {
+    int32_t enabled;
+    float max_acc;
+    float position_variance;
+    float velocity_variance;
+    float max_acc_estimate;
+    float position_variance_estimate;
+    float velocity_variance_estimate;
+    float normalised_innovation;
+    uint8_t count;
+    uint8_t head;
+    float sample_normalised[KALMAN_ADAPTATION_WINDOW];
+    float sample_position[KALMAN_ADAPTATION_WINDOW];
+    float sample_velocity[KALMAN_ADAPTATION_WINDOW];
+    float sum_normalised;
+    float sum_position;
+    float sum_velocity;
+} kalman_adaptation_t;
+
+
+/**
+ * \brief   Initialise the adaptive estimation with an empty window
+ *
+ * \param   adaptation              Pointer to the adaptive estimation
+ * \param   max_acc                 Initial maximal acceleration (m/s^2)
+ * \param   position_variance       Initial position measurement variance
+ * \param   velocity_variance       Initial velocity measurement variance
+ */
+uint8_t kalman_adaptation_init(
+            kalman_adaptation_t* adaptation,
+            float max_acc,
+            float position_variance,
+            float velocity_variance);
+
+
+/**
+ * \brief   Add an accepted innovation to the window and update the estimates
+ *
+ * \param   adaptation              Pointer to the adaptive estimation
+ * \param   normalised_innovation   y^T * S^-1 * y divided by the dimension of y
+ * \param   position_excess         Squared position innovation minus the
+ *                                    predicted position variance (H P H^T)
+ * \param   velocity_excess         Squared velocity innovation minus the
+ *                                    predicted velocity variance (H P H^T)
+ *
+ * \return  1 if the values used by the predictor changed, 0 otherwise
+ */
+uint8_t kalman_adaptation_update(
+            kalman_adaptation_t* adaptation,
+            float normalised_innovation,
+            float position_excess,
+            float velocity_excess);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,663 @@
+/*******************************************************************************
+ * \file kalman_batch_predictor.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements a batched Kalman predictor that tracks every
+ *        neighbor at once
+ *
+ ******************************************************************************/
+
+#include "kalman_batch_predictor.h"
+#include "kalman_predictor.h"
+#include "maths.h"
+#include <math.h>
+
+
+// Copy one track into a standalone Kalman handler
+static void kalman_batch_gather(
+            const kalman_batch_t* kalman_batch,
+            uint8_t axis,
+            uint8_t track,
+            kalman_handler_t* kalman_handler)
+{
+    kalman_handler->state_estimate.v[0] = kalman_batch->pos[axis][track];
+    kalman_handler->state_estimate.v[1] = kalman_batch->vel[axis][track];
+    kalman_handler->state_estimate.v[2] = kalman_batch->acc[axis][track];
+
+    kalman_handler->state_estimate_covariance.v[0][0] = kalman_batch->p_pp[axis][track];
+    kalman_handler->state_estimate_covariance.v[0][1] = kalman_batch->p_pv[axis][track];
+    kalman_handler->state_estimate_covariance.v[0][2] = kalman_batch->p_pa[axis][track];
+    kalman_handler->state_estimate_covariance.v[1][0] = kalman_batch->p_pv[axis][track];
+    kalman_handler->state_estimate_covariance.v[1][1] = kalman_batch->p_vv[axis][track];
+    kalman_handler->state_estimate_covariance.v[1][2] = kalman_batch->p_va[axis][track];
+    kalman_handler->state_estimate_covariance.v[2][0] = kalman_batch->p_pa[axis][track];
+    kalman_handler->state_estimate_covariance.v[2][1] = kalman_batch->p_va[axis][track];
+    kalman_handler->state_estimate_covariance.v[2][2] = kalman_batch->p_aa[axis][track];
+
+    kalman_handler->design_matrix = kalman_batch->design_matrix;
+    kalman_handler->design_matrix_trans = kalman_batch->design_matrix_trans;
+    kalman_handler->measurement_covariance = kalman_batch->measurement_covariance;
+}
+
+
+// Copy a standalone Kalman handler back into one track
+static void kalman_batch_scatter(
+            kalman_batch_t* kalman_batch,
+            uint8_t axis,
+            uint8_t track,
+            const kalman_handler_t* kalman_handler)
+{
+    kalman_batch->pos[axis][track] = kalman_handler->state_estimate.v[0];
+    kalman_batch->vel[axis][track] = kalman_handler->state_estimate.v[1];
+    kalman_batch->acc[axis][track] = kalman_handler->state_estimate.v[2];
+
+    // (I - K * H) * P is only symmetric up to rounding, keep the upper triangle
+    kalman_batch->p_pp[axis][track] = kalman_handler->state_estimate_covariance.v[0][0];
+    kalman_batch->p_pv[axis][track] = kalman_handler->state_estimate_covariance.v[0][1];
+    kalman_batch->p_pa[axis][track] = kalman_handler->state_estimate_covariance.v[0][2];
+    kalman_batch->p_vv[axis][track] = kalman_handler->state_estimate_covariance.v[1][1];
+    kalman_batch->p_va[axis][track] = kalman_handler->state_estimate_covariance.v[1][2];
+    kalman_batch->p_aa[axis][track] = kalman_handler->state_estimate_covariance.v[2][2];
+}
+
+
+// Copy one track of a snapshot into a standalone Kalman handler
+static void kalman_batch_load_snapshot(
+            const kalman_batch_t* kalman_batch,
+            uint8_t snapshot,
+            uint8_t axis,
+            uint8_t track,
+            kalman_handler_t* kalman_handler)
+{
+    const float (*state)[KALMAN_BATCH_MAX_TRACKS] = kalman_batch->history_state[snapshot][axis];
+    const float (*covariance)[KALMAN_BATCH_MAX_TRACKS] = kalman_batch->history_covariance[snapshot][axis];
+
+    for(int i = 0; i < 3; i++) {
+        kalman_handler->state_estimate.v[i] = state[i][track];
+    }
+
+    kalman_handler->state_estimate_covariance.v[0][0] = covariance[0][track];
+    kalman_handler->state_estimate_covariance.v[0][1] = covariance[1][track];
+    kalman_handler->state_estimate_covariance.v[0][2] = covariance[2][track];
+    kalman_handler->state_estimate_covariance.v[1][0] = covariance[1][track];
+    kalman_handler->state_estimate_covariance.v[1][1] = covariance[3][track];
+    kalman_handler->state_estimate_covariance.v[1][2] = covariance[4][track];
+    kalman_handler->state_estimate_covariance.v[2][0] = covariance[2][track];
+    kalman_handler->state_estimate_covariance.v[2][1] = covariance[4][track];
+    kalman_handler->state_estimate_covariance.v[2][2] = covariance[5][track];
+
+    kalman_handler->design_matrix = kalman_batch->design_matrix;
+    kalman_handler->design_matrix_trans = kalman_batch->design_matrix_trans;
+    kalman_handler->measurement_covariance = kalman_batch->measurement_covariance;
+}
+
+
+// Copy a standalone Kalman handler back into one track of a snapshot
+static void kalman_batch_save_snapshot(
+            kalman_batch_t* kalman_batch,
+            uint8_t snapshot,
+            uint8_t axis,
+            uint8_t track,
+            const kalman_handler_t* kalman_handler)
+{
+    float (*state)[KALMAN_BATCH_MAX_TRACKS] = kalman_batch->history_state[snapshot][axis];
+    float (*covariance)[KALMAN_BATCH_MAX_TRACKS] = kalman_batch->history_covariance[snapshot][axis];
+
+    for(int i = 0; i < 3; i++) {
+        state[i][track] = kalman_handler->state_estimate.v[i];
+    }
+
+    covariance[0][track] = kalman_handler->state_estimate_covariance.v[0][0];
+    covariance[1][track] = kalman_handler->state_estimate_covariance.v[0][1];
+    covariance[2][track] = kalman_handler->state_estimate_covariance.v[0][2];
+    covariance[3][track] = kalman_handler->state_estimate_covariance.v[1][1];
+    covariance[4][track] = kalman_handler->state_estimate_covariance.v[1][2];
+    covariance[5][track] = kalman_handler->state_estimate_covariance.v[2][2];
+}
+
+
+// Copy the current estimates of one track into a snapshot
+static void kalman_batch_copy_to_snapshot(kalman_batch_t* kalman_batch, uint8_t snapshot, uint8_t track)
+{
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        float (*state)[KALMAN_BATCH_MAX_TRACKS] = kalman_batch->history_state[snapshot][axis];
+        float (*covariance)[KALMAN_BATCH_MAX_TRACKS] = kalman_batch->history_covariance[snapshot][axis];
+
+        state[0][track] = kalman_batch->pos[axis][track];
+        state[1][track] = kalman_batch->vel[axis][track];
+        state[2][track] = kalman_batch->acc[axis][track];
+
+        covariance[0][track] = kalman_batch->p_pp[axis][track];
+        covariance[1][track] = kalman_batch->p_pv[axis][track];
+        covariance[2][track] = kalman_batch->p_pa[axis][track];
+        covariance[3][track] = kalman_batch->p_vv[axis][track];
+        covariance[4][track] = kalman_batch->p_va[axis][track];
+        covariance[5][track] = kalman_batch->p_aa[axis][track];
+    }
+}
+
+
+// Find the most recent snapshot taken at or before a given time, -1 if none
+static int16_t kalman_batch_find_snapshot(const kalman_batch_t* kalman_batch, uint32_t time_ms)
+{
+    for(uint8_t age = 0; age < kalman_batch->history_count; age++) {
+        uint8_t snapshot = (kalman_batch->history_head + KALMAN_BATCH_HISTORY_SIZE - age) % KALMAN_BATCH_HISTORY_SIZE;
+
+        if((int32_t)(time_ms - kalman_batch->history_time[snapshot]) >= 0) {
+            return snapshot;
+        }
+    }
+
+    return -1;
+}
+
+
+// Initialise the batched Kalman predictor with no active track
+uint8_t kalman_batch_init(kalman_batch_t* kalman_batch)
+{
+    // Make sure the input is set as expected
+    if(kalman_batch == NULL) {
+        return 0;
+    }
+
+    // Share the design & measurement covariance matrices of the single
+    // target predictor
+    kalman_handler_t kalman_handler;
+    kalman_init(&kalman_handler, 0.0f, 0.0f);
+    kalman_batch->design_matrix = kalman_handler.design_matrix;
+    kalman_batch->design_matrix_trans = kalman_handler.design_matrix_trans;
+    kalman_batch->measurement_covariance = kalman_handler.measurement_covariance;
+
+    kalman_gain_cache_init(&kalman_batch->gain_cache);
+
+    kalman_batch->gate_threshold = KALMAN_BATCH_GATE_THRESHOLD;
+    kalman_batch->gate_max_rejections = KALMAN_BATCH_GATE_MAX_REJECTIONS;
+
+    kalman_adaptation_init(&kalman_batch->adaptation,
+                           KALMAN_BATCH_MAX_ACC,
+                           kalman_batch->measurement_covariance.v[0][0],
+                           kalman_batch->measurement_covariance.v[1][1]);
+
+    return kalman_batch_reset(kalman_batch);
+}
+
+
+// Drop every track & the history, the gate settings and the adapted noise are kept
+uint8_t kalman_batch_reset(kalman_batch_t* kalman_batch)
+{
+    // Make sure the input is set as expected
+    if(kalman_batch == NULL) {
+        return 0;
+    }
+
+    kalman_batch->track_count = 0;
+
+    kalman_batch->time_ms = 0;
+    kalman_batch->history_count = 0;
+    kalman_batch->history_head = KALMAN_BATCH_HISTORY_SIZE - 1;
+
+    return 1;
+}
+
+
+// Find the track that follows a neighbor
+int16_t kalman_batch_find_track(const kalman_batch_t* kalman_batch, uint8_t neighbor_ID)
+{
+    for(int16_t track = 0; track < kalman_batch->track_count; track++) {
+        if(kalman_batch->neighbor_ID[track] == neighbor_ID) {
+            return track;
+        }
+    }
+
+    return -1;
+}
+
+
+// Start a new track, seeded with a first measurement
+int16_t kalman_batch_add_track(
+            kalman_batch_t* kalman_batch,
+            uint8_t neighbor_ID,
+            const float measurement[KALMAN_BATCH_AXES][3],
+            float max_acc,
+            uint32_t time_ms,
+            uint32_t capture_time_ms)
+{
+    if(kalman_batch->track_count >= KALMAN_BATCH_MAX_TRACKS) {
+        return -1;
+    }
+
+    // Future measurements start at the current time
+    if((int32_t)(kalman_batch->time_ms - capture_time_ms) < 0) {
+        capture_time_ms = kalman_batch->time_ms;
+    }
+
+    uint8_t track = kalman_batch->track_count;
+    kalman_batch->track_count++;
+
+    kalman_batch->neighbor_ID[track] = neighbor_ID;
+    kalman_batch->last_measurement_time[track] = time_ms;
+    kalman_batch->last_capture_time[track] = capture_time_ms;
+    kalman_batch->gain_converged[track] = 0;
+    kalman_batch->correction_count[track] = 0;
+    kalman_batch->rejection_count[track] = 0;
+    kalman_batch->consecutive_rejections[track] = 0;
+
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        // Start from the measured position & velocity
+        kalman_batch->pos[axis][track] = measurement[axis][0];
+        kalman_batch->vel[axis][track] = measurement[axis][1];
+        kalman_batch->acc[axis][track] = 0.0f;
+
+        kalman_batch->p_pp[axis][track] = 0.0f;
+        kalman_batch->p_pv[axis][track] = 0.0f;
+        kalman_batch->p_pa[axis][track] = 0.0f;
+        kalman_batch->p_vv[axis][track] = 0.0f;
+        kalman_batch->p_va[axis][track] = 0.0f;
+        kalman_batch->p_aa[axis][track] = 0.0f;
+
+        for(int i = 0; i < 3; i++) {
+            kalman_batch->last_measurement[axis][i][track] = measurement[axis][i];
+        }
+
+        polynomial_fit_init(&kalman_batch->acceleration_fit[axis][track]);
+    }
+
+    // Nothing is known before the first measurement, seed the whole history
+    for(uint8_t snapshot = 0; snapshot < KALMAN_BATCH_HISTORY_SIZE; snapshot++) {
+        kalman_batch_copy_to_snapshot(kalman_batch, snapshot, track);
+    }
+
+    // Up to the current time
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        kalman_handler_t kalman_handler;
+
+        kalman_batch_gather(kalman_batch, axis, track, &kalman_handler);
+        kalman_predict(&kalman_handler, max_acc, (kalman_batch->time_ms - capture_time_ms) / 1000.0f);
+        kalman_batch_scatter(kalman_batch, axis, track, &kalman_handler);
+    }
+
+    return track;
+}
+
+
+// Drop a track (the last track is moved into its slot)
+void kalman_batch_remove_track(kalman_batch_t* kalman_batch, uint8_t track)
+{
+    if(track >= kalman_batch->track_count) {
+        return;
+    }
+
+    uint8_t last = kalman_batch->track_count - 1;
+
+    kalman_batch->neighbor_ID[track] = kalman_batch->neighbor_ID[last];
+    kalman_batch->last_measurement_time[track] = kalman_batch->last_measurement_time[last];
+    kalman_batch->last_capture_time[track] = kalman_batch->last_capture_time[last];
+    kalman_batch->gain_converged[track] = kalman_batch->gain_converged[last];
+    kalman_batch->correction_count[track] = kalman_batch->correction_count[last];
+    kalman_batch->rejection_count[track] = kalman_batch->rejection_count[last];
+    kalman_batch->consecutive_rejections[track] = kalman_batch->consecutive_rejections[last];
+
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        kalman_batch->pos[axis][track] = kalman_batch->pos[axis][last];
+        kalman_batch->vel[axis][track] = kalman_batch->vel[axis][last];
+        kalman_batch->acc[axis][track] = kalman_batch->acc[axis][last];
+
+        kalman_batch->p_pp[axis][track] = kalman_batch->p_pp[axis][last];
+        kalman_batch->p_pv[axis][track] = kalman_batch->p_pv[axis][last];
+        kalman_batch->p_pa[axis][track] = kalman_batch->p_pa[axis][last];
+        kalman_batch->p_vv[axis][track] = kalman_batch->p_vv[axis][last];
+        kalman_batch->p_va[axis][track] = kalman_batch->p_va[axis][last];
+        kalman_batch->p_aa[axis][track] = kalman_batch->p_aa[axis][last];
+
+        for(int i = 0; i < 3; i++) {
+            kalman_batch->last_measurement[axis][i][track] =
+                kalman_batch->last_measurement[axis][i][last];
+        }
+
+        kalman_batch->acceleration_fit[axis][track] = kalman_batch->acceleration_fit[axis][last];
+
+        for(uint8_t snapshot = 0; snapshot < KALMAN_BATCH_HISTORY_SIZE; snapshot++) {
+            for(int i = 0; i < 3; i++) {
+                kalman_batch->history_state[snapshot][axis][i][track] =
+                    kalman_batch->history_state[snapshot][axis][i][last];
+            }
+            for(int i = 0; i < 6; i++) {
+                kalman_batch->history_covariance[snapshot][axis][i][track] =
+                    kalman_batch->history_covariance[snapshot][axis][i][last];
+            }
+        }
+    }
+
+    kalman_batch->track_count--;
+}
+
+
+// Drop every track that did not receive a measurement for a while
+void kalman_batch_remove_stale_tracks(kalman_batch_t* kalman_batch, uint32_t time_ms)
+{
+    int16_t track = 0;
+
+    while(track < kalman_batch->track_count) {
+        if((time_ms - kalman_batch->last_measurement_time[track]) > KALMAN_BATCH_TRACK_TIMEOUT_MS) {
+            // The last track takes this slot, check the same index again
+            kalman_batch_remove_track(kalman_batch, track);
+        } else {
+            track++;
+        }
+    }
+}
+
+
+// Executes the prediction step for all active tracks
+uint8_t kalman_batch_predict(kalman_batch_t* kalman_batch, float max_acc, float delta_t)
+{
+    // Make sure the input is set as expected
+    if(kalman_batch == NULL) {
+        return 0;
+    }
+
+    const uint8_t n = kalman_batch->track_count;
+
+    // Propagation terms are identical for every track
+    const kalman_propagation_t propagation = kalman_compute_propagation(max_acc, delta_t);
+
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        float* pos = kalman_batch->pos[axis];
+        float* vel = kalman_batch->vel[axis];
+        const float* acc = kalman_batch->acc[axis];
+        float* p_pp = kalman_batch->p_pp[axis];
+        float* p_pv = kalman_batch->p_pv[axis];
+        float* p_pa = kalman_batch->p_pa[axis];
+        float* p_vv = kalman_batch->p_vv[axis];
+        float* p_va = kalman_batch->p_va[axis];
+        float* p_aa = kalman_batch->p_aa[axis];
+
+        for(uint8_t track = 0; track < n; track++) {
+            // Predict state estimate, x_{k} = F * x_{k-1}
+            pos[track] += propagation.delta_t * vel[track] + propagation.half_dt2 * acc[track];
+            vel[track] += propagation.delta_t * acc[track];
+
+            // Predict state estimate covariance, P_{k} = F * P_{k-1} * F^T + Q
+            kalman_packed_covariance_t covariance =
+                {.pp = p_pp[track], .pv = p_pv[track], .pa = p_pa[track],
+                                    .vv = p_vv[track], .va = p_va[track],
+                                                       .aa = p_aa[track]};
+            kalman_propagate_packed_covariance(&propagation, &covariance);
+
+            p_pp[track] = covariance.pp;
+            p_pv[track] = covariance.pv;
+            p_pa[track] = covariance.pa;
+            p_vv[track] = covariance.vv;
+            p_va[track] = covariance.va;
+            p_aa[track] = covariance.aa;
+        }
+    }
+
+    return 1;
+}
+
+
+// Set the time of the current estimates and save a snapshot of all tracks
+void kalman_batch_record_history(kalman_batch_t* kalman_batch, uint32_t time_ms)
+{
+    kalman_batch->time_ms = time_ms;
+
+    if(kalman_batch->history_count > 0 &&
+       (time_ms - kalman_batch->history_time[kalman_batch->history_head]) < KALMAN_BATCH_HISTORY_PERIOD_MS) {
+        return;
+    }
+
+    // Overwrite the oldest snapshot
+    kalman_batch->history_head = (kalman_batch->history_head + 1) % KALMAN_BATCH_HISTORY_SIZE;
+    if(kalman_batch->history_count < KALMAN_BATCH_HISTORY_SIZE) {
+        kalman_batch->history_count++;
+    }
+
+    kalman_batch->history_time[kalman_batch->history_head] = time_ms;
+    for(uint8_t track = 0; track < kalman_batch->track_count; track++) {
+        kalman_batch_copy_to_snapshot(kalman_batch, kalman_batch->history_head, track);
+    }
+}
+
+
+// Add a measurement to the fits of a track and fill in the measured acceleration
+uint8_t kalman_batch_fit_acceleration(
+            kalman_batch_t* kalman_batch,
+            uint8_t track,
+            float measurement[KALMAN_BATCH_AXES][3],
+            float acceleration_variance[KALMAN_BATCH_AXES],
+            uint32_t capture_time_ms)
+{
+    uint8_t fitted = 1;
+
+    // Make sure the input is set as expected
+    if(kalman_batch == NULL || track >= kalman_batch->track_count) {
+        return 0;
+    }
+
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        polynomial_fit_t* fit = &kalman_batch->acceleration_fit[axis][track];
+
+        polynomial_fit_add(fit, capture_time_ms, measurement[axis][0], measurement[axis][1]);
+
+        if(!polynomial_fit_get_acceleration(fit, &measurement[axis][2], &acceleration_variance[axis])) {
+            // Not enough fixes yet, barely trust the acceleration
+            measurement[axis][2] = 0.0f;
+            acceleration_variance[axis] = KALMAN_BATCH_MAX_ACC_VARIANCE;
+            fitted = 0;
+        }
+    }
+
+    return fitted;
+}
+
+
+// Round a measured acceleration variance up to a power of two
+static float kalman_batch_quantise_variance(float variance)
+{
+    int exponent;
+
+    if(!(variance > KALMAN_BATCH_MIN_ACC_VARIANCE)) {
+        variance = KALMAN_BATCH_MIN_ACC_VARIANCE;
+    } else if(variance > KALMAN_BATCH_MAX_ACC_VARIANCE) {
+        variance = KALMAN_BATCH_MAX_ACC_VARIANCE;
+    }
+
+    frexpf(variance, &exponent);
+
+    return ldexpf(1.0f, exponent);
+}
+
+
+// Executes the correction step of one track with a new measurement
+uint8_t kalman_batch_correct(
+            kalman_batch_t* kalman_batch,
+            uint8_t track,
+            const float measurement[KALMAN_BATCH_AXES][3],
+            float max_acc,
+            uint32_t time_ms,
+            uint32_t capture_time_ms)
+{
+    // Make sure the input is set as expected
+    if(kalman_batch == NULL || track >= kalman_batch->track_count) {
+        return 0;
+    }
+
+    kalman_handler_t kalman_handler[KALMAN_BATCH_AXES];
+    matrix_3x3_t measurement_covariance[KALMAN_BATCH_AXES];
+    vector_3_t measurement_residual[KALMAN_BATCH_AXES];
+    vector_3_t last_measurement;
+    matrix_3x3_t kalman_gain;
+    float fused_measurement[KALMAN_BATCH_AXES][3];
+    float acceleration_variance[KALMAN_BATCH_AXES];
+    uint8_t use_cached_gain = kalman_batch->gain_converged[track];
+    uint8_t converged = 1;
+    float normalised_innovation = 0.0f;
+    float position_excess = 0.0f;
+    float velocity_excess = 0.0f;
+
+    // The fits keep the capture time of the fix, even when it is fused later
+    uint32_t fix_time_ms = capture_time_ms;
+
+    // Out of order or future measurements are fused at the current time
+    if((int32_t)(capture_time_ms - kalman_batch->last_capture_time[track]) <= 0 ||
+       (int32_t)(kalman_batch->time_ms - capture_time_ms) < 0) {
+        capture_time_ms = kalman_batch->time_ms;
+    }
+
+    // Retrodiction starts from the last snapshot before the capture time
+    int16_t first_snapshot = -1;
+    if(capture_time_ms != kalman_batch->time_ms) {
+        first_snapshot = kalman_batch_find_snapshot(kalman_batch, capture_time_ms);
+        if(first_snapshot < 0) {
+            // Older than the whole history
+            capture_time_ms = kalman_batch->time_ms;
+        }
+    }
+
+    kalman_gain_cache_t* gain_cache = &kalman_batch->gain_cache;
+    float measurement_interval = (capture_time_ms - kalman_batch->last_capture_time[track]) / 1000.0f;
+
+    // Cached gains are only valid for the current max_acc
+    kalman_gain_cache_check(gain_cache, max_acc);
+
+    // Adapted (or set) measurement variances
+    kalman_batch->measurement_covariance.v[0][0] = kalman_batch->adaptation.position_variance;
+    kalman_batch->measurement_covariance.v[1][1] = kalman_batch->adaptation.velocity_variance;
+
+    // Position & velocity residuals at the capture time of the measurement,
+    // nothing is written back until the measurement passed the gate. The
+    // measured acceleration is left out: it comes from a fit which must not
+    // hold the measurement before it is accepted.
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        if(first_snapshot >= 0) {
+            kalman_batch_load_snapshot(kalman_batch, first_snapshot, axis, track, &kalman_handler[axis]);
+            kalman_predict(&kalman_handler[axis], max_acc, (capture_time_ms - kalman_batch->history_time[first_snapshot]) / 1000.0f);
+        } else {
+            kalman_batch_gather(kalman_batch, axis, track, &kalman_handler[axis]);
+        }
+
+        measurement_covariance[axis] = kalman_batch->measurement_covariance;
+
+        fused_measurement[axis][0] = measurement[axis][0];
+        fused_measurement[axis][1] = measurement[axis][1];
+        fused_measurement[axis][2] = kalman_handler[axis].state_estimate.v[2];
+        for(int i = 0; i < 3; i++) {
+            last_measurement.v[i] = fused_measurement[axis][i];
+        }
+
+        kalman_update_measurement_residual(&kalman_handler[axis], &measurement_residual[axis], &last_measurement, NULL);
+
+        // Position & velocity block of the residual covariance, also used to
+        // tell whether the noise is well tuned
+        float s_pp = kalman_handler[axis].state_estimate_covariance.v[0][0] + measurement_covariance[axis].v[0][0];
+        float s_pv = kalman_handler[axis].state_estimate_covariance.v[0][1] + measurement_covariance[axis].v[0][1];
+        float s_vv = kalman_handler[axis].state_estimate_covariance.v[1][1] + measurement_covariance[axis].v[1][1];
+        float y_p = measurement_residual[axis].v[0];
+        float y_v = measurement_residual[axis].v[1];
+        normalised_innovation += (s_vv * y_p * y_p - 2.0f * s_pv * y_p * y_v + s_pp * y_v * y_v) / (s_pp * s_vv - s_pv * s_pv);
+
+        // Innovation statistics for the covariance matching, y^2 - H * P * H^T
+        position_excess += SQR(measurement_residual[axis].v[0]) - kalman_handler[axis].state_estimate_covariance.v[0][0];
+        velocity_excess += SQR(measurement_residual[axis].v[1]) - kalman_handler[axis].state_estimate_covariance.v[1][1];
+    }
+
+    // Mahalanobis distance y^T * S^-1 * y of the position & velocity, summed
+    // over the axes. A singular residual covariance (no prediction since the
+    // track started) gives no ground to reject the measurement.
+    if(isfinite(normalised_innovation) && normalised_innovation > kalman_batch->gate_threshold) {
+        kalman_batch->rejection_count[track]++;
+        kalman_batch->consecutive_rejections[track]++;
+
+        // The same message is not evaluated again
+        kalman_batch->last_measurement_time[track] = time_ms;
+
+        if(kalman_batch->consecutive_rejections[track] < kalman_batch->gate_max_rejections) {
+            return 0;
+        }
+
+        // The target keeps disagreeing with the prediction: trust the
+        // prediction less and fuse this measurement
+        for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+            kalman_handler[axis].state_estimate_covariance =
+                smmul3(KALMAN_BATCH_GATE_INFLATION, kalman_handler[axis].state_estimate_covariance);
+        }
+        use_cached_gain = 0;
+    }
+
+    kalman_batch->consecutive_rejections[track] = 0;
+
+    // Only accepted measurements enter the acceleration fits
+    kalman_batch_fit_acceleration(kalman_batch, track, fused_measurement, acceleration_variance, fix_time_ms);
+
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        measurement_covariance[axis].v[2][2] = kalman_batch_quantise_variance(acceleration_variance[axis]);
+        kalman_handler[axis].measurement_covariance = measurement_covariance[axis];
+
+        for(int i = 0; i < 3; i++) {
+            last_measurement.v[i] = fused_measurement[axis][i];
+        }
+
+        kalman_update_measurement_residual(&kalman_handler[axis], &measurement_residual[axis], &last_measurement, NULL);
+    }
+
+    if(isfinite(normalised_innovation)) {
+        kalman_adaptation_update(&kalman_batch->adaptation,
+                                 normalised_innovation / (2 * KALMAN_BATCH_AXES),
+                                 position_excess / KALMAN_BATCH_AXES,
+                                 velocity_excess / KALMAN_BATCH_AXES);
+    }
+
+    // Corrections only happen when a message arrives, so they go through
+    // the generic single target path
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        for(int i = 0; i < 3; i++) {
+            kalman_batch->last_measurement[axis][i][track] = fused_measurement[axis][i];
+        }
+
+        // Skip the residual covariance inverse and the gain product once the
+        // track reached its steady state, compute the gain in full while it
+        // is still converging. The gate above only needs the inline 2x2 block.
+        if(!use_cached_gain ||
+           !kalman_gain_cache_lookup(gain_cache, measurement_interval, &measurement_covariance[axis], &kalman_gain)) {
+            kalman_compute_gain(&kalman_handler[axis], &kalman_gain);
+
+            // Fresh tracks all start from the same covariance, so their first
+            // gains match each other without being steady-state gains
+            if(kalman_batch->correction_count[track] >= KALMAN_BATCH_GAIN_WARMUP) {
+                converged &= kalman_gain_cache_update(gain_cache, measurement_interval, &measurement_covariance[axis], &kalman_gain, use_cached_gain);
+            } else {
+                converged = 0;
+            }
+        }
+
+        kalman_apply_gain(&kalman_handler[axis], &measurement_residual[axis], &kalman_gain);
+
+        // Propagate again through the newer snapshots, so that they stay
+        // consistent for the next late measurement
+        uint32_t estimate_time_ms = capture_time_ms;
+        for(uint8_t age = kalman_batch->history_count; age > 0; age--) {
+            uint8_t snapshot = (kalman_batch->history_head + KALMAN_BATCH_HISTORY_SIZE + 1 - age) % KALMAN_BATCH_HISTORY_SIZE;
+
+            if((int32_t)(kalman_batch->history_time[snapshot] - estimate_time_ms) >= 0) {
+                kalman_predict(&kalman_handler[axis], max_acc, (kalman_batch->history_time[snapshot] - estimate_time_ms) / 1000.0f);
+                estimate_time_ms = kalman_batch->history_time[snapshot];
+                kalman_batch_save_snapshot(kalman_batch, snapshot, axis, track, &kalman_handler[axis]);
+            }
+        }
+
+        // Up to the current time
+        kalman_predict(&kalman_handler[axis], max_acc, (kalman_batch->time_ms - estimate_time_ms) / 1000.0f);
+        kalman_batch_scatter(kalman_batch, axis, track, &kalman_handler[axis]);
+    }
+
+    kalman_batch->gain_converged[track] = converged;
+    if(kalman_batch->correction_count[track] < KALMAN_BATCH_GAIN_WARMUP) {
+        kalman_batch->correction_count[track]++;
+    }
+    kalman_batch->last_measurement_time[track] = time_ms;
+    kalman_batch->last_capture_time[track] = capture_time_ms;
+
+    return 1;
+}
@@ -0,0 +1,266 @@
+/*******************************************************************************
+ * \file kalman_batch_predictor.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements a batched Kalman predictor that tracks every
+ *        neighbor at once
+ *
+ * The states and covariances of all tracks are stored in a
+ * structure-of-arrays layout (one row per axis, one column per track) so the
+ * prediction step runs as a single tight loop over all active tracks.
+ *
+ * Snapshots of all tracks are kept in a ring buffer, so that a measurement
+ * that arrives late is fused at its capture time and the track is then
+ * propagated again to the current time (retrodiction).
+ *
+ ******************************************************************************/
+
+#ifndef KALMAN_BATCH_PREDICTOR_H
+#define KALMAN_BATCH_PREDICTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "small_matrix.h"
+#include "neighbor_selection.h"
+#include "kalman_gain_cache.h"
+#include "polynomial_fit.h"
+#include "kalman_adaptation.h"
+
+#define KALMAN_BATCH_MAX_TRACKS MAX_NUM_NEIGHBORS   ///< One track per neighbor
+#define KALMAN_BATCH_AXES 3                         ///< Tracks are filtered independently along x, y and z
+#define KALMAN_BATCH_TRACK_TIMEOUT_MS 20000         ///< Tracks without measurement for this long are dropped
+#define KALMAN_BATCH_HISTORY_SIZE 6                 ///< Number of snapshots kept for retrodiction
+#define KALMAN_BATCH_HISTORY_PERIOD_MS 100          ///< Minimal time between two snapshots (ms)
+#define KALMAN_BATCH_MIN_ACC_VARIANCE 1.0e-3f       ///< Lower bound of the variance of a measured acceleration (m^2/s^4)
+#define KALMAN_BATCH_MAX_ACC_VARIANCE 1.0e3f        ///< Upper bound of the variance of a measured acceleration (m^2/s^4)
+#define KALMAN_BATCH_GATE_THRESHOLD 22.46f          ///< Default gate on the squared Mahalanobis distance of the position & velocity of a measurement (chi-square, 6 degrees of freedom, 99.9%)
+#define KALMAN_BATCH_GATE_MAX_REJECTIONS 3          ///< Default number of consecutive rejections after which the covariance is inflated
+#define KALMAN_BATCH_GATE_INFLATION 10.0f           ///< Factor applied to the covariance of a track after too many consecutive rejections
+#define KALMAN_BATCH_MAX_ACC 10.0f                  ///< Initial maximal acceleration of the targets (m/s^2)
+#define KALMAN_BATCH_GAIN_WARMUP 8                  ///< Number of corrections of a track before its gains may confirm or use the gain cache
+
+
+/**
+ * \brief   Structure that contains the states of all tracked neighbors
+ *
+ * \details All per-track arrays are indexed [axis][track]. The covariance of
+ *          each (axis, track) pair is symmetric, so only its upper triangle is
+ *          stored: p_pp, p_pv, p_pa, p_vv, p_va and p_aa.
+ */
+typedef struct kalman_batch_t {
+    uint8_t track_count;                                                            ///< Number of active tracks
+    uint8_t neighbor_ID[KALMAN_BATCH_MAX_TRACKS];                                   ///< MAVLink ID of the neighbor followed by each track
+    uint32_t last_measurement_time[KALMAN_BATCH_MAX_TRACKS];                        ///< Reception time of the last fused measurement (ms)
+    uint32_t last_capture_time[KALMAN_BATCH_MAX_TRACKS];                            ///< Capture time of the last fused measurement, in local time (ms)
+    uint8_t gain_converged[KALMAN_BATCH_MAX_TRACKS];                                ///< Whether the gain of each track reached its steady state
+    uint8_t correction_count[KALMAN_BATCH_MAX_TRACKS];                              ///< Number of corrections since the track started, up to KALMAN_BATCH_GAIN_WARMUP
+    uint16_t rejection_count[KALMAN_BATCH_MAX_TRACKS];                              ///< Number of measurements rejected by the gate since the track started
+    uint8_t consecutive_rejections[KALMAN_BATCH_MAX_TRACKS];                        ///< Number of measurements rejected in a row
+
+    float pos[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                          ///< Position estimate
+    float vel[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                          ///< Velocity estimate
+    float acc[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                          ///< Acceleration estimate
+
+    float p_pp[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                         ///< Covariance position/position
+    float p_pv[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                         ///< Covariance position/velocity
+    float p_pa[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                         ///< Covariance position/acceleration
+    float p_vv[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                         ///< Covariance velocity/velocity
+    float p_va[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                         ///< Covariance velocity/acceleration
+    float p_aa[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];                         ///< Covariance acceleration/acceleration
+
+    float last_measurement[KALMAN_BATCH_AXES][3][KALMAN_BATCH_MAX_TRACKS];          ///< Last measurement (position, velocity, acceleration) of each track
+    polynomial_fit_t acceleration_fit[KALMAN_BATCH_AXES][KALMAN_BATCH_MAX_TRACKS];  ///< Fit of the last position & velocity fixes, gives the measured acceleration
+
+    matrix_3x3_t design_matrix;                                                     ///< Maps the state space to the measurement space, shared by all tracks
+    matrix_3x3_t design_matrix_trans;                                               ///< Transpose of the design matrix
+    matrix_3x3_t measurement_covariance;                                            ///< Measurement covariance, shared by all tracks
+
+    kalman_gain_cache_t gain_cache;                                                 ///< Steady-state gains, shared by all tracks and axes
+
+    float gate_threshold;                                                           ///< Gate on the squared Mahalanobis distance of the position & velocity of a measurement, summed over the axes
+    int32_t gate_max_rejections;                                                    ///< Number of consecutive rejections after which the covariance is inflated
+
+    kalman_adaptation_t adaptation;                                                 ///< Adaptive estimation of max_acc & of the position and velocity measurement variances, shared by all tracks
+
+    uint32_t time_ms;                                                               ///< Time of the current estimates (ms)
+    uint8_t history_count;                                                          ///< Number of valid snapshots
+    uint8_t history_head;                                                           ///< Index of the most recent snapshot
+    uint32_t history_time[KALMAN_BATCH_HISTORY_SIZE];                               ///< Time of each snapshot (ms)
+    float history_state[KALMAN_BATCH_HISTORY_SIZE][KALMAN_BATCH_AXES][3][KALMAN_BATCH_MAX_TRACKS];   ///< Position, velocity & acceleration of each snapshot
+    float history_covariance[KALMAN_BATCH_HISTORY_SIZE][KALMAN_BATCH_AXES][6][KALMAN_BATCH_MAX_TRACKS];  ///< Covariance upper triangle (pp, pv, pa, vv, va, aa) of each snapshot
+} kalman_batch_t;
+
+
+/**
+ * \brief   Initialise the batched Kalman predictor with no active track
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ */
+uint8_t kalman_batch_init(kalman_batch_t* kalman_batch);
+
+
+/**
+ * \brief   Drop every track & the history, the gate settings and the
+ *            adapted noise are kept
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ */
+uint8_t kalman_batch_reset(kalman_batch_t* kalman_batch);
+
+
+/**
+ * \brief   Find the track that follows a neighbor
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ * \param   neighbor_ID             MAVLink ID of the neighbor
+ *
+ * \return  Index of the track, -1 if the neighbor is not tracked
+ */
+int16_t kalman_batch_find_track(const kalman_batch_t* kalman_batch, uint8_t neighbor_ID);
+
+
+/**
+ * \brief   Start a new track, seeded with a first measurement
+ *
+ * \details The track starts at the capture time of the measurement and is
+ *          predicted up to the time of the current estimates, like a
+ *          correction is.
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ * \param   neighbor_ID             MAVLink ID of the neighbor
+ * \param   measurement             First measurement, indexed [axis][component]
+ *                                    (position, velocity, acceleration)
+ * \param   max_acc                 Value of the maximal acceleration that the
+ *                                    targets can exert
+ * \param   time_ms                 Reception time of the measurement (ms)
+ * \param   capture_time_ms         Capture time of the measurement, in local
+ *                                    time (ms)
+ *
+ * \return  Index of the new track, -1 if all tracks are in use
+ */
+int16_t kalman_batch_add_track(kalman_batch_t* kalman_batch, uint8_t neighbor_ID, const float measurement[KALMAN_BATCH_AXES][3], float max_acc, uint32_t time_ms, uint32_t capture_time_ms);
+
+
+/**
+ * \brief   Drop a track (the last track is moved into its slot)
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ * \param   track                   Index of the track
+ */
+void kalman_batch_remove_track(kalman_batch_t* kalman_batch, uint8_t track);
+
+
+/**
+ * \brief   Drop every track that did not receive a measurement for
+ *            KALMAN_BATCH_TRACK_TIMEOUT_MS
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ * \param   time_ms                 Current time (ms)
+ */
+void kalman_batch_remove_stale_tracks(kalman_batch_t* kalman_batch, uint32_t time_ms);
+
+
+/**
+ * \brief   Executes the prediction step for all active tracks
+ *            (constant acceleration motion model, same as kalman_predict())
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ * \param   max_acc                 Value of the maximal acceleration that the
+ *                                    targets can exert
+ * \param   delta_t                 Integration time
+ */
+uint8_t kalman_batch_predict(kalman_batch_t* kalman_batch, float max_acc, float delta_t);
+
+
+/**
+ * \brief   Set the time of the current estimates and save a snapshot of all
+ *            tracks if the last one is older than KALMAN_BATCH_HISTORY_PERIOD_MS
+ *
+ * \details To be called after kalman_batch_predict() and before the
+ *          corrections of the same time step
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ * \param   time_ms                 Current time (ms)
+ */
+void kalman_batch_record_history(kalman_batch_t* kalman_batch, uint32_t time_ms);
+
+
+/**
+ * \brief   Add the position & velocity of a new measurement to the fits of a
+ *            track, and fill in the measured acceleration
+ *
+ * \details The acceleration along each axis is the one of a weighted
+ *          least-squares quadratic fit of the last POLYNOMIAL_FIT_WINDOW fixes
+ *          (see polynomial_fit.h). Until the window holds enough fixes at
+ *          distinct times, the acceleration is set to 0 with
+ *          KALMAN_BATCH_MAX_ACC_VARIANCE.
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ * \param   track                   Index of the track
+ * \param   measurement             New measurement, indexed [axis][component]
+ *                                    (position, velocity, acceleration), the
+ *                                    acceleration is set
+ * \param   acceleration_variance   Variance of the measured acceleration along
+ *                                    each axis (m^2/s^4), set
+ * \param   capture_time_ms         Capture time of the measurement, in local
+ *                                    time (ms)
+ *
+ * \return  1 if the acceleration was fitted along every axis, 0 otherwise
+ */
+uint8_t kalman_batch_fit_acceleration(kalman_batch_t* kalman_batch, uint8_t track, float measurement[KALMAN_BATCH_AXES][3], float acceleration_variance[KALMAN_BATCH_AXES], uint32_t capture_time_ms);
+
+
+/**
+ * \brief   Executes the correction step of one track with a new measurement
+ *
+ * \details If the measurement is older than the current estimates, the
+ *          track is restored from the last snapshot before its capture time,
+ *          corrected there and propagated again through the newer snapshots
+ *          up to the current time. Measurements older than the history, or
+ *          not newer than the last fused one, are fused at the current time.
+ *          Once a track converged, its gain is taken from the steady-state
+ *          gain cache instead of being computed (see kalman_gain_cache.h).
+ *
+ *          A measurement whose squared Mahalanobis distance y^T * S^-1 * y
+ *          on the position & velocity, summed over the axes, exceeds
+ *          gate_threshold is rejected before anything is written back to the
+ *          track or to its acceleration fits. After gate_max_rejections
+ *          rejections in a row, the covariance of the track is inflated by
+ *          KALMAN_BATCH_GATE_INFLATION and the measurement is fused.
+ *
+ *          The acceleration of a fused measurement is measured by adding it
+ *          to the fits of the track (see kalman_batch_fit_acceleration()).
+ *          Its variance is rounded up to a power of two, so that tracks with
+ *          similar fits share cached gains.
+ *
+ *          The innovations of the fused measurements feed the adaptive
+ *          noise estimation (see kalman_adaptation.h), which sets the
+ *          position & velocity measurement variances of the next corrections.
+ *          The adapted maximal acceleration is adaptation.max_acc, to be
+ *          passed to kalman_batch_predict() & kalman_batch_correct().
+ *
+ * \param   kalman_batch            Pointer to the batched predictor
+ * \param   track                   Index of the track
+ * \param   measurement             New measurement, indexed [axis][component]
+ *                                    (position, velocity, acceleration), the
+ *                                    acceleration is not used
+ * \param   max_acc                 Value of the maximal acceleration that the
+ *                                    targets can exert
+ * \param   time_ms                 Reception time of the measurement (ms)
+ * \param   capture_time_ms         Capture time of the measurement, in local
+ *                                    time (ms)
+ *
+ * \return  1 if the measurement was fused, 0 otherwise
+ */
+uint8_t kalman_batch_correct(kalman_batch_t* kalman_batch, uint8_t track, const float measurement[KALMAN_BATCH_AXES][3], float max_acc, uint32_t time_ms, uint32_t capture_time_ms);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,152 @@
+/*******************************************************************************
+ * \file kalman_gain_cache.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements a cache of steady-state Kalman gains
+ *
+ ******************************************************************************/
+
+#include <math.h>
+#include <stddef.h>
+#include "kalman_gain_cache.h"
+
+
+// Get the bin of a measurement interval, -1 if it is out of the cache
+static int16_t kalman_gain_cache_bin(float measurement_interval)
+{
+    if(!(measurement_interval >= 0.0f)) {
+        return -1;
+    }
+
+    int32_t bin = (int32_t)(measurement_interval / KALMAN_GAIN_CACHE_QUANTUM_S + 0.5f);
+
+    if(bin >= KALMAN_GAIN_CACHE_SIZE) {
+        return -1;
+    }
+
+    return bin;
+}
+
+
+// Check whether two measurement covariances are identical
+static uint8_t kalman_gain_cache_same_covariance(const matrix_3x3_t* covariance_1, const matrix_3x3_t* covariance_2)
+{
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < 3; j++) {
+            if(covariance_1->v[i][j] != covariance_2->v[i][j]) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+
+// Check whether two gains are equal up to KALMAN_GAIN_CACHE_TOLERANCE
+static uint8_t kalman_gain_cache_match(const matrix_3x3_t* gain_1, const matrix_3x3_t* gain_2)
+{
+    for(int i = 0; i < 3; i++) {
+        for(int j = 0; j < 3; j++) {
+            if(fabsf(gain_1->v[i][j] - gain_2->v[i][j]) > KALMAN_GAIN_CACHE_TOLERANCE) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+
+// Initialise the gain cache with no valid entry
+uint8_t kalman_gain_cache_init(kalman_gain_cache_t* kalman_gain_cache)
+{
+    // Make sure the input is set as expected
+    if(kalman_gain_cache == NULL) {
+        return 0;
+    }
+
+    kalman_gain_cache->max_acc = 0.0f;
+
+    for(int bin = 0; bin < KALMAN_GAIN_CACHE_SIZE; bin++) {
+        kalman_gain_cache->measurement_covariance[bin] = zero_3x3;
+        kalman_gain_cache->gain[bin] = zero_3x3;
+        kalman_gain_cache->confirmations[bin] = 0;
+        kalman_gain_cache->uses[bin] = 0;
+    }
+
+    return 1;
+}
+
+
+// Drop every cached gain if the maximal acceleration changed
+void kalman_gain_cache_check(kalman_gain_cache_t* kalman_gain_cache, float max_acc)
+{
+    if(max_acc != kalman_gain_cache->max_acc) {
+        kalman_gain_cache_init(kalman_gain_cache);
+        kalman_gain_cache->max_acc = max_acc;
+    }
+}
+
+
+// Get the steady-state gain of a measurement interval
+uint8_t kalman_gain_cache_lookup(
+            kalman_gain_cache_t* kalman_gain_cache,
+            float measurement_interval,
+            const matrix_3x3_t* measurement_covariance,
+            matrix_3x3_t* kalman_gain)
+{
+    int16_t bin = kalman_gain_cache_bin(measurement_interval);
+
+    if(bin < 0 ||
+       kalman_gain_cache->confirmations[bin] < KALMAN_GAIN_CACHE_CONFIRMATIONS ||
+       !kalman_gain_cache_same_covariance(&kalman_gain_cache->measurement_covariance[bin], measurement_covariance)) {
+        return 0;
+    }
+
+    // Force a full computation from time to time to refresh the entry
+    kalman_gain_cache->uses[bin]++;
+    if(kalman_gain_cache->uses[bin] >= KALMAN_GAIN_CACHE_REFRESH) {
+        kalman_gain_cache->uses[bin] = 0;
+        return 0;
+    }
+
+    *kalman_gain = kalman_gain_cache->gain[bin];
+
+    return 1;
+}
+
+
+// Feed a gain obtained by the full computation to the cache
+uint8_t kalman_gain_cache_update(
+            kalman_gain_cache_t* kalman_gain_cache,
+            float measurement_interval,
+            const matrix_3x3_t* measurement_covariance,
+            const matrix_3x3_t* kalman_gain,
+            uint8_t converged)
+{
+    int16_t bin = kalman_gain_cache_bin(measurement_interval);
+
+    if(bin < 0) {
+        return 0;
+    }
+
+    if(kalman_gain_cache_same_covariance(&kalman_gain_cache->measurement_covariance[bin], measurement_covariance) &&
+       kalman_gain_cache_match(&kalman_gain_cache->gain[bin], kalman_gain)) {
+        if(kalman_gain_cache->confirmations[bin] < KALMAN_GAIN_CACHE_CONFIRMATIONS) {
+            kalman_gain_cache->confirmations[bin]++;
+        }
+    } else if(kalman_gain_cache->confirmations[bin] >= KALMAN_GAIN_CACHE_CONFIRMATIONS && !converged) {
+        // A predictor that is still converging must not evict a steady-state gain
+        return 0;
+    } else {
+        // No steady state yet, or it moved: start over
+        kalman_gain_cache->measurement_covariance[bin] = *measurement_covariance;
+        kalman_gain_cache->gain[bin] = *kalman_gain;
+        kalman_gain_cache->confirmations[bin] = 0;
+        kalman_gain_cache->uses[bin] = 0;
+    }
+
+    return (kalman_gain_cache->confirmations[bin] >= KALMAN_GAIN_CACHE_CONFIRMATIONS);
+}
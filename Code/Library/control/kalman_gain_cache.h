@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * \file kalman_gain_cache.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements a cache of steady-state Kalman gains
+ *
+ * Once a Kalman predictor has converged, its gain only depends on the time
+ * elapsed since the previous measurement, on the maximal acceleration of the
+ * target and on the measurement covariance. The gains computed by the full
+ * path are stored per quantised measurement interval, together with the
+ * measurement covariance they were computed with, and reused, which avoids
+ * the matrix inversion of every correction.
+ *
+ ******************************************************************************/
+
+#ifndef KALMAN_GAIN_CACHE_H
+#define KALMAN_GAIN_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "small_matrix.h"
+
+#define KALMAN_GAIN_CACHE_SIZE 24                   ///< Number of cached measurement intervals
+#define KALMAN_GAIN_CACHE_QUANTUM_S 0.5f            ///< Width of one measurement interval bin (s)
+#define KALMAN_GAIN_CACHE_TOLERANCE 1.0e-3f         ///< Maximal difference between two gains that are considered equal
+#define KALMAN_GAIN_CACHE_CONFIRMATIONS 3           ///< Number of matching full computations before an entry is used
+#define KALMAN_GAIN_CACHE_REFRESH 16                ///< A cached gain is recomputed after this many uses
+
+
+/**
+ * \brief   Structure that contains the cached steady-state gains
+ *
+ * \param   max_acc                 Maximal acceleration the gains were
+ *                                    computed with
+ * \param   measurement_covariance  Measurement covariance each gain was
+ *                                    computed with
+ * \param   gain                    Steady-state gain of each interval bin
+ * \param   confirmations           Number of consecutive full computations
+ *                                    that matched the stored gain
+ * \param   uses                    Number of times the gain was used since
+ *                                    it was last recomputed
+ */
+typedef struct kalman_gain_cache_t {
+    float max_acc;
+    matrix_3x3_t measurement_covariance[KALMAN_GAIN_CACHE_SIZE];
+    matrix_3x3_t gain[KALMAN_GAIN_CACHE_SIZE];
+    uint8_t confirmations[KALMAN_GAIN_CACHE_SIZE];
+    uint8_t uses[KALMAN_GAIN_CACHE_SIZE];
+} kalman_gain_cache_t;
+
+
+/**
+ * \brief   Initialise the gain cache with no valid entry
+ *
+ * \param   kalman_gain_cache       Pointer to the gain cache
+ */
+uint8_t kalman_gain_cache_init(kalman_gain_cache_t* kalman_gain_cache);
+
+
+/**
+ * \brief   Drop every cached gain if the maximal acceleration changed since
+ *            they were computed
+ *
+ * \param   kalman_gain_cache       Pointer to the gain cache
+ * \param   max_acc                 Current maximal acceleration of the target
+ */
+void kalman_gain_cache_check(kalman_gain_cache_t* kalman_gain_cache, float max_acc);
+
+
+/**
+ * \brief   Get the steady-state gain of a measurement interval
+ *
+ * \details Every KALMAN_GAIN_CACHE_REFRESH uses the lookup misses on purpose,
+ *          so the caller runs the full computation and refreshes the entry.
+ *
+ * \param   kalman_gain_cache       Pointer to the gain cache
+ * \param   measurement_interval    Time since the previous measurement (s)
+ * \param   measurement_covariance  Measurement covariance of the correction
+ * \param   kalman_gain             Pointer to the Kalman gain matrix, set on hit
+ *
+ * \return  1 if a confirmed gain was found, 0 otherwise
+ */
+uint8_t kalman_gain_cache_lookup(kalman_gain_cache_t* kalman_gain_cache, float measurement_interval, const matrix_3x3_t* measurement_covariance, matrix_3x3_t* kalman_gain);
+
+
+/**
+ * \brief   Feed a gain obtained by the full computation to the cache
+ *
+ * \param   kalman_gain_cache       Pointer to the gain cache
+ * \param   measurement_interval    Time since the previous measurement (s)
+ * \param   measurement_covariance  Measurement covariance of the correction
+ * \param   kalman_gain             Pointer to the Kalman gain matrix
+ * \param   converged               1 if the predictor that produced the gain
+ *                                    already converged (periodic refresh), a
+ *                                    mismatch then replaces a confirmed entry
+ *
+ * \return  1 if the gain matches a confirmed entry (the predictor that
+ *            produced it has converged), 0 otherwise
+ */
+uint8_t kalman_gain_cache_update(kalman_gain_cache_t* kalman_gain_cache, float measurement_interval, const matrix_3x3_t* measurement_covariance, const matrix_3x3_t* kalman_gain, uint8_t converged);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
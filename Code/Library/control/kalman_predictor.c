@@ -34,11 +34,13 @@ uint8_t kalman_init(
 
     // Initialise Design matrix
     kalman_handler->design_matrix = ident_3x3;
-    kalman_handler->design_matrix.v[2][1] = 1.0f;
-    kalman_handler->design_matrix.v[2][2] = - 0.4f;
+    kalman_handler->design_matrix_trans = trans3(kalman_handler->design_matrix);
 
-    // Initialise measurement covariance matrix
+    // Initialise measurement covariance matrix, GPS position (0.5 m) and
+    // velocity (0.2 m/s) noise of the neighbors
     kalman_handler->measurement_covariance = zero_3x3;
+    kalman_handler->measurement_covariance.v[0][0] = 0.25f;
+    kalman_handler->measurement_covariance.v[1][1] = 0.04f;
     kalman_handler->measurement_covariance.v[2][2] = 0.1f;
 
     return 1;
@@ -56,39 +58,31 @@ uint8_t kalman_predict(
         return 0;
     }
 
-    // Compute new state propagation matrix
-    matrix_3x3_t state_propagation_matrix =
-       {.v={{1.0f, delta_t, delta_t * delta_t / 2.0f},
-            {0.0f, 1.0f,    delta_t},
-            {0.0f, 0.0f,    1.0f}} };
-    matrix_3x3_t state_propagation_matrix_trans =
-       {.v={{1.0f,                     0.0f,    0.0f},
-            {delta_t,                  1.0f,    0.0f},
-            {delta_t * delta_t / 2.0f, delta_t, 1.0f}} };
-
-    // Compute new process noise covariance matrix
-    matrix_3x3_t process_noise_covariance = zero_3x3;
-    float sigma_x = (1.0f / 8.0f) * max_acc * delta_t * delta_t;
-    float sigma_v = (1.0f / 4.0f) * max_acc * delta_t;
-    process_noise_covariance.v[0][0] = sigma_x * sigma_x;
-    process_noise_covariance.v[0][1] = sigma_x * sigma_v;
-    process_noise_covariance.v[1][0] = sigma_x * sigma_v;
-    process_noise_covariance.v[1][1] = sigma_v * sigma_v;
+    kalman_propagation_t propagation = kalman_compute_propagation(max_acc, delta_t);
+    vector_3_t* x = &kalman_handler->state_estimate;
+    matrix_3x3_t* p = &kalman_handler->state_estimate_covariance;
 
     // Predict state estimate, x_{k} = F * x_{k-1}
-    kalman_handler->state_estimate =
-        mvmul3(state_propagation_matrix, kalman_handler->state_estimate);
+    x->v[0] += propagation.delta_t * x->v[1] + propagation.half_dt2 * x->v[2];
+    x->v[1] += propagation.delta_t * x->v[2];
 
     // Predict state estimate covariance, P_{k} = F * P_{k-1} * F^T + Q
-    kalman_handler->state_estimate_covariance =
-        mmul3(kalman_handler->state_estimate_covariance,
-              state_propagation_matrix_trans);
-    kalman_handler->state_estimate_covariance =
-        mmul3(state_propagation_matrix,
-              kalman_handler->state_estimate_covariance);
-    kalman_handler->state_estimate_covariance =
-        madd3(kalman_handler->state_estimate_covariance,
-              process_noise_covariance);
+    // P is symmetric, only propagate its upper triangle
+    kalman_packed_covariance_t covariance =
+        {.pp = p->v[0][0], .pv = p->v[0][1], .pa = p->v[0][2],
+                           .vv = p->v[1][1], .va = p->v[1][2],
+                                             .aa = p->v[2][2]};
+    kalman_propagate_packed_covariance(&propagation, &covariance);
+
+    p->v[0][0] = covariance.pp;
+    p->v[0][1] = covariance.pv;
+    p->v[0][2] = covariance.pa;
+    p->v[1][0] = covariance.pv;
+    p->v[1][1] = covariance.vv;
+    p->v[1][2] = covariance.va;
+    p->v[2][0] = covariance.pa;
+    p->v[2][1] = covariance.va;
+    p->v[2][2] = covariance.aa;
 
     return 1;
 }
@@ -120,16 +114,38 @@ uint8_t kalman_correct(
         kalman_handler,
         &kalman_gain);
 
+    return kalman_apply_gain(
+        kalman_handler,
+        &measurement_residual,
+        &kalman_gain);
+}
+
+
+// Corrects the state & the state covariance with a given Kalman gain
+uint8_t kalman_apply_gain(
+            kalman_handler_t * kalman_handler,
+            const vector_3_t * measurement_residual,
+            const matrix_3x3_t * kalman_gain)
+{
+    // Make sure the input is set as expected
+    if(kalman_handler == NULL || measurement_residual == NULL || kalman_gain == NULL) {
+        return 0;
+    }
+
     // Correct state estimate, x = x + K * y
     kalman_handler->state_estimate =
         vadd3(kalman_handler->state_estimate,
-              mvmul3(kalman_gain, measurement_residual));
+              mvmul3(*kalman_gain, *measurement_residual));
 
-    // Correct state estimate covariance, P = (I − K * H) * P
+    // Correct state estimate covariance in the Joseph form,
+    // P = (I - K * H) * P * (I - K * H)^T + K * R * K^T, which holds for any
+    // gain (a cached gain is only close to the optimal one) and keeps P
+    // positive definite when R is small against P
+    matrix_3x3_t i_kh = msub3(ident_3x3, mmul3(*kalman_gain, kalman_handler->design_matrix));
     kalman_handler->state_estimate_covariance =
-        mmul3(
-            msub3(ident_3x3, mmul3(kalman_gain, kalman_handler->design_matrix)),
-            kalman_handler->state_estimate_covariance);
+        madd3(
+            mmul3(i_kh, mmul3(kalman_handler->state_estimate_covariance, trans3(i_kh))),
+            mmul3(*kalman_gain, mmul3(kalman_handler->measurement_covariance, trans3(*kalman_gain))));
 
     return 1;
 }
@@ -166,20 +182,53 @@ uint8_t kalman_compute_gain(
         return 0;
     }
 
-    matrix_3x3_t design_matrix_trans = trans3(kalman_handler->design_matrix);
+    matrix_3x3_t residual_covariance_inv;
+
+    kalman_compute_residual_covariance_inverse(kalman_handler, &residual_covariance_inv);
+
+    return kalman_compute_gain_from_inverse(kalman_handler, &residual_covariance_inv, kalman_gain);
+}
+
+
+// Computes the inverse of the residual covariance matrix
+uint8_t kalman_compute_residual_covariance_inverse(
+            const kalman_handler_t * kalman_handler,
+            matrix_3x3_t * residual_covariance_inv)
+{
+    // Make sure the input is set as expected
+    if(kalman_handler == NULL || residual_covariance_inv == NULL) {
+        return 0;
+    }
 
     // Compute the residual covariance matrix, S = H * P * H^T + R
     matrix_3x3_t residual_covariance =
         madd3(
             mmul3(kalman_handler->design_matrix,
                   mmul3(kalman_handler->state_estimate_covariance,
-                        design_matrix_trans)),
+                        kalman_handler->design_matrix_trans)),
             kalman_handler->measurement_covariance);
 
+    *residual_covariance_inv = inv3(residual_covariance);
+
+    return 1;
+}
+
+
+// Computes the Kalman gain from the inverse of the residual covariance matrix
+uint8_t kalman_compute_gain_from_inverse(
+            const kalman_handler_t * kalman_handler,
+            const matrix_3x3_t * residual_covariance_inv,
+            matrix_3x3_t * kalman_gain)
+{
+    // Make sure the input is set as expected
+    if(kalman_handler == NULL || residual_covariance_inv == NULL || kalman_gain == NULL) {
+        return 0;
+    }
+
     // Compute the Kalman gain matrix, K = P * H^T * S^-1
     *kalman_gain =
         mmul3(kalman_handler->state_estimate_covariance,
-              mmul3(design_matrix_trans, inv3(residual_covariance)));
+              mmul3(kalman_handler->design_matrix_trans, *residual_covariance_inv));
 
     return 1;
 }
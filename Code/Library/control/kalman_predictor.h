@@ -24,6 +24,8 @@ extern "C" {
 #define FALSE 0
 #define NULL 0
 
+#define KALMAN_ACC_NOISE 0.25f      ///< Spread of the acceleration random walk over one second, as a fraction of max_acc
+
 /**
  * \brief   Structure that contains all the main Kalman parameters
  *
@@ -32,6 +34,9 @@ extern "C" {
  * \param   state_estimate_covariance     State estimate covariance matrix
  * \param   design_matrix                 Design matrix, maps the state space
  *                                          to the measurement space
+ * \param   design_matrix_trans           Transpose of the design matrix,
+ *                                          kept to avoid rebuilding it at
+ *                                          every correction
  * \param   measurement_covariance        Measurement covariance matrix that
  *                                          takes measurement errors into
  *                                          account
@@ -42,10 +47,112 @@ typedef struct kalman_handler_t {
     vector_3_t state_estimate;
     matrix_3x3_t state_estimate_covariance;
     matrix_3x3_t design_matrix;
+    matrix_3x3_t design_matrix_trans;
     matrix_3x3_t measurement_covariance;
 } kalman_handler_t;
 
 
+/**
+ * \brief   Upper triangle of a symmetric state estimate covariance matrix
+ *
+ * \param   pp                      Covariance position/position
+ * \param   pv                      Covariance position/velocity
+ * \param   pa                      Covariance position/acceleration
+ * \param   vv                      Covariance velocity/velocity
+ * \param   va                      Covariance velocity/acceleration
+ * \param   aa                      Covariance acceleration/acceleration
+ */
+typedef struct kalman_packed_covariance_t {
+    float pp, pv, pa;
+    float vv, va;
+    float aa;
+} kalman_packed_covariance_t;
+
+
+/**
+ * \brief   Terms of the constant acceleration propagation for a given
+ *            integration time, shared by every axis and every target
+ *
+ * \param   delta_t                 Integration time
+ * \param   half_dt2                delta_t^2 / 2
+ * \param   q_pp                    Process noise covariance position/position
+ * \param   q_pv                    Process noise covariance position/velocity
+ * \param   q_vv                    Process noise covariance velocity/velocity
+ * \param   q_aa                    Process noise covariance
+ *                                    acceleration/acceleration
+ */
+typedef struct kalman_propagation_t {
+    float delta_t;
+    float half_dt2;
+    float q_pp;
+    float q_pv;
+    float q_vv;
+    float q_aa;
+} kalman_propagation_t;
+
+
+/**
+ * \brief   Compute the propagation terms of the constant acceleration model
+ *
+ * \param   max_acc                 Value of the maximal acceleration that the
+ *                                    system can exert
+ * \param   delta_t                 Integration time
+ */
+static inline kalman_propagation_t kalman_compute_propagation(float max_acc, float delta_t)
+{
+    kalman_propagation_t propagation;
+
+    float sigma_x = (1.0f / 8.0f) * max_acc * delta_t * delta_t;
+    float sigma_v = (1.0f / 4.0f) * max_acc * delta_t;
+    float sigma_a = KALMAN_ACC_NOISE * max_acc;
+
+    propagation.delta_t = delta_t;
+    propagation.half_dt2 = delta_t * delta_t / 2.0f;
+    propagation.q_pp = sigma_x * sigma_x;
+    propagation.q_pv = sigma_x * sigma_v;
+    propagation.q_vv = sigma_v * sigma_v;
+    propagation.q_aa = sigma_a * sigma_a * delta_t;
+
+    return propagation;
+}
+
+
+/**
+ * \brief   Predict a packed state estimate covariance, P = F * P * F^T + Q
+ *
+ * \details F = [1 dt dt^2/2; 0 1 dt; 0 0 1] is upper triangular with a unit
+ *          diagonal and Q has no cross term with the acceleration, so the six
+ *          unique entries of P are updated with 14 multiply-adds and 4
+ *          additions instead of two generic 3x3 products (54 multiply-adds)
+ *          and a 3x3 addition.
+ *
+ * \param   propagation             Propagation terms, see kalman_compute_propagation()
+ * \param   covariance              Packed covariance, updated in place
+ */
+static inline void kalman_propagate_packed_covariance(
+            const kalman_propagation_t* propagation,
+            kalman_packed_covariance_t* covariance)
+{
+    const float dt = propagation->delta_t;
+    const float h = propagation->half_dt2;
+
+    // F * P, rows 0 and 1 (row 2 is unchanged)
+    float fp_00 = covariance->pp + dt * covariance->pv + h * covariance->pa;
+    float fp_01 = covariance->pv + dt * covariance->vv + h * covariance->va;
+    float fp_02 = covariance->pa + dt * covariance->va + h * covariance->aa;
+    float fp_11 = covariance->vv + dt * covariance->va;
+    float fp_12 = covariance->va + dt * covariance->aa;
+
+    // (F * P) * F^T + Q, upper triangle
+    covariance->pp = fp_00 + dt * fp_01 + h * fp_02 + propagation->q_pp;
+    covariance->pv = fp_01 + dt * fp_02 + propagation->q_pv;
+    covariance->pa = fp_02;
+    covariance->vv = fp_11 + dt * fp_12 + propagation->q_vv;
+    covariance->va = fp_12;
+    covariance->aa += propagation->q_aa;
+}
+
+
 /**
  * \brief   Initialise the Kalman parameters
  *
@@ -95,6 +202,23 @@ uint8_t kalman_correct(
             track_following_t* track_following);
 
 
+/**
+ * \brief   Corrects the state & the state covariance with a given Kalman gain
+ *
+ * \details Split from kalman_correct() so that a cached steady-state gain
+ *          can be used instead of kalman_compute_gain()
+ *
+ * \param   kalman_handler          Pointer to the structure that contains all
+ *                                    the main Kalman parameters
+ * \param   measurement_residual    Pointer to the measurement residual vector
+ * \param   kalman_gain             Pointer to the Kalman gain matrix
+ */
+uint8_t kalman_apply_gain(
+            kalman_handler_t * kalman_handler,
+            const vector_3_t * measurement_residual,
+            const matrix_3x3_t * kalman_gain);
+
+
 /**
  * \brief   Computes the new measurement residual using the new measurement data
  *
@@ -124,6 +248,39 @@ uint8_t kalman_compute_gain(
             matrix_3x3_t * kalman_gain);
 
 
+/**
+ * \brief   Computes the inverse of the residual covariance matrix,
+ *            S^-1 = (H * P * H^T + R)^-1
+ *
+ * \details Also used to gate a measurement on its Mahalanobis distance
+ *          y^T * S^-1 * y before the gain is computed
+ *
+ * \param   kalman_handler          Pointer to the structure that contains all
+ *                                    the main Kalman parameters
+ * \param   residual_covariance_inv Pointer to the inverse of the residual
+ *                                    covariance matrix
+ */
+uint8_t kalman_compute_residual_covariance_inverse(
+            const kalman_handler_t * kalman_handler,
+            matrix_3x3_t * residual_covariance_inv);
+
+
+/**
+ * \brief   Computes the Kalman gain from the inverse of the residual
+ *            covariance matrix, K = P * H^T * S^-1
+ *
+ * \param   kalman_handler          Pointer to the structure that contains all
+ *                                    the main Kalman parameters
+ * \param   residual_covariance_inv Pointer to the inverse of the residual
+ *                                    covariance matrix
+ * \param   kalman_gain             Pointer to the Kalman gain matrix
+ */
+uint8_t kalman_compute_gain_from_inverse(
+            const kalman_handler_t * kalman_handler,
+            const matrix_3x3_t * residual_covariance_inv,
+            matrix_3x3_t * kalman_gain);
+
+
 #ifdef __cplusplus
 }
 #endif
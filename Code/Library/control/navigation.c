@@ -86,6 +86,13 @@ static void navigation_set_speed_command(float rel_pos[], navigation_t* navigati
  */
 static void navigation_run(local_coordinates_t waypoint_input, navigation_t* navigation);
 
+/**
+ * \brief						Flies the robot towards the intercept point of the followed neighbor with the velocity command of the track following
+ *
+ * \param	navigation			The navigation structure
+ */
+static void navigation_run_intercept(navigation_t* navigation);
+
 /**
  * \brief	Sets auto-takeoff procedure from a MAVLink command message MAV_CMD_NAV_TAKEOFF
  *
@@ -318,6 +325,42 @@ static void navigation_run(local_coordinates_t waypoint_input, navigation_t* nav
 	navigation->controls_nav->theading=waypoint_input.heading;
 }
 
+static void navigation_run_intercept(navigation_t* navigation)
+{
+	float rel_pos[3];
+	float vel_command[3];
+	float rel_heading = 0.0f;
+	quat_t qtmp1, qtmp2;
+	
+	if (!track_following_intercept_guidance(navigation->track_following, navigation->cruise_speed, navigation->max_climb_rate, vel_command))
+	{
+		// No prediction yet, fly to the last received position
+		navigation_run(navigation->waypoint_handler->waypoint_following,navigation);
+		return;
+	}
+	
+	navigation->waypoint_handler->dist2wp_sqr = navigation_set_rel_pos_n_dist2wp(navigation->waypoint_handler->waypoint_following.pos,
+																					rel_pos,
+																					navigation->position_estimator->local_position.pos);
+	
+	// Face the intercept point, unless it is right above or below
+	if ((maths_f_abs(rel_pos[X])>1.0f)||(maths_f_abs(rel_pos[Y])>1.0f))
+	{
+		rel_heading = maths_calc_smaller_angle(atan2(rel_pos[Y],rel_pos[X]) - navigation->position_estimator->local_position.heading);
+	}
+	
+	// Velocity command in body frame, the vertical speed is kept as is
+	qtmp1 = quaternions_create_from_vector(vel_command);
+	qtmp2 = quaternions_global_to_local(*navigation->qe,qtmp1);
+	
+	navigation->controls_nav->tvel[X] = qtmp2.v[0];
+	navigation->controls_nav->tvel[Y] = qtmp2.v[1];
+	navigation->controls_nav->tvel[Z] = vel_command[Z];
+	navigation->controls_nav->rpy[YAW] = KP_YAW * rel_heading;
+	
+	navigation->controls_nav->theading=navigation->waypoint_handler->waypoint_following.heading;
+}
+
 static mav_result_t navigation_set_auto_takeoff(navigation_t *navigation, mavlink_command_long_t* packet)
 {	
 	mav_result_t result;
@@ -929,7 +972,14 @@ task_return_t navigation_update(navigation_t* navigation)
 							
 							if ((!navigation->stop_nav)&&(navigation->track_following->neighbors->number_of_neighbors > 0))
 							{
-								navigation_run(navigation->waypoint_handler->waypoint_following,navigation);	
+								if (navigation->track_following->guidance == TRACK_FOLLOWING_GUIDANCE_INTERCEPT)
+								{
+									navigation_run_intercept(navigation);
+								}
+								else
+								{
+									navigation_run(navigation->waypoint_handler->waypoint_following,navigation);	
+								}
 							}
 							else
 							{
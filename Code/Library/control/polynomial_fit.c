@@ -0,0 +1,161 @@
+/*******************************************************************************
+ * \file polynomial_fit.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements a sliding-window weighted least-squares
+ *        quadratic fit of the position & velocity fixes of one axis
+ *
+ ******************************************************************************/
+
+#include "polynomial_fit.h"
+#include "small_matrix.h"
+#include "linear_algebra.h"
+
+
+// Add (sign = 1) or remove (sign = -1) one fix from the normal equations
+static void polynomial_fit_accumulate(polynomial_fit_t* fit, float t, float position, float velocity, float sign)
+{
+    const float wp = sign * POLYNOMIAL_FIT_POSITION_WEIGHT;
+    const float wv = sign * POLYNOMIAL_FIT_VELOCITY_WEIGHT;
+    const float half_t2 = 0.5f * t * t;
+
+    // Position fix, row [1, t, t^2/2]
+    fit->normal[0] += wp;
+    fit->normal[1] += wp * t;
+    fit->normal[2] += wp * half_t2;
+    fit->normal[3] += wp * t * t;
+    fit->normal[4] += wp * t * half_t2;
+    fit->normal[5] += wp * half_t2 * half_t2;
+    fit->projection[0] += wp * position;
+    fit->projection[1] += wp * t * position;
+    fit->projection[2] += wp * half_t2 * position;
+    fit->weighted_square_sum += wp * position * position;
+
+    // Velocity fix, row [0, 1, t]
+    fit->normal[3] += wv;
+    fit->normal[4] += wv * t;
+    fit->normal[5] += wv * t * t;
+    fit->projection[1] += wv * velocity;
+    fit->projection[2] += wv * t * velocity;
+    fit->weighted_square_sum += wv * velocity * velocity;
+}
+
+
+// Time of a fix relative to the reference of the sums (s)
+static float polynomial_fit_time(const polynomial_fit_t* fit, uint32_t time_ms)
+{
+    return (int32_t)(time_ms - fit->reference_time_ms) / 1000.0f;
+}
+
+
+// Rebuild the sums from the window, with the newest fix as time reference
+static void polynomial_fit_rebuild(polynomial_fit_t* fit)
+{
+    for(int i = 0; i < 6; i++) {
+        fit->normal[i] = 0.0f;
+    }
+    for(int i = 0; i < 3; i++) {
+        fit->projection[i] = 0.0f;
+    }
+    fit->weighted_square_sum = 0.0f;
+
+    fit->reference_time_ms = fit->time_ms[fit->head];
+
+    for(uint8_t age = 0; age < fit->count; age++) {
+        uint8_t i = (fit->head + POLYNOMIAL_FIT_WINDOW - age) % POLYNOMIAL_FIT_WINDOW;
+        polynomial_fit_accumulate(fit, polynomial_fit_time(fit, fit->time_ms[i]), fit->position[i], fit->velocity[i], 1.0f);
+    }
+
+    fit->updates = 0;
+}
+
+
+// Initialise a fit with an empty window
+void polynomial_fit_init(polynomial_fit_t* fit)
+{
+    fit->count = 0;
+    fit->head = POLYNOMIAL_FIT_WINDOW - 1;
+    fit->reference_time_ms = 0;
+
+    polynomial_fit_rebuild(fit);
+}
+
+
+// Add a fix to the window, dropping the oldest one if it is full
+uint8_t polynomial_fit_add(polynomial_fit_t* fit, uint32_t time_ms, float position, float velocity)
+{
+    uint8_t slot = (fit->head + 1) % POLYNOMIAL_FIT_WINDOW;
+
+    // Only newer fixes, a repeated time makes the normal matrix singular
+    if(fit->count > 0 && (int32_t)(time_ms - fit->time_ms[fit->head]) <= 0) {
+        return 0;
+    }
+
+    // Downdate, the oldest fix is overwritten
+    if(fit->count == POLYNOMIAL_FIT_WINDOW) {
+        polynomial_fit_accumulate(fit, polynomial_fit_time(fit, fit->time_ms[slot]), fit->position[slot], fit->velocity[slot], -1.0f);
+    } else {
+        fit->count++;
+    }
+
+    fit->time_ms[slot] = time_ms;
+    fit->position[slot] = position;
+    fit->velocity[slot] = velocity;
+    fit->head = slot;
+
+    // Update
+    fit->updates++;
+    if(fit->updates >= POLYNOMIAL_FIT_WINDOW) {
+        polynomial_fit_rebuild(fit);
+    } else {
+        polynomial_fit_accumulate(fit, polynomial_fit_time(fit, time_ms), position, velocity, 1.0f);
+    }
+
+    return 1;
+}
+
+
+// Solve the fit for the acceleration
+uint8_t polynomial_fit_get_acceleration(const polynomial_fit_t* fit, float* acceleration, float* variance)
+{
+    // 2 observations per fix, 3 parameters
+    if(fit->count < 2) {
+        return 0;
+    }
+
+    matrix_3x3_t normal =
+       {.v={{fit->normal[0], fit->normal[1], fit->normal[2]},
+            {fit->normal[1], fit->normal[3], fit->normal[4]},
+            {fit->normal[2], fit->normal[4], fit->normal[5]}} };
+    vector_3_t projection = {.v = {fit->projection[0], fit->projection[1], fit->projection[2]}};
+
+    // The normal matrix is positive semi-definite, so its determinant is at
+    // most the product of its diagonal. Fixes too close in time leave it
+    // (nearly) singular, the acceleration is then unknown.
+    float det = normal.v[0][0] * (normal.v[1][1] * normal.v[2][2] - normal.v[1][2] * normal.v[1][2])
+              - normal.v[0][1] * (normal.v[0][1] * normal.v[2][2] - normal.v[1][2] * normal.v[0][2])
+              + normal.v[0][2] * (normal.v[0][1] * normal.v[1][2] - normal.v[1][1] * normal.v[0][2]);
+    if(!(det > POLYNOMIAL_FIT_MIN_CONDITION * normal.v[0][0] * normal.v[1][1] * normal.v[2][2])) {
+        return 0;
+    }
+
+    // theta = (A^T * W * A)^-1 * A^T * W * z
+    matrix_3x3_t normal_inv = inv3(normal);
+    vector_3_t theta = mvmul3(normal_inv, projection);
+
+    // Weighted residual sum of squares, z^T * W * z - theta^T * A^T * W * z
+    float residual = fit->weighted_square_sum - sp3(theta, projection);
+    float dof = 2.0f * fit->count - 3.0f;
+    float scale = residual / dof;
+
+    // The weights are 1 / variance, only inflate when the fixes do not fit
+    if(scale < 1.0f) {
+        scale = 1.0f;
+    }
+
+    *acceleration = theta.v[2];
+    *variance = normal_inv.v[2][2] * scale;
+
+    return 1;
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * \file polynomial_fit.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief This file implements a sliding-window weighted least-squares
+ *        quadratic fit of the position & velocity fixes of one axis
+ *
+ * The fit p(t) = p0 + v0 * t + a * t^2 / 2 uses both the position and the
+ * velocity of the last POLYNOMIAL_FIT_WINDOW fixes. The normal equations are
+ * kept as running sums, so adding a fix and dropping the oldest one costs a
+ * constant time. The sums are rebuilt from the window once every
+ * POLYNOMIAL_FIT_WINDOW fixes, which moves the time reference to the newest
+ * fix and clears the round-off of the downdates.
+ *
+ ******************************************************************************/
+
+#ifndef POLYNOMIAL_FIT_H
+#define POLYNOMIAL_FIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define POLYNOMIAL_FIT_WINDOW 4                     ///< Number of fixes in the window
+#define POLYNOMIAL_FIT_POSITION_WEIGHT 1.0f         ///< Weight of a position fix, 1 / variance (1/m^2)
+#define POLYNOMIAL_FIT_VELOCITY_WEIGHT 100.0f       ///< Weight of a velocity fix, 1 / variance (s^2/m^2)
+#define POLYNOMIAL_FIT_MIN_CONDITION 1.0e-6f        ///< Smallest determinant of the normal matrix, relative to the product of its diagonal, that is solved
+
+
+/**
+ * \brief   Structure that contains the window & the normal equations of a fit
+ *
+ * \param   count                   Number of fixes in the window
+ * \param   head                    Index of the newest fix
+ * \param   updates                 Number of fixes added since the sums were
+ *                                    last rebuilt
+ * \param   time_ms                 Time of each fix (ms)
+ * \param   position                Position of each fix
+ * \param   velocity                Velocity of each fix
+ * \param   reference_time_ms       Time origin of the sums (ms)
+ * \param   normal                  Upper triangle of A^T * W * A
+ *                                    (00, 01, 02, 11, 12, 22)
+ * \param   projection              A^T * W * z
+ * \param   weighted_square_sum     z^T * W * z
+ */
+typedef struct polynomial_fit_t {
+    uint8_t count;
+    uint8_t head;
+    uint8_t updates;
+    uint32_t time_ms[POLYNOMIAL_FIT_WINDOW];
+    float position[POLYNOMIAL_FIT_WINDOW];
+    float velocity[POLYNOMIAL_FIT_WINDOW];
+    uint32_t reference_time_ms;
+    float normal[6];
+    float projection[3];
+    float weighted_square_sum;
+} polynomial_fit_t;
+
+
+/**
+ * \brief   Initialise a fit with an empty window
+ *
+ * \param   fit                     Pointer to the fit
+ */
+void polynomial_fit_init(polynomial_fit_t* fit);
+
+
+/**
+ * \brief   Add a fix to the window, dropping the oldest one if it is full
+ *
+ * \details A fix which is not newer than the newest one of the window (a
+ *          message sent again, or a sender clock with a coarse resolution)
+ *          is skipped, it would only repeat a time of the window.
+ *
+ * \param   fit                     Pointer to the fit
+ * \param   time_ms                 Time of the fix (ms)
+ * \param   position                Measured position
+ * \param   velocity                Measured velocity
+ *
+ * \return  1 if the fix was added, 0 if it was skipped
+ */
+uint8_t polynomial_fit_add(polynomial_fit_t* fit, uint32_t time_ms, float position, float velocity);
+
+
+/**
+ * \brief   Solve the fit for the acceleration
+ *
+ * \param   fit                     Pointer to the fit
+ * \param   acceleration            Pointer to the fitted acceleration
+ * \param   variance                Pointer to the variance of the fitted
+ *                                    acceleration
+ *
+ * \return  1 if the window holds enough fixes at distinct enough times,
+ *          0 otherwise (the acceleration & variance are then left unset)
+ */
+uint8_t polynomial_fit_get_acceleration(const polynomial_fit_t* fit, float* acceleration, float* variance);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
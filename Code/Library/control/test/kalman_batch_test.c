@@ -0,0 +1,574 @@
+/*******************************************************************************
+ * \file kalman_batch_test.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host test of the batched Kalman predictor
+ *
+ * \details The batched predictor (structure of arrays, packed covariance,
+ * steady-state gain cache) follows every track of a set of simulated targets.
+ * A scalar predictor follows the same targets with one kalman_handler_t per
+ * track and axis: dense propagation F * P * F^T + Q and kalman_correct(). It is
+ * given the same measurements, the same measured accelerations and the same
+ * noise, and both must agree: closely when the batched predictor computes
+ * every gain in full, within the tolerance of the gain cache when it uses it.
+ *
+ * The scale test runs TEST_SCALE_TRACKS tracks side by side, in as many
+ * independent batched predictors as needed, once with the gain cache and once
+ * with every gain computed in full. It checks the size of the packed
+ * covariances, that the covariances stay valid and the estimates close to the
+ * targets, and prints the throughput of both. With a fixed noise, it also
+ * checks that the tracks reach cached steady-state gains which keep the
+ * estimates of the full computation. The adapted noise follows the
+ * innovations, so both runs only agree when it is fixed.
+ *
+ * Build and run on the host with "make" in this directory.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "kalman_batch_predictor.h"
+#include "kalman_predictor.h"
+
+#define TEST_TICK_MS 10                         ///< Period of the predictions, as in the main loop (ms)
+#define TEST_MSG_PERIOD_MS 1000                 ///< Period of the messages of the targets (ms)
+#define TEST_DURATION_MS 120000                 ///< Simulated time (ms)
+#define TEST_MSG_STAGGER_MS 60                  ///< Time between the messages of two consecutive targets (ms)
+#define TEST_MAX_ACC 10.0f                      ///< Maximal acceleration given to both predictors (m/s^2)
+#define TEST_POSITION_NOISE 0.5f                ///< Spread of the position noise of the messages (m)
+#define TEST_VELOCITY_NOISE 0.2f                ///< Spread of the velocity noise of the messages (m/s)
+#define TEST_TOLERANCE 1.0e-4f                  ///< Relative tolerance when both predictors compute the gain in full
+#define TEST_CACHE_TOLERANCE (3.0f * KALMAN_GAIN_CACHE_TOLERANCE)  ///< Relative tolerance when the batched predictor uses cached gains
+#define TEST_SCALE_TRACKS 1000                  ///< Number of tracks of the scale test
+#define TEST_SCALE_COMPARE_MS 1000              ///< Period of the comparisons of the scale test (ms)
+#define TEST_SCALE_MIN_CACHED 0.75f             ///< Smallest share of the tracks converged & of the corrections made with a cached gain, with a fixed noise
+#define TEST_SCALE_MAX_POSITION_ERROR 1.0f      ///< Largest position error of a track at the end of the scale test (m)
+
+/**
+ * \brief   Scalar predictor of one track
+ */
+typedef struct
+{
+    kalman_handler_t axis[KALMAN_BATCH_AXES];           ///< One predictor per axis
+    polynomial_fit_t acceleration_fit[KALMAN_BATCH_AXES];   ///< Fits of the fixes, gives the measured acceleration
+} test_scalar_track_t;
+
+
+void print_util_dbg_print(const char* data)
+{
+    printf("%s", data);
+}
+
+
+/**
+ * \brief   Position & velocity of a simulated target, a circle with a slow
+ *          climb whose speed and radius depend on the target
+ */
+static void test_target_state(uint32_t target, uint32_t time_ms, float position[KALMAN_BATCH_AXES], float velocity[KALMAN_BATCH_AXES])
+{
+    float t = time_ms / 1000.0f;
+    float radius = 20.0f + 5.0f * (target % 7);
+    float rate = 0.05f + 0.01f * (target % 5);
+    float phase = 0.3f * target;
+    float climb = 0.1f * ((int32_t)(target % 3) - 1);
+
+    position[0] = radius * cosf(rate * t + phase);
+    position[1] = radius * sinf(rate * t + phase);
+    position[2] = -10.0f + climb * t;
+    velocity[0] = -radius * rate * sinf(rate * t + phase);
+    velocity[1] = radius * rate * cosf(rate * t + phase);
+    velocity[2] = climb;
+}
+
+
+/**
+ * \brief   Uniform noise of a given spread
+ */
+static float test_noise(float spread)
+{
+    return spread * (2.0f * rand() / (float)RAND_MAX - 1.0f);
+}
+
+
+/**
+ * \brief   Message of a simulated target, indexed [axis][component]
+ */
+static void test_target_measurement(uint32_t target, uint32_t time_ms, float measurement[KALMAN_BATCH_AXES][3])
+{
+    float position[KALMAN_BATCH_AXES];
+    float velocity[KALMAN_BATCH_AXES];
+
+    test_target_state(target, time_ms, position, velocity);
+
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        measurement[axis][0] = position[axis] + test_noise(TEST_POSITION_NOISE);
+        measurement[axis][1] = velocity[axis] + test_noise(TEST_VELOCITY_NOISE);
+        measurement[axis][2] = 0.0f;
+    }
+}
+
+
+/**
+ * \brief   Dense prediction, P = F * P * F^T + Q with generic 3x3 products
+ */
+static void test_dense_predict(kalman_handler_t* kalman_handler, float max_acc, float delta_t)
+{
+    kalman_propagation_t propagation = kalman_compute_propagation(max_acc, delta_t);
+
+    matrix_3x3_t state_propagation_matrix =
+       {.v={{1.0f, delta_t, propagation.half_dt2},
+            {0.0f, 1.0f,    delta_t},
+            {0.0f, 0.0f,    1.0f}} };
+
+    matrix_3x3_t process_noise_covariance =
+       {.v={{propagation.q_pp, propagation.q_pv, 0.0f},
+            {propagation.q_pv, propagation.q_vv, 0.0f},
+            {0.0f,             0.0f,             propagation.q_aa}} };
+
+    kalman_handler->state_estimate =
+        mvmul3(state_propagation_matrix, kalman_handler->state_estimate);
+
+    kalman_handler->state_estimate_covariance =
+        madd3(mmul3(state_propagation_matrix,
+                    mmul3(kalman_handler->state_estimate_covariance, trans3(state_propagation_matrix))),
+              process_noise_covariance);
+}
+
+
+/**
+ * \brief   Variance of a measured acceleration, rounded as kalman_batch_correct() does
+ */
+static float test_quantise_variance(float variance)
+{
+    int exponent;
+
+    if(!(variance > KALMAN_BATCH_MIN_ACC_VARIANCE)) {
+        variance = KALMAN_BATCH_MIN_ACC_VARIANCE;
+    } else if(variance > KALMAN_BATCH_MAX_ACC_VARIANCE) {
+        variance = KALMAN_BATCH_MAX_ACC_VARIANCE;
+    }
+
+    frexpf(variance, &exponent);
+
+    return ldexpf(1.0f, exponent);
+}
+
+
+/**
+ * \brief   Start the scalar predictor of a track, as kalman_batch_add_track() does
+ */
+static void test_scalar_add_track(test_scalar_track_t* scalar, const float measurement[KALMAN_BATCH_AXES][3], const kalman_batch_t* kalman_batch)
+{
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        kalman_init(&scalar->axis[axis], TEST_MAX_ACC, 0.0f);
+        scalar->axis[axis].measurement_covariance = kalman_batch->measurement_covariance;
+        scalar->axis[axis].state_estimate.v[0] = measurement[axis][0];
+        scalar->axis[axis].state_estimate.v[1] = measurement[axis][1];
+        polynomial_fit_init(&scalar->acceleration_fit[axis]);
+    }
+}
+
+
+/**
+ * \brief   Correct the scalar predictor of a track with the fixes and the
+ *          noise of the batched predictor
+ */
+static void test_scalar_correct(test_scalar_track_t* scalar, const float measurement[KALMAN_BATCH_AXES][3], uint32_t capture_time_ms, float position_variance, float velocity_variance)
+{
+    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+        kalman_handler_t* kalman_handler = &scalar->axis[axis];
+        float acceleration;
+        float acceleration_variance;
+        vector_3_t last_measurement;
+
+        polynomial_fit_add(&scalar->acceleration_fit[axis], capture_time_ms, measurement[axis][0], measurement[axis][1]);
+        if(!polynomial_fit_get_acceleration(&scalar->acceleration_fit[axis], &acceleration, &acceleration_variance)) {
+            acceleration = 0.0f;
+            acceleration_variance = KALMAN_BATCH_MAX_ACC_VARIANCE;
+        }
+
+        kalman_handler->measurement_covariance.v[0][0] = position_variance;
+        kalman_handler->measurement_covariance.v[1][1] = velocity_variance;
+        kalman_handler->measurement_covariance.v[2][2] = test_quantise_variance(acceleration_variance);
+
+        last_measurement.v[0] = measurement[axis][0];
+        last_measurement.v[1] = measurement[axis][1];
+        last_measurement.v[2] = acceleration;
+
+        kalman_correct(kalman_handler, &last_measurement, NULL);
+    }
+}
+
+
+/**
+ * \brief   Whether two values agree within a relative tolerance
+ */
+static int test_agree(float value, float reference, float tolerance)
+{
+    return fabsf(value - reference) <= tolerance * (1.0f + fabsf(reference));
+}
+
+
+/**
+ * \brief   Compare every track of the batched predictor to its scalar predictor
+ *
+ * \return  Number of values that disagree
+ */
+static uint32_t test_compare(const kalman_batch_t* kalman_batch, const test_scalar_track_t* scalar, float tolerance, float* max_state_error, float* max_covariance_error)
+{
+    uint32_t errors = 0;
+
+    for(uint8_t track = 0; track < kalman_batch->track_count; track++) {
+        for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+            const vector_3_t* x = &scalar[track].axis[axis].state_estimate;
+            const matrix_3x3_t* p = &scalar[track].axis[axis].state_estimate_covariance;
+            const float state[3] = {kalman_batch->pos[axis][track], kalman_batch->vel[axis][track], kalman_batch->acc[axis][track]};
+            const float covariance[6] = {kalman_batch->p_pp[axis][track], kalman_batch->p_pv[axis][track], kalman_batch->p_pa[axis][track],
+                                         kalman_batch->p_vv[axis][track], kalman_batch->p_va[axis][track], kalman_batch->p_aa[axis][track]};
+            const float reference_covariance[6] = {p->v[0][0], p->v[0][1], p->v[0][2], p->v[1][1], p->v[1][2], p->v[2][2]};
+
+            for(int i = 0; i < 3; i++) {
+                float error = fabsf(state[i] - x->v[i]) / (1.0f + fabsf(x->v[i]));
+                if(error > *max_state_error) {
+                    *max_state_error = error;
+                }
+                if(!test_agree(state[i], x->v[i], tolerance)) {
+                    errors++;
+                }
+            }
+
+            for(int i = 0; i < 6; i++) {
+                float error = fabsf(covariance[i] - reference_covariance[i]) / (1.0f + fabsf(reference_covariance[i]));
+                if(error > *max_covariance_error) {
+                    *max_covariance_error = error;
+                }
+                if(!test_agree(covariance[i], reference_covariance[i], tolerance)) {
+                    errors++;
+                }
+            }
+        }
+    }
+
+    return errors;
+}
+
+
+/**
+ * \brief   Run the batched and the scalar predictors side by side on
+ *          KALMAN_BATCH_MAX_TRACKS targets
+ *
+ * \param   use_gain_cache          Whether the batched predictor may use its
+ *                                    cached gains
+ *
+ * \return  Number of values that disagree
+ */
+static uint32_t test_equivalence(uint8_t use_gain_cache)
+{
+    static kalman_batch_t kalman_batch;
+    static test_scalar_track_t scalar[KALMAN_BATCH_MAX_TRACKS];
+    float measurement[KALMAN_BATCH_AXES][3];
+    float acceleration_variance[KALMAN_BATCH_AXES];
+    float tolerance = use_gain_cache ? TEST_CACHE_TOLERANCE : TEST_TOLERANCE;
+    float max_state_error = 0.0f;
+    float max_covariance_error = 0.0f;
+    uint32_t errors = 0;
+    uint32_t corrections = 0;
+    uint32_t cached_corrections = 0;
+
+    kalman_batch_init(&kalman_batch);
+
+    // Same noise for both predictors, every measurement is fused
+    kalman_batch.adaptation.enabled = 0;
+    kalman_batch.gate_threshold = INFINITY;
+
+    for(uint32_t time_ms = TEST_TICK_MS; time_ms <= TEST_DURATION_MS; time_ms += TEST_TICK_MS) {
+        kalman_batch_predict(&kalman_batch, TEST_MAX_ACC, TEST_TICK_MS / 1000.0f);
+        kalman_batch_record_history(&kalman_batch, time_ms);
+
+        for(uint8_t track = 0; track < kalman_batch.track_count; track++) {
+            for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+                test_dense_predict(&scalar[track].axis[axis], TEST_MAX_ACC, TEST_TICK_MS / 1000.0f);
+            }
+        }
+
+        // The targets start one after the other, then send in turn
+        for(uint32_t target = 0; target < KALMAN_BATCH_MAX_TRACKS; target++) {
+            if((time_ms + target * TEST_MSG_STAGGER_MS) % TEST_MSG_PERIOD_MS != 0) {
+                continue;
+            }
+
+            test_target_measurement(target, time_ms, measurement);
+
+            int16_t track = kalman_batch_find_track(&kalman_batch, target);
+            if(track < 0) {
+                track = kalman_batch_add_track(&kalman_batch, target, measurement, TEST_MAX_ACC, time_ms, time_ms);
+                kalman_batch_fit_acceleration(&kalman_batch, track, measurement, acceleration_variance, time_ms);
+
+                test_scalar_add_track(&scalar[track], measurement, &kalman_batch);
+                for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+                    polynomial_fit_add(&scalar[track].acceleration_fit[axis], time_ms, measurement[axis][0], measurement[axis][1]);
+                }
+            } else {
+                if(!use_gain_cache) {
+                    kalman_batch.gain_converged[track] = 0;
+                }
+                cached_corrections += kalman_batch.gain_converged[track];
+                corrections++;
+
+                test_scalar_correct(&scalar[track], measurement, time_ms, kalman_batch.adaptation.position_variance, kalman_batch.adaptation.velocity_variance);
+                kalman_batch_correct(&kalman_batch, track, measurement, TEST_MAX_ACC, time_ms, time_ms);
+            }
+        }
+
+        errors += test_compare(&kalman_batch, scalar, tolerance, &max_state_error, &max_covariance_error);
+    }
+
+    printf("Equivalence %s the gain cache: %u tracks, %lu corrections (%lu with a converged gain), largest relative error %.2e on the states, %.2e on the covariances, %lu errors\n",
+           use_gain_cache ? "with" : "without", kalman_batch.track_count, (unsigned long)corrections, (unsigned long)cached_corrections,
+           max_state_error, max_covariance_error, (unsigned long)errors);
+
+    // The gain cache must have been used
+    if(use_gain_cache && cached_corrections == 0) {
+        errors++;
+    }
+
+    return errors;
+}
+
+
+/**
+ * \brief   Time of a monotonic clock (s)
+ */
+static double test_clock(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return now.tv_sec + now.tv_nsec * 1.0e-9;
+}
+
+
+/**
+ * \brief   Whether the packed covariance of a track is a covariance: positive
+ *          variances and positive 2x2 principal minors
+ */
+static int test_valid_covariance(const kalman_batch_t* kalman_batch, int axis, uint8_t track)
+{
+    float pp = kalman_batch->p_pp[axis][track];
+    float pv = kalman_batch->p_pv[axis][track];
+    float pa = kalman_batch->p_pa[axis][track];
+    float vv = kalman_batch->p_vv[axis][track];
+    float va = kalman_batch->p_va[axis][track];
+    float aa = kalman_batch->p_aa[axis][track];
+
+    return pp > 0.0f && vv > 0.0f && aa > 0.0f &&
+           pp * vv - pv * pv >= 0.0f && pp * aa - pa * pa >= 0.0f && vv * aa - va * va >= 0.0f;
+}
+
+
+/**
+ * \brief   Run TEST_SCALE_TRACKS tracks in independent batched predictors,
+ *          with and without the gain cache
+ *
+ * \param   adaptive                Whether the noise adapts to the innovations
+ *
+ * \return  Number of failed checks
+ */
+static uint32_t test_scale(uint8_t adaptive)
+{
+    const uint32_t instance_count = (TEST_SCALE_TRACKS + KALMAN_BATCH_MAX_TRACKS - 1) / KALMAN_BATCH_MAX_TRACKS;
+    const float delta_t = TEST_TICK_MS / 1000.0f;
+    kalman_batch_t* cached = calloc(instance_count, sizeof(kalman_batch_t));
+    kalman_batch_t* full = calloc(instance_count, sizeof(kalman_batch_t));
+    float measurement[KALMAN_BATCH_AXES][3];
+    float acceleration_variance[KALMAN_BATCH_AXES];
+    float max_state_error = 0.0f;
+    float max_covariance_error = 0.0f;
+    float max_position_error = 0.0f;
+    double predict_time = 0.0;
+    double cached_time = 0.0;
+    double full_time = 0.0;
+    double start;
+    uint32_t errors = 0;
+    uint32_t corrections = 0;
+    uint32_t cached_corrections = 0;
+    uint32_t converged_tracks = 0;
+    uint32_t invalid_covariances = 0;
+
+    if(cached == NULL || full == NULL) {
+        printf("Scale: out of memory\n");
+        return 1;
+    }
+
+    // Six floats per covariance instead of nine, for the estimates & the history
+    if(sizeof(cached->p_pp) + sizeof(cached->p_pv) + sizeof(cached->p_pa) +
+       sizeof(cached->p_vv) + sizeof(cached->p_va) + sizeof(cached->p_aa) != 6 * KALMAN_BATCH_AXES * KALMAN_BATCH_MAX_TRACKS * sizeof(float) ||
+       sizeof(cached->history_covariance) != KALMAN_BATCH_HISTORY_SIZE * KALMAN_BATCH_AXES * 6 * KALMAN_BATCH_MAX_TRACKS * sizeof(float)) {
+        printf("Scale: the covariances are not packed\n");
+        errors++;
+    }
+
+    for(uint32_t instance = 0; instance < instance_count; instance++) {
+        kalman_batch_init(&cached[instance]);
+        kalman_batch_init(&full[instance]);
+        cached[instance].adaptation.enabled = adaptive;
+        full[instance].adaptation.enabled = adaptive;
+    }
+
+    for(uint32_t time_ms = TEST_TICK_MS; time_ms <= TEST_DURATION_MS; time_ms += TEST_TICK_MS) {
+        start = test_clock();
+        for(uint32_t instance = 0; instance < instance_count; instance++) {
+            kalman_batch_predict(&cached[instance], cached[instance].adaptation.max_acc, delta_t);
+            kalman_batch_record_history(&cached[instance], time_ms);
+        }
+        predict_time += test_clock() - start;
+
+        for(uint32_t instance = 0; instance < instance_count; instance++) {
+            kalman_batch_predict(&full[instance], full[instance].adaptation.max_acc, delta_t);
+            kalman_batch_record_history(&full[instance], time_ms);
+        }
+
+        // Messages are spread over the period
+        for(uint32_t target = 0; target < TEST_SCALE_TRACKS; target++) {
+            if((time_ms + (target % (TEST_MSG_PERIOD_MS / TEST_TICK_MS)) * TEST_TICK_MS) % TEST_MSG_PERIOD_MS != 0) {
+                continue;
+            }
+
+            kalman_batch_t* batch[2] = {&cached[target / KALMAN_BATCH_MAX_TRACKS], &full[target / KALMAN_BATCH_MAX_TRACKS]};
+            uint8_t neighbor_ID = target % KALMAN_BATCH_MAX_TRACKS;
+
+            test_target_measurement(target, time_ms, measurement);
+
+            for(int i = 0; i < 2; i++) {
+                start = test_clock();
+
+                int16_t track = kalman_batch_find_track(batch[i], neighbor_ID);
+                if(track < 0) {
+                    track = kalman_batch_add_track(batch[i], neighbor_ID, measurement, batch[i]->adaptation.max_acc, time_ms, time_ms);
+                    kalman_batch_fit_acceleration(batch[i], track, measurement, acceleration_variance, time_ms);
+                } else {
+                    if(i == 0) {
+                        cached_corrections += batch[i]->gain_converged[track];
+                        corrections++;
+                    } else {
+                        batch[i]->gain_converged[track] = 0;
+                    }
+                    kalman_batch_correct(batch[i], track, measurement, batch[i]->adaptation.max_acc, time_ms, time_ms);
+                }
+
+                if(i == 0) {
+                    cached_time += test_clock() - start;
+                } else {
+                    full_time += test_clock() - start;
+                }
+            }
+        }
+
+        if(!adaptive && time_ms % TEST_SCALE_COMPARE_MS == 0) {
+            for(uint32_t instance = 0; instance < instance_count; instance++) {
+                for(uint8_t track = 0; track < cached[instance].track_count; track++) {
+                    for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+                        const float state[6] = {cached[instance].pos[axis][track], cached[instance].vel[axis][track], cached[instance].acc[axis][track],
+                                                cached[instance].p_pp[axis][track], cached[instance].p_vv[axis][track], cached[instance].p_aa[axis][track]};
+                        const float reference[6] = {full[instance].pos[axis][track], full[instance].vel[axis][track], full[instance].acc[axis][track],
+                                                    full[instance].p_pp[axis][track], full[instance].p_vv[axis][track], full[instance].p_aa[axis][track]};
+
+                        for(int i = 0; i < 6; i++) {
+                            float error = fabsf(state[i] - reference[i]) / (1.0f + fabsf(reference[i]));
+                            float* max_error = (i < 3) ? &max_state_error : &max_covariance_error;
+                            if(error > *max_error) {
+                                *max_error = error;
+                            }
+                            if(!test_agree(state[i], reference[i], TEST_CACHE_TOLERANCE)) {
+                                errors++;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Every track must have reached a steady-state gain, with a valid
+    // covariance and an estimate close to its target
+    for(uint32_t target = 0; target < TEST_SCALE_TRACKS; target++) {
+        const kalman_batch_t* kalman_batch = &cached[target / KALMAN_BATCH_MAX_TRACKS];
+        int16_t track = kalman_batch_find_track(kalman_batch, target % KALMAN_BATCH_MAX_TRACKS);
+        float position[KALMAN_BATCH_AXES];
+        float velocity[KALMAN_BATCH_AXES];
+
+        if(track < 0) {
+            errors++;
+            continue;
+        }
+
+        converged_tracks += kalman_batch->gain_converged[track];
+
+        test_target_state(target, kalman_batch->time_ms, position, velocity);
+        for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+            float error = fabsf(kalman_batch->pos[axis][track] - position[axis]);
+            if(error > max_position_error) {
+                max_position_error = error;
+            }
+            if(!test_valid_covariance(kalman_batch, axis, track)) {
+                invalid_covariances++;
+            }
+        }
+    }
+
+    printf("Scale, %s noise: %u tracks in %lu predictors of %u bytes (%u bytes per track), %lu corrections (%lu with a converged gain), %lu tracks converged at the end\n",
+           adaptive ? "adaptive" : "fixed", TEST_SCALE_TRACKS, (unsigned long)instance_count, (unsigned)sizeof(kalman_batch_t), (unsigned)(sizeof(kalman_batch_t) / KALMAN_BATCH_MAX_TRACKS),
+           (unsigned long)corrections, (unsigned long)cached_corrections, (unsigned long)converged_tracks);
+    if(!adaptive) {
+        printf("Scale, fixed noise: largest relative error to the full computation %.2e on the states, %.2e on the variances\n",
+               max_state_error, max_covariance_error);
+    }
+    printf("Scale, %s noise: largest position error %.2f m, %lu invalid covariances, %lu errors\n",
+           adaptive ? "adaptive" : "fixed", max_position_error, (unsigned long)invalid_covariances, (unsigned long)errors);
+    printf("Scale, %s noise: %.1f s simulated, predictions %.3f s (%.2f us per track and tick), corrections %.3f s with the gain cache and %.3f s in full (%.2f us and %.2f us each)\n",
+           adaptive ? "adaptive" : "fixed", TEST_DURATION_MS / 1000.0f,
+           predict_time, 1.0e6 * predict_time / TEST_SCALE_TRACKS / (TEST_DURATION_MS / TEST_TICK_MS),
+           cached_time, full_time, 1.0e6 * cached_time / (corrections + TEST_SCALE_TRACKS), 1.0e6 * full_time / (corrections + TEST_SCALE_TRACKS));
+
+    if(!adaptive &&
+       (converged_tracks < TEST_SCALE_MIN_CACHED * TEST_SCALE_TRACKS ||
+        cached_corrections < TEST_SCALE_MIN_CACHED * corrections)) {
+        errors++;
+    }
+
+    if(invalid_covariances != 0 ||
+       max_position_error > TEST_SCALE_MAX_POSITION_ERROR) {
+        errors++;
+    }
+
+    free(cached);
+    free(full);
+
+    return errors;
+}
+
+
+int main(void)
+{
+    uint32_t errors = 0;
+
+    srand(1);
+
+    errors += test_equivalence(0);
+    errors += test_equivalence(1);
+    errors += test_scale(0);
+    errors += test_scale(1);
+
+    if(errors != 0) {
+        printf("FAILED\n");
+        return 1;
+    }
+
+    printf("PASSED\n");
+    return 0;
+}
@@ -0,0 +1,18 @@
+/*******************************************************************************
+ * \file mavlink_stream.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the MAVLink stream, only the types used by the track
+ *        following
+ *
+ ******************************************************************************/
+
+
+#ifndef MAVLINK_STREAM_H_
+#define MAVLINK_STREAM_H_
+
+typedef struct mavlink_stream_t mavlink_stream_t;
+typedef struct mavlink_message_t mavlink_message_t;
+
+#endif /* MAVLINK_STREAM_H_ */
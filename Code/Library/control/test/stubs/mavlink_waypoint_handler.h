@@ -0,0 +1,17 @@
+/*******************************************************************************
+ * \file mavlink_waypoint_handler.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the waypoint handler, only the types used by the track
+ *        following
+ *
+ ******************************************************************************/
+
+
+#ifndef MAVLINK_WAYPOINT_HANDLER_H_
+#define MAVLINK_WAYPOINT_HANDLER_H_
+
+typedef struct mavlink_waypoint_handler_t mavlink_waypoint_handler_t;
+
+#endif /* MAVLINK_WAYPOINT_HANDLER_H_ */
@@ -0,0 +1,35 @@
+/*******************************************************************************
+ * \file neighbor_selection.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the neighbor selection, only the types used by the
+ *        track following
+ *
+ ******************************************************************************/
+
+
+#ifndef NEIGHBOR_SELECTION_H_
+#define NEIGHBOR_SELECTION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MAX_NUM_NEIGHBORS 15                ///< The maximum number of neighbors, as on board
+
+typedef struct
+{
+    uint8_t neighbor_ID;                    ///< The MAVLink ID of the vehicle
+    float position[3];                      ///< The 3D position of the neighbor in m
+    float velocity[3];                      ///< The 3D velocity of the neighbor in m/s
+    uint32_t time_msg_received;             ///< The time at which the message was received in ms
+    uint32_t time_msg_sent;                 ///< The time at which the neighbor captured its position, in local time in ms
+} track_neighbor_t;
+
+typedef struct
+{
+    uint8_t number_of_neighbors;                    ///< The actual number of neighbors at a given time step
+    track_neighbor_t neighbors_list[MAX_NUM_NEIGHBORS];     ///< The list of neighbors structure
+} neighbors_t;
+
+#endif /* NEIGHBOR_SELECTION_H_ */
@@ -0,0 +1,17 @@
+/*******************************************************************************
+ * \file position_estimation.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the position estimation, only the types used by the
+ *        track following
+ *
+ ******************************************************************************/
+
+
+#ifndef POSITION_ESTIMATION_H_
+#define POSITION_ESTIMATION_H_
+
+typedef struct position_estimator_t position_estimator_t;
+
+#endif /* POSITION_ESTIMATION_H_ */
@@ -51,18 +51,74 @@
 #include "kalman_predictor.h"
 
 
+// PID controller on the position along x & y
+static const pid_controller_t track_following_pid_default =
+{
+    .p_gain = 5.0f,
+    .clip_min = -100.0f,
+    .clip_max = 100.0f,
+    .integrator={
+        .pregain = 0.1f,
+        .postgain = 0.1f,
+        .accumulator = 0.0f,
+        .maths_clip = 20.0f,
+        .leakiness = 0.0f
+    },
+    .differentiator={
+        .gain = 0.1f,
+        .previous = 0.0f,
+        .LPF = 0.5f,
+        .maths_clip = 5.0f
+    },
+    .output = 0.0f,
+    .error = 0.0f,
+    .last_update = 0.0f,
+    .dt = 1,
+    .soft_zone_width = 0.0f
+};
+
+
 void track_following_init(track_following_t* track_following, mavlink_waypoint_handler_t* waypoint_handler, neighbors_t* neighbors, position_estimator_t* position_estimator)
 {
     track_following->waypoint_handler = waypoint_handler;
     track_following->neighbors = neighbors;
     track_following->position_estimator = position_estimator;
 
-    track_following->dist2following = 0.0f;
+    kalman_batch_init(&track_following->kalman_batch);
+
+    track_following->predictor = TRACK_FOLLOWING_PREDICTOR_KALMAN;
+    imm_init(&track_following->imm, 0.1f, 0.5f, 1.0f, 0.2f);
+
+    track_following->guidance = TRACK_FOLLOWING_GUIDANCE_PID;
+
+    track_following_reset(track_following);
 
     print_util_dbg_print("[TRACK FOLLOWING] Initialized\r\n");
 }
 
 
+void track_following_reset(track_following_t* track_following)
+{
+    track_following->dist2following = 0.0f;
+
+    kalman_batch_reset(&track_following->kalman_batch);
+
+    // Start over from the next measurement
+    track_following->imm.initialised = 0;
+    track_following->imm_neighbor_ID = 0;
+    track_following->imm_last_measurement_time = 0;
+
+    track_following->intercept_time = 0.0f;
+
+    track_following->delta_t = 0.0f;
+    track_following->last_time_in_loop = time_keeper_get_millis();
+    track_following->last_measurement_time = 0;
+
+    track_following->pid_x = track_following_pid_default;
+    track_following->pid_y = track_following_pid_default;
+}
+
+
 void track_following_get_waypoint(track_following_t* track_following)
 {
     int16_t i;
@@ -84,121 +140,227 @@ void track_following_improve_waypoint_following(track_following_t* track_followi
     // Predict waypoint position with a Kalman algorithm
     track_following_kalman_predictor(track_following);
 
-    // Apply PID control on x & y
-    track_following_WP_control_PID(track_following);
+    // Apply PID control on x & y, the intercept guidance commands the
+    // velocity directly
+    if(track_following->guidance == TRACK_FOLLOWING_GUIDANCE_PID) {
+        track_following_WP_control_PID(track_following);
+    }
+}
+
+
+// Get the predicted state of the followed neighbor
+static bool track_following_get_target_state(
+            const track_following_t* track_following,
+            float position[3],
+            float velocity[3],
+            float acceleration[3])
+{
+    const imm_predictor_t* imm = &track_following->imm;
+    const kalman_batch_t* kalman_batch = &track_following->kalman_batch;
+    uint8_t neighbor_ID = track_following->neighbors->neighbors_list[0].neighbor_ID;
+
+    if(track_following->neighbors->number_of_neighbors == 0) {
+        return false;
+    }
+
+    if(track_following->predictor == TRACK_FOLLOWING_PREDICTOR_IMM) {
+        if(!imm->initialised || track_following->imm_neighbor_ID != neighbor_ID) {
+            return false;
+        }
+
+        for(int axis = 0; axis < 3; axis++) {
+            position[axis] = imm->estimate[axis].v[0];
+            velocity[axis] = imm->estimate[axis].v[1];
+            acceleration[axis] = imm->estimate[axis].v[2];
+        }
+    } else {
+        int16_t track = kalman_batch_find_track(kalman_batch, neighbor_ID);
+        if(track < 0) {
+            return false;
+        }
+
+        for(int axis = 0; axis < 3; axis++) {
+            position[axis] = kalman_batch->pos[axis][track];
+            velocity[axis] = kalman_batch->vel[axis][track];
+            acceleration[axis] = kalman_batch->acc[axis][track];
+        }
+    }
+
+    return true;
+}
+
+
+// Lead pursuit guidance towards the followed neighbor
+bool track_following_intercept_guidance(
+            track_following_t* track_following,
+            float max_speed,
+            float max_climb_rate,
+            float velocity_command[3])
+{
+    const float* own_position = track_following->position_estimator->local_position.pos;
+    float position[3], velocity[3], acceleration[3];
+    float intercept[3];
+    float time_to_go;
+    float distance;
+
+    if(!track_following_get_target_state(track_following, position, velocity, acceleration)) {
+        return false;
+    }
+
+    // First guess: the neighbor does not move
+    distance = 0.0f;
+    for(int axis = 0; axis < 3; axis++) {
+        distance += SQR(position[axis] - own_position[axis]);
+    }
+    time_to_go = maths_fast_sqrt(distance) / maths_f_max(max_speed, 0.1f);
+
+    for(int iteration = 0; iteration <= TRACK_FOLLOWING_INTERCEPT_ITERATIONS; iteration++) {
+        time_to_go = maths_f_min(maths_f_max(time_to_go, TRACK_FOLLOWING_INTERCEPT_MIN_TIME), TRACK_FOLLOWING_INTERCEPT_MAX_TIME);
+
+        // Predicted position of the neighbor after the time to go
+        distance = 0.0f;
+        for(int axis = 0; axis < 3; axis++) {
+            intercept[axis] = position[axis] + time_to_go * (velocity[axis] + 0.5f * time_to_go * acceleration[axis]);
+            distance += SQR(intercept[axis] - own_position[axis]);
+        }
+
+        if(iteration < TRACK_FOLLOWING_INTERCEPT_ITERATIONS) {
+            time_to_go = maths_fast_sqrt(distance) / maths_f_max(max_speed, 0.1f);
+        }
+    }
+
+    // Reach the intercept point in time
+    for(int axis = 0; axis < 3; axis++) {
+        velocity_command[axis] = (intercept[axis] - own_position[axis]) / time_to_go;
+        track_following->waypoint_handler->waypoint_following.pos[axis] = intercept[axis];
+    }
+    track_following->intercept_time = time_to_go;
+
+    // Respect the speed limits, keeping the horizontal direction
+    float horizontal_speed = maths_fast_sqrt(SQR(velocity_command[0]) + SQR(velocity_command[1]));
+    if(horizontal_speed > max_speed) {
+        velocity_command[0] *= max_speed / horizontal_speed;
+        velocity_command[1] *= max_speed / horizontal_speed;
+    }
+    velocity_command[2] = maths_clip(velocity_command[2], max_climb_rate);
+
+    return true;
+}
+
+
+// Run the IMM predictor on the followed neighbor
+static void track_following_imm_predictor(track_following_t* track_following, float delta_t, uint32_t time_ms)
+{
+    imm_predictor_t* imm = &track_following->imm;
+    const track_neighbor_t* neighbor = &track_following->neighbors->neighbors_list[0];
+
+    if(track_following->neighbors->number_of_neighbors == 0) {
+        return;
+    }
+
+    imm_predict(imm, delta_t);
+
+    if(neighbor->time_msg_received != track_following->imm_last_measurement_time) {
+        float measurement[IMM_AXES][2];
+
+        // Compensate the transmission delay with the measured velocity
+        float latency = (time_ms - neighbor->time_msg_sent) / 1000.0f;
+
+        for(int axis = 0; axis < IMM_AXES; axis++) {
+            measurement[axis][0] = neighbor->position[axis] + latency * neighbor->velocity[axis];
+            measurement[axis][1] = neighbor->velocity[axis];
+        }
+
+        if(!imm->initialised || neighbor->neighbor_ID != track_following->imm_neighbor_ID) {
+            imm_reset(imm, measurement);
+        } else {
+            imm_correct(imm, measurement);
+        }
+
+        track_following->imm_neighbor_ID = neighbor->neighbor_ID;
+        track_following->imm_last_measurement_time = neighbor->time_msg_received;
+    }
+
+    // Use IMM position prediction as waypoint
+    for(int axis = 0; axis < IMM_AXES; axis++) {
+        track_following->waypoint_handler->waypoint_following.pos[axis] = imm->estimate[axis].v[0];
+    }
 }
 
 
 // Handle the Kalman predictor
 void track_following_kalman_predictor(track_following_t* track_following)
 {
-    // Kalman variables for x, y and z axis
-    static kalman_handler_t kalman_handler_x, kalman_handler_y, kalman_handler_z;
-    static vector_3_t last_measurement_x, last_measurement_y, last_measurement_z;
-    // Kalman parameters
-    static float max_acc = 10.0f;
-    static float delta_t = 0.0f;
-    static uint32_t last_time_in_loop = 0;
+    kalman_batch_t* kalman_batch = &track_following->kalman_batch;
+    neighbors_t* neighbors = track_following->neighbors;
+
+    // Kalman parameters, max_acc adapts to the innovations of the targets
+    float max_acc = kalman_batch->adaptation.max_acc;
 
     // Update time tracker & delta_t
-    delta_t = (time_keeper_get_millis() - last_time_in_loop) / 1000.0f;
-    last_time_in_loop = time_keeper_get_millis();
-
-    // Initialise Kalman parameters once, and only once
-    static bool kalman_init_done = FALSE;
-    if(!kalman_init_done) {
-        kalman_init(&kalman_handler_x, max_acc, delta_t);
-        kalman_init(&kalman_handler_y, max_acc, delta_t);
-        kalman_init(&kalman_handler_z, max_acc, delta_t);
-        kalman_init_done = TRUE;
-    }
+    uint32_t time_ms = time_keeper_get_millis();
+    track_following->delta_t = (time_ms - track_following->last_time_in_loop) / 1000.0f;
+    track_following->last_time_in_loop = time_ms;
+    float delta_t = track_following->delta_t;
 
     /*
-        Call the Kalman prediction loop
+        Call the Kalman prediction loop for every track at once
         The prediction loop runs at higher rate than correction
      */
-    kalman_predict(&kalman_handler_x, max_acc, delta_t);
-    kalman_predict(&kalman_handler_y, max_acc, delta_t);
-    kalman_predict(&kalman_handler_z, max_acc, delta_t);
-
-    // Only correct the prediction if there is a new measurement
-    if(track_following_new_message_received(track_following)) {
-        /*
-            Use Bezier curve interpolation to get information about a previous
-            point velocity in order to compute a more accurate acceleration
-            on the x and y axis
-        */
-        vector_2_t p1, p2, p3, p4; // Control points for Bezier interpolation
-        vector_2_t bp; // Bezier estimated velocity
-        float t = 0.9f; // Bezier parameter
-
-        // Control point 1 : previous measured waypoint
-        p1.v[0] = last_measurement_x.v[0];
-        p1.v[1] = last_measurement_y.v[0];
-        // Control point 2 : prev. measured waypoint + velocity at that waypoint
-        p2.v[0] = p1.v[0] + last_measurement_x.v[1];
-        p2.v[1] = p1.v[1] + last_measurement_y.v[1];
-        // Control point 3 : current measured waypoint
-        p4.v[0] = track_following->neighbors->neighbors_list[0].position[0];
-        p4.v[1] = track_following->neighbors->neighbors_list[0].position[1];
-        // Control point 4 : previous measured waypoint
-        p3.v[0] = p4.v[0] - track_following->neighbors->neighbors_list[0].velocity[0];
-        p3.v[1] = p4.v[1] - track_following->neighbors->neighbors_list[0].velocity[1];
-
-        // Compute estimated velocity according to Bezier interpolation
-        bp.v[0] = 3 * (1 - t) * (1 - t) * (p2.v[0] - p1.v[0])
-                  + 6 * (1 - t) * t * (p3.v[0] - p2.v[0])
-                  + 3 * t * t * (p4.v[0] - p3.v[0]);
-        bp.v[1] = 3 * (1 - t) * (1 - t) * (p2.v[1] - p1.v[1])
-                  + 6 * (1 - t) * t * (p3.v[1] - p2.v[1])
-                  + 3 * t * t * (p4.v[1] - p3.v[1]);
-        bp.v[0] = bp.v[0] / 3.0f;
-        bp.v[1] = bp.v[1] / 3.0f;
-
-        /*
-            Use Bezier estimated velocity to compute more accurate acceleration along x and y
-         */
-        last_measurement_x.v[2] =
-            (track_following->neighbors->neighbors_list[0].velocity[0]
-            - bp.v[0]) / 0.4f;
-        last_measurement_y.v[2] =
-            (track_following->neighbors->neighbors_list[0].velocity[1]
-            - bp.v[1]) / 0.4f;
-
-        /*
-            Use less accurate estimate on acceleration along z using previous waypoint data
-         */
-        last_measurement_z.v[2] = (track_following->neighbors->neighbors_list[0].velocity[2] - last_measurement_z.v[1]) / 4.0f;
-
-        // Get last waypoint position data for x, y and z
-        last_measurement_x.v[0] =
-            track_following->neighbors->neighbors_list[0].position[0];
-        last_measurement_y.v[0] =
-            track_following->neighbors->neighbors_list[0].position[1];
-        last_measurement_z.v[0] =
-            track_following->neighbors->neighbors_list[0].position[2];
-
-        // Get last waypoint position data for x, y and z
-        last_measurement_x.v[1] =
-            track_following->neighbors->neighbors_list[0].velocity[0];
-        last_measurement_y.v[1] =
-            track_following->neighbors->neighbors_list[0].velocity[1];
-        last_measurement_z.v[1] =
-            track_following->neighbors->neighbors_list[0].velocity[2];
-
-        // Correct Kalman predictor with this new data
-        kalman_correct(&kalman_handler_x, &last_measurement_x, track_following);
-        kalman_correct(&kalman_handler_y, &last_measurement_y, track_following);
-        kalman_correct(&kalman_handler_z, &last_measurement_z, track_following);
+    kalman_batch_predict(kalman_batch, max_acc, delta_t);
+    kalman_batch_record_history(kalman_batch, time_ms);
+
+    // Only correct the tracks which received a new measurement
+    for(int i = 0; i < neighbors->number_of_neighbors; i++) {
+        const track_neighbor_t* neighbor = &neighbors->neighbors_list[i];
+        float measurement[KALMAN_BATCH_AXES][3];
+        float acceleration_variance[KALMAN_BATCH_AXES];
+
+        // Get last waypoint position & velocity data for x, y and z
+        for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+            measurement[axis][0] = neighbor->position[axis];
+            measurement[axis][1] = neighbor->velocity[axis];
+            measurement[axis][2] = 0.0f;
+        }
+
+        int16_t track = kalman_batch_find_track(kalman_batch, neighbor->neighbor_ID);
+
+        if(track < 0) {
+            // Only start tracks on fresh messages, stale neighbors stay dropped
+            if((time_ms - neighbor->time_msg_received) <= KALMAN_BATCH_TRACK_TIMEOUT_MS) {
+                track = kalman_batch_add_track(kalman_batch, neighbor->neighbor_ID, measurement, max_acc, neighbor->time_msg_received, neighbor->time_msg_sent);
+
+                // First fix of the acceleration fits
+                if(track >= 0) {
+                    kalman_batch_fit_acceleration(kalman_batch, track, measurement, acceleration_variance, neighbor->time_msg_sent);
+                }
+            }
+        } else if(neighbor->time_msg_received != kalman_batch->last_measurement_time[track]) {
+            // Correct Kalman predictor with this new data, at the time the
+            // neighbor captured it rather than when it was received. The
+            // acceleration comes from a fit of the last accepted fixes.
+            kalman_batch_correct(kalman_batch, track, measurement, max_acc, neighbor->time_msg_received, neighbor->time_msg_sent);
+        }
+    }
+
+    kalman_batch_remove_stale_tracks(kalman_batch, time_ms);
+
+    if(track_following->predictor == TRACK_FOLLOWING_PREDICTOR_IMM) {
+        track_following_imm_predictor(track_following, delta_t, time_ms);
+        return;
     }
 
-    // Use Kalman position prediction output as waypoint
-    track_following->waypoint_handler->waypoint_following.pos[0] =
-        kalman_handler_x.state_estimate.v[0];
-    track_following->waypoint_handler->waypoint_following.pos[1] =
-        kalman_handler_y.state_estimate.v[0];
-    track_following->waypoint_handler->waypoint_following.pos[2] =
-        kalman_handler_z.state_estimate.v[0];
+    // Start over from the next measurement if the IMM predictor is selected again
+    track_following->imm.initialised = 0;
+
+    // Use Kalman position prediction of the followed neighbor as waypoint
+    int16_t track = kalman_batch_find_track(kalman_batch, neighbors->neighbors_list[0].neighbor_ID);
+    if(track >= 0) {
+        for(int axis = 0; axis < KALMAN_BATCH_AXES; axis++) {
+            track_following->waypoint_handler->waypoint_following.pos[axis] =
+                kalman_batch->pos[axis][track];
+        }
+    }
 }
 
 
@@ -208,13 +370,10 @@ bool track_following_new_message_received(track_following_t* track_following)
     // Flag to signal the disponibility of a new measurement
     bool new_measurement_received = FALSE;
 
-    // Store the time when last measurement was received
-    static uint32_t last_measurement_time = 0;
-
     // Check if a new measurement has been received & set flag accordingly
-    if(track_following->neighbors->neighbors_list[0].time_msg_received != last_measurement_time) {
+    if(track_following->neighbors->neighbors_list[0].time_msg_received != track_following->last_measurement_time) {
         new_measurement_received = TRUE;
-        last_measurement_time =
+        track_following->last_measurement_time =
             track_following->neighbors->neighbors_list[0].time_msg_received;
     }
 
@@ -229,75 +388,23 @@ void track_following_WP_control_PID(track_following_t* track_following)
     float error = 0;
     float offset = 0;
 
-    // Initialise PID controller on position along x axis
-    static pid_controller_t track_following_pid_x =
-    {
-        .p_gain = 5.0f,
-        .clip_min = -100.0f,
-        .clip_max = 100.0f,
-        .integrator={
-            .pregain = 0.1f,
-            .postgain = 0.1f,
-            .accumulator = 0.0f,
-            .maths_clip = 20.0f,
-            .leakiness = 0.0f
-        },
-        .differentiator={
-            .gain = 0.1f,
-            .previous = 0.0f,
-            .LPF = 0.5f,
-            .maths_clip = 5.0f
-        },
-        .output = 0.0f,
-        .error = 0.0f,
-        .last_update = 0.0f,
-        .dt = 1,
-        .soft_zone_width = 0.0f
-    };
-
-    // Initialise PID controller on position along y axis
-    static pid_controller_t track_following_pid_y =
-    {
-        .p_gain = 5.0f,
-        .clip_min = -100.0f,
-        .clip_max = 100.0f,
-        .integrator={
-            .pregain = 0.1f,
-            .postgain = 0.1f,
-            .accumulator = 0.0f,
-            .maths_clip = 20.0f,
-            .leakiness = 0.0f
-        },
-        .differentiator={
-            .gain = 0.1f,
-            .previous = 0.0f,
-            .LPF = 0.5f,
-            .maths_clip = 5.0f
-        },
-        .output = 0.0f,
-        .error = 0.0f,
-        .last_update = 0.0f,
-        .dt = 1,
-        .soft_zone_width = 0.0f
-    };
-
     // Add Antirewind (ARW) to empty the integrator accumulator
-    if (track_following_pid_x.integrator.accumulator > 15.0f) {
-        track_following_pid_x.integrator.accumulator = 0.0f;
+    if (track_following->pid_x.integrator.accumulator > 15.0f) {
+        track_following->pid_x.integrator.accumulator = 0.0f;
     }
-    if (track_following_pid_y.integrator.accumulator > 15.0f) {
-        track_following_pid_y.integrator.accumulator = 0.0f;
+    if (track_following->pid_y.integrator.accumulator > 15.0f) {
+        track_following->pid_y.integrator.accumulator = 0.0f;
     }
 
     // Apply PID on position along x axis
     int i = 0;
     error = track_following_WP_distance_XYZ(track_following, i);
-    offset = pid_control_update(&track_following_pid_x, error);
+    offset = pid_control_update(&track_following->pid_x, error);
     track_following->waypoint_handler->waypoint_following.pos[i] += offset;
     // Apply PID on position along y axis
     i = 1;
     error = track_following_WP_distance_XYZ(track_following, i);
-    offset = pid_control_update(&track_following_pid_y, error);
+    offset = pid_control_update(&track_following->pid_y, error);
     track_following->waypoint_handler->waypoint_following.pos[i] += offset;
 }
 
@@ -331,3 +438,79 @@ void track_following_send_dist(const track_following_t* track_following, const m
                                         "dist2follow",
                                         track_following->dist2following);
 }
+
+
+void track_following_send_adaptation(const track_following_t* track_following, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg)
+{
+    const kalman_adaptation_t* adaptation = &track_following->kalman_batch.adaptation;
+
+    mavlink_msg_named_value_float_pack(    mavlink_stream->sysid,
+                                        mavlink_stream->compid,
+                                        msg,
+                                        time_keeper_get_millis(),
+                                        "KF_max_acc",
+                                        adaptation->max_acc);
+    mavlink_stream_send(mavlink_stream, msg);
+
+    mavlink_msg_named_value_float_pack(    mavlink_stream->sysid,
+                                        mavlink_stream->compid,
+                                        msg,
+                                        time_keeper_get_millis(),
+                                        "KF_R_pos",
+                                        adaptation->position_variance);
+    mavlink_stream_send(mavlink_stream, msg);
+
+    mavlink_msg_named_value_float_pack(    mavlink_stream->sysid,
+                                        mavlink_stream->compid,
+                                        msg,
+                                        time_keeper_get_millis(),
+                                        "KF_R_vel",
+                                        adaptation->velocity_variance);
+    mavlink_stream_send(mavlink_stream, msg);
+
+    mavlink_msg_named_value_float_pack(    mavlink_stream->sysid,
+                                        mavlink_stream->compid,
+                                        msg,
+                                        time_keeper_get_millis(),
+                                        "KF_NIS",
+                                        adaptation->normalised_innovation);
+}
+
+
+void track_following_send_rejections(const track_following_t* track_following, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg)
+{
+    const kalman_batch_t* kalman_batch = &track_following->kalman_batch;
+    int32_t total = 0;
+
+    for(uint8_t track = 0; track < kalman_batch->track_count; track++) {
+        // "rej_" followed by the MAVLink ID of the neighbor
+        char name[10] = "rej_";
+        uint8_t neighbor_ID = kalman_batch->neighbor_ID[track];
+        uint8_t c = 4;
+        if(neighbor_ID >= 100) {
+            name[c++] = '0' + neighbor_ID / 100;
+        }
+        if(neighbor_ID >= 10) {
+            name[c++] = '0' + (neighbor_ID / 10) % 10;
+        }
+        name[c++] = '0' + neighbor_ID % 10;
+        name[c] = '\0';
+
+        mavlink_msg_named_value_int_pack(    mavlink_stream->sysid,
+                                            mavlink_stream->compid,
+                                            msg,
+                                            time_keeper_get_millis(),
+                                            name,
+                                            kalman_batch->rejection_count[track]);
+        mavlink_stream_send(mavlink_stream, msg);
+
+        total += kalman_batch->rejection_count[track];
+    }
+
+    mavlink_msg_named_value_int_pack(    mavlink_stream->sysid,
+                                        mavlink_stream->compid,
+                                        msg,
+                                        time_keeper_get_millis(),
+                                        "rej_total",
+                                        total);
+}
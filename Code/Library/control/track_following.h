@@ -55,6 +55,30 @@ extern "C" {
 #include "position_estimation.h"
 #include "mavlink_stream.h"
 #include "pid_control.h"
+#include "kalman_batch_predictor.h"
+#include "imm_predictor.h"
+
+#define TRACK_FOLLOWING_INTERCEPT_MIN_TIME 1.0f			///< Shortest time to go of the intercept in s, sets the gain on the position error close to the neighbor
+#define TRACK_FOLLOWING_INTERCEPT_MAX_TIME 5.0f			///< Longest time to go of the intercept in s, the prediction is not trusted further
+#define TRACK_FOLLOWING_INTERCEPT_ITERATIONS 3			///< Number of fixed point iterations on the time to go
+
+/**
+ * \brief	The predictors of the position of the followed neighbor
+ */
+typedef enum
+{
+	TRACK_FOLLOWING_PREDICTOR_KALMAN = 0,					///< Constant acceleration Kalman predictor
+	TRACK_FOLLOWING_PREDICTOR_IMM = 1,						///< Interacting multiple model predictor (constant velocity, constant acceleration & coordinated turn)
+} track_following_predictor_t;
+
+/**
+ * \brief	The guidance laws towards the followed neighbor
+ */
+typedef enum
+{
+	TRACK_FOLLOWING_GUIDANCE_PID = 0,						///< PID on the position error to the predicted position
+	TRACK_FOLLOWING_GUIDANCE_INTERCEPT = 1,					///< Lead pursuit of the predicted intercept point, with a velocity command
+} track_following_guidance_t;
 
 typedef struct
 {
@@ -62,6 +86,18 @@ typedef struct
 	mavlink_waypoint_handler_t* waypoint_handler;			///< The pointer to the waypoint handler
 	neighbors_t* neighbors;									///< The pointer to the neighbor structure
 	position_estimator_t* position_estimator;				///< The pointer to the position estimation structure
+	kalman_batch_t kalman_batch;							///< The Kalman predictor of every neighbor
+	track_following_predictor_t predictor;					///< The predictor used for the followed neighbor
+	imm_predictor_t imm;									///< The IMM predictor of the followed neighbor
+	uint8_t imm_neighbor_ID;								///< The MAVLink ID of the neighbor followed by the IMM predictor
+	uint32_t imm_last_measurement_time;						///< The reception time of the last measurement fused by the IMM predictor in ms
+	track_following_guidance_t guidance;					///< The guidance law towards the followed neighbor
+	float intercept_time;									///< The time to go of the last intercept in s
+	float delta_t;											///< The time elapsed between the last two predictions in s
+	uint32_t last_time_in_loop;								///< The time of the last prediction in ms
+	uint32_t last_measurement_time;							///< The reception time of the last message of the followed neighbor in ms
+	pid_controller_t pid_x;									///< The PID controller on the position along x
+	pid_controller_t pid_y;									///< The PID controller on the position along y
 }track_following_t;
 
 /**
@@ -75,6 +111,15 @@ typedef struct
 void track_following_init(track_following_t* track_following, mavlink_waypoint_handler_t* waypoint_handler, neighbors_t* neighbors, position_estimator_t* position_estimator);
 
 
+/**
+ * \brief	Drop every track and restart the predictors & the PID controllers,
+ *			the settings (predictor, guidance, gate, noise adaptation) are kept
+ *
+ * \param	track_following			The pointer to the structure of the track following
+ */
+void track_following_reset(track_following_t* track_following);
+
+
 /**
  * \brief	Get the following waypoint
  *
@@ -118,6 +163,29 @@ bool track_following_new_message_received(track_following_t* track_following);
 void track_following_WP_control_PID(track_following_t* track_following);
 
 
+/**
+ * \brief   Lead pursuit guidance towards the followed neighbor
+ *
+ * \details The intercept point is the predicted position of the neighbor
+ *          after the time to go T, where T is the time needed to fly there at
+ *          max_speed (fixed point iterations, T is bounded by
+ *          TRACK_FOLLOWING_INTERCEPT_MIN_TIME and
+ *          TRACK_FOLLOWING_INTERCEPT_MAX_TIME). The velocity command reaches
+ *          the intercept point in T. Close to the neighbor, it comes down to
+ *          the velocity of the neighbor plus a proportional term on the
+ *          position error. The following waypoint is set to the intercept
+ *          point.
+ *
+ * \param   track_following         The pointer to the structure of the track following
+ * \param   max_speed               Maximal horizontal speed in m/s
+ * \param   max_climb_rate          Maximal vertical speed in m/s
+ * \param   velocity_command        Velocity command in local frame in m/s, set
+ *
+ * \return  True if the followed neighbor is tracked, false otherwise
+ */
+bool track_following_intercept_guidance(track_following_t* track_following, float max_speed, float max_climb_rate, float velocity_command[3]);
+
+
 /**
  * \brief   Get time since last waypoint was received
  *
@@ -137,6 +205,29 @@ float track_following_WP_distance_XYZ(track_following_t* track_following, int i)
 
 void track_following_send_dist(const track_following_t* track_following, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg);
 
+
+/**
+ * \brief   Send the noise values in use by the Kalman predictor (KF_max_acc,
+ *            KF_R_pos, KF_R_vel) and the mean normalised innovation squared
+ *            (KF_NIS)
+ *
+ * \param   track_following         The pointer to the structure of the track following
+ * \param   mavlink_stream          The pointer to the MAVLink stream structure
+ * \param   msg                     The pointer to the MAVLink message
+ */
+void track_following_send_adaptation(const track_following_t* track_following, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg);
+
+
+/**
+ * \brief   Send the number of measurements rejected by the gate, one named
+ *            value "rej_<ID>" per tracked neighbor, then the total "rej_total"
+ *
+ * \param   track_following         The pointer to the structure of the track following
+ * \param   mavlink_stream          The pointer to the MAVLink stream structure
+ * \param   msg                     The pointer to the MAVLink message
+ */
+void track_following_send_rejections(const track_following_t* track_following, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -46,6 +46,7 @@
 #include "gpio.h"
 #include "i2c_driver_int.h"
 #include "print_util.h"
+#include "time_keeper.h"
 
 #define LSM330_ACC_SLAVE_ADDRESS	0b0011000	///< Define the Accelerometer Address, as a slave on the i2c bus
 #define LSM330_GYRO_SLAVE_ADDRESS	0b1101010	///< Define the Gyroscope Address, as a slave on the i2c bus
@@ -167,6 +168,7 @@
 #define LSM_ACC_CTRL_REG1_ADDRESS		0x20	///< Define the first control register address of the accelerometer
 
 #define LSM_ACC_OUT_ADDRESS				0x27	///< Define the writing address of the accelerometer
+#define LSM_ACC_OUT_X_ADDRESS			0x28	///< Define the address of the first output register of the accelerometer
 
 #define LSM_ACC_FIFO_CTRL_ADDRESS		0x2E	///< Define the address of the FIFO control register, for the accelerometer
 #define LSM_ACC_FIFO_SRC_ADDRESS		0x2F	///< Define the address of the FIFO source(?) register, for the accelerometer
@@ -174,12 +176,28 @@
 #define LSM_GYRO_CTRL_REG1_ADDRESS		0x20	///< Define the first control register address of the gyroscope
 
 #define LSM_GYRO_OUT_ADDRESS			0x26	///< Define the writing address of the gyroscope
+#define LSM_GYRO_OUT_X_ADDRESS			0x28	///< Define the address of the first output register of the gyroscope
 
 #define LSM_GYRO_FIFO_CTRL_ADDRESS		0x2E	///< Define the address of the FIFO control register, for the gyroscope
 #define LSM_GYRO_FIFO_SRC_ADDRESS		0x2F	///< Define the address of the FIFO source(?) register, for the gyroscope
 
 #define LSM_AUTO_INCREMENT				0x80	///< Define the auto incrementation of the LSM330DLC sensor
 
+///< FIFO_CTRL_REG
+#define LSM_ACC_FIFO_MODE_STREAM		0x80	///< Stream mode of the accelerometer FIFO (FM1:0 = 10)
+#define LSM_GYRO_FIFO_MODE_STREAM		0x40	///< Stream mode of the gyroscope FIFO (FM2:0 = 010)
+
+///< FIFO_SRC_REG
+#define LSM_FIFO_FSS_MASK				0x1F	///< Number of unread samples in the FIFO
+#define LSM_FIFO_EMPTY					0x20	///< The FIFO is empty
+#define LSM_FIFO_OVRN					0x40	///< The FIFO is full and the oldest samples were overwritten
+
+#define LSM_FIFO_DEPTH					32		///< Number of samples in the FIFO of each sensor
+
+#define LSM_ACC_SAMPLE_PERIOD			2500.0f	///< Nominal sample period of the accelerometer at 400Hz (us)
+#define LSM_GYRO_SAMPLE_PERIOD			1315.8f	///< Nominal sample period of the gyroscope at 760Hz (us)
+#define LSM_PERIOD_WINDOW				1000	///< Number of samples used to measure the actual sample period
+
 
 /**
  * \brief Structure containing the configuration data of the accelerometer sensor. WARNING: start_address must 8-bits and the FIRST element. 
@@ -217,27 +235,6 @@ typedef struct
 	uint8_t start_address;		///< Define the start Address of the accelerometer sensor
 } lsm330dlc_gyro_read_conf_t;
 
-/**
- * \brief	Structure containing the accelerometer FIFO's data. WARNING: start_address must 8-bits and the LAST element.
- */
-typedef struct
-{
-	uint8_t status_register;	///< Define the status register of the FIFO of the accelerometer
-	int16_t axes[3];			///< Define an array containing the 3 axis of the accelerometer in the FIFO
-	uint8_t start_address;		///< Define the start Address of the accelerometer sensor
-} lsm_acc_read_t;
-
-/**
- * \brief	Structure containing the gyroscope FIFO's data. WARNING: start_address must 8-bits and the LAST element.
- */
-typedef struct
-{
-	int8_t temperature;			///< Define the temperature of the sensor
-	uint8_t status_register;	///< Define the status register of the FIFO of the gyroscope
-	int16_t axes[3];			///< Define an array containing the 3 axis of the gyroscope in the FIFO
-	uint8_t start_address;		///< Define the start Address of the accelerometer sensor
-} lsm_gyro_read_t;
-
 /**
  * \brief	Structure containing filling of the FIFO. WARNING: start_address must 8-bits and the LAST element.
  */
@@ -281,9 +278,45 @@ static const lsm330dlc_gyro_write_conf_t lsm_gyro_default_config=
 };
 
 /**
- * \brief	Declare the configuration of the FIFO
+ * \brief	Timing of the samples read from a FIFO
+ *
+ * The FIFO does not store the sample times. They are spaced by the measured 
+ * sample period, the newest sample of a batch being close to the read time.
+ */
+typedef struct
+{
+	uint32_t last_sample_time;	///< Time of the newest sample read (us)
+	float sample_period;		///< Measured sample period (us)
+	uint32_t window_start;		///< Start time of the period measurement (us)
+	uint32_t window_count;		///< Number of samples read since window_start
+} lsm_fifo_timing_t;
+
+
+/**
+ * \brief	Declare the configuration of the FIFO of the accelerometer
+*/
+static const uint8_t acc_fifo_config[2] = {LSM_ACC_FIFO_CTRL_ADDRESS, LSM_ACC_FIFO_MODE_STREAM};
+
+/**
+ * \brief	Declare the configuration of the FIFO of the gyroscope
 */
-static const uint8_t fifo_config[2] = {LSM_ACC_FIFO_CTRL_ADDRESS, 0x80};
+static const uint8_t gyro_fifo_config[2] = {LSM_GYRO_FIFO_CTRL_ADDRESS, LSM_GYRO_FIFO_MODE_STREAM};
+
+static lsm_fifo_timing_t lsm_acc_timing = 
+{
+	.last_sample_time = 0,
+	.sample_period = LSM_ACC_SAMPLE_PERIOD,
+	.window_start = 0,
+	.window_count = 0
+};
+
+static lsm_fifo_timing_t lsm_gyro_timing = 
+{
+	.last_sample_time = 0,
+	.sample_period = LSM_GYRO_SAMPLE_PERIOD,
+	.window_start = 0,
+	.window_count = 0
+};
 
 
 /**
@@ -340,6 +373,45 @@ static void	lsm330dlc_get_acc_config(void);
  */
 static void	lsm330dlc_get_gyro_config(void);
 
+/**
+ * \brief			Reads all the samples queued in the accelerometer FIFO, in one burst
+ *
+ * \param axes		Array where the samples are read, oldest first
+ *
+ * \return			The number of samples read
+ */
+static uint8_t lsm330dlc_acc_read_fifo(int16_t axes[LSM_FIFO_DEPTH][3]);
+
+/**
+ * \brief			Reads all the samples queued in the gyroscope FIFO, in one burst
+ *
+ * \param axes		Array where the samples are read, oldest first
+ *
+ * \return			The number of samples read
+ */
+static uint8_t lsm330dlc_gyro_read_fifo(int16_t axes[LSM_FIFO_DEPTH][3]);
+
+/**
+ * \brief			Computes the time of the first sample of a batch, and updates the sample period
+ *
+ * \param timing	The timing of the FIFO
+ * \param count		The number of samples in the batch
+ * \param now		The time of the read (us)
+ *
+ * \return			The time of the first sample of the batch (us)
+ */
+static uint32_t lsm330dlc_batch_start_time(lsm_fifo_timing_t* timing, uint8_t count, uint32_t now);
+
+/**
+ * \brief			Stores a batch of samples with their time in a sample buffer
+ *
+ * \param timing	The timing of the FIFO
+ * \param axes		The samples, oldest first
+ * \param count		The number of samples
+ * \param samples	The sample buffer
+ */
+static void lsm330dlc_store_batch(lsm_fifo_timing_t* timing, int16_t axes[LSM_FIFO_DEPTH][3], uint8_t count, sample_buffer_t* samples);
+
 
 static void lsm330dlc_acc_write_register(uint8_t* buffer, uint32_t nbytes) 
 {
@@ -366,13 +438,13 @@ static void lsm330dlc_gyro_read_register(uint8_t* address, uint8_t* buffer, uint
 static void lsm330dlc_acc_init(void) 
 {	
 	lsm330dlc_acc_write_register((uint8_t*) &lsm_acc_default_config, 5);
-	lsm330dlc_acc_write_register((uint8_t*) &fifo_config, 1);
+	lsm330dlc_acc_write_register((uint8_t*) &acc_fifo_config, 1);
 }
 
 static void lsm330dlc_gyro_init(void) 
 {
 	lsm330dlc_gyro_write_register((uint8_t*) &lsm_gyro_default_config, 5);
-	lsm330dlc_gyro_write_register((uint8_t*) &fifo_config, 1);
+	lsm330dlc_gyro_write_register((uint8_t*) &gyro_fifo_config, 1);
 }
 
 static void lsm330dlc_get_acc_config(void)
@@ -409,103 +481,216 @@ static void lsm330dlc_get_gyro_config(void)
 	}*/
 }
 
-void lsm330dlc_init(void) 
+static uint8_t lsm330dlc_acc_read_fifo(int16_t axes[LSM_FIFO_DEPTH][3])
 {
-	if(twim_probe(&AVR32_TWIM0, LSM330_ACC_SLAVE_ADDRESS) == STATUS_OK)
+	uint8_t count;
+	uint8_t address = LSM_ACC_OUT_X_ADDRESS | LSM_AUTO_INCREMENT;
+	lsm_read_fifo_fill_t read_fifo =
 	{
-		print_util_dbg_print("LSM330 sensor found (0x18) \r\n");
+		.fifo_fill = 0,
+		.start_address = LSM_ACC_FIFO_SRC_ADDRESS
+	};
+	
+	lsm330dlc_acc_read_register((uint8_t*)&read_fifo.start_address, (uint8_t*)&read_fifo.fifo_fill, 1);
+	
+	// the source register also holds the watermark, overrun and empty flags
+	if (read_fifo.fifo_fill & LSM_FIFO_EMPTY)
+	{
+		return 0;
+	}
+	else if (read_fifo.fifo_fill & LSM_FIFO_OVRN)
+	{
+		count = LSM_FIFO_DEPTH;
 	}
 	else
 	{
-		print_util_dbg_print("LSM330 sensor not responding (0x18) \r\n");
-		return;
-	} 
+		count = read_fifo.fifo_fill & LSM_FIFO_FSS_MASK;
+	}
 	
-	lsm330dlc_acc_init();
-	lsm330dlc_gyro_init();
-	lsm330dlc_get_acc_config();
-	lsm330dlc_get_gyro_config();
+	// in FIFO mode the address rolls back to OUT_X_L after OUT_Z_H, so one burst drains the FIFO
+	if (count > 0)
+	{
+		lsm330dlc_acc_read_register(&address, (uint8_t*)axes, 6 * count);
+	}
+	
+	return count;
 }
 
-void lsm330dlc_acc_update(accelerometer_t *lsm_acc_outputs) 
+static uint8_t lsm330dlc_gyro_read_fifo(int16_t axes[LSM_FIFO_DEPTH][3])
 {
-	lsm_acc_read_t fifo_values;
-	float axes[3] = {0.0f, 0.0f, 0.0f};
-	uint8_t i;
-	
-	fifo_values.start_address = LSM_ACC_OUT_ADDRESS | LSM_AUTO_INCREMENT ;
-
-	///< read number of bytes in fifo
+	uint8_t count;
+	uint8_t address = LSM_GYRO_OUT_X_ADDRESS | LSM_AUTO_INCREMENT;
 	lsm_read_fifo_fill_t read_fifo =
 	{
-		.fifo_fill = 1,
-		.start_address = LSM_ACC_FIFO_SRC_ADDRESS
+		.fifo_fill = 0,
+		.start_address = LSM_GYRO_FIFO_SRC_ADDRESS
 	};
 	
-	// Problem here: BUG with the accelerometer (attitude extremely non stable) ! ==> Skip the FIFO (set 1 in fifo_fill)
-	lsm330dlc_acc_read_register((uint8_t*)&read_fifo.start_address, (uint8_t*)&read_fifo.fifo_fill, 1);
+	lsm330dlc_gyro_read_register((uint8_t*)&read_fifo.start_address, (uint8_t*)&read_fifo.fifo_fill, 1);
+	
+	// the source register also holds the watermark, overrun and empty flags
+	if (read_fifo.fifo_fill & LSM_FIFO_EMPTY)
+	{
+		return 0;
+	}
+	else if (read_fifo.fifo_fill & LSM_FIFO_OVRN)
+	{
+		count = LSM_FIFO_DEPTH;
+	}
+	else
+	{
+		count = read_fifo.fifo_fill & LSM_FIFO_FSS_MASK;
+	}
+	
+	// in FIFO mode the address rolls back to OUT_X_L after OUT_Z_H, so one burst drains the FIFO
+	if (count > 0)
+	{
+		lsm330dlc_gyro_read_register(&address, (uint8_t*)axes, 6 * count);
+	}
+	
+	return count;
+}
+
+static uint32_t lsm330dlc_batch_start_time(lsm_fifo_timing_t* timing, uint8_t count, uint32_t now)
+{
+	uint32_t last_time = timing->last_sample_time + (uint32_t)(count * timing->sample_period);
+	int32_t drift = (int32_t)(now - last_time);
 	
-	if (read_fifo.fifo_fill > 0)
+	if ( (timing->last_sample_time == 0) || (count >= LSM_FIFO_DEPTH) || (drift < -(int32_t)timing->sample_period) || (drift > (int32_t)(2.0f * timing->sample_period)) )
 	{
-		if (read_fifo.fifo_fill > 1)
+		// first read, or samples lost in a full FIFO: start again from the read time
+		last_time = now;
+		
+		timing->window_start = now;
+		timing->window_count = 0;
+	}
+	else
+	{
+		// the newest sample was taken less than one period before the read,
+		// pulling the times back into that bound keeps them on the earliest read
+		if (drift < 0)
 		{
-			read_fifo.fifo_fill = 1;
+			last_time = now;
 		}
-		
-		for (i = 0; i < read_fifo.fifo_fill; i++)
+		else if (drift > (int32_t)timing->sample_period)
 		{
-			lsm330dlc_acc_read_register((uint8_t*)&fifo_values.start_address, (uint8_t*)&fifo_values.status_register, 7);
-
-			axes[0] += (float)((int16_t)fifo_values.axes[0]);
-			axes[1] += (float)((int16_t)fifo_values.axes[1]);
-			axes[2] += (float)((int16_t)fifo_values.axes[2]);
+			last_time = now - (uint32_t)timing->sample_period;
 		}
 		
-		lsm_acc_outputs->data[0] = axes[0] / read_fifo.fifo_fill;
-		lsm_acc_outputs->data[1] = axes[1] / read_fifo.fifo_fill;
-		lsm_acc_outputs->data[2] = axes[2] / read_fifo.fifo_fill;
+		timing->window_count += count;
 	}
+	
+	if (timing->window_count >= LSM_PERIOD_WINDOW)
+	{
+		// measure the period from the actual output data rate of the sensor
+		timing->sample_period = (float)(now - timing->window_start) / timing->window_count;
+		timing->window_start = now;
+		timing->window_count = 0;
+	}
+	
+	timing->last_sample_time = last_time;
+	
+	return last_time - (uint32_t)((count - 1) * timing->sample_period);
 }
 
-void lsm330dlc_gyro_update(gyroscope_t *lsm_gyro_outputs) 
+static void lsm330dlc_store_batch(lsm_fifo_timing_t* timing, int16_t axes[LSM_FIFO_DEPTH][3], uint8_t count, sample_buffer_t* samples)
 {
-	lsm_gyro_read_t fifo_values;
-	int16_t temperature = 0;
-	float axes[3] = {0.0f, 0.0f, 0.0f};
 	uint8_t i;
+	float data[3];
+	uint32_t first_time;
 	
-	fifo_values.start_address = LSM_GYRO_OUT_ADDRESS | LSM_AUTO_INCREMENT;
+	if (count == 0)
+	{
+		return;
+	}
 	
-	///< read number of bytes in fifo
-	lsm_read_fifo_fill_t read_fifo = 
+	first_time = lsm330dlc_batch_start_time(timing, count, time_keeper_get_micros());
+	
+	for (i = 0; i < count; i++)
 	{
-		.fifo_fill = 1,
-		.start_address = LSM_GYRO_FIFO_SRC_ADDRESS
-	};
+		data[0] = (float)axes[i][0];
+		data[1] = (float)axes[i][1];
+		data[2] = (float)axes[i][2];
+		sample_buffer_put_lossy(samples, data, first_time + (uint32_t)(i * timing->sample_period));
+	}
+}
+
+void lsm330dlc_init(void) 
+{
+	if(twim_probe(&AVR32_TWIM0, LSM330_ACC_SLAVE_ADDRESS) == STATUS_OK)
+	{
+		print_util_dbg_print("LSM330 sensor found (0x18) \r\n");
+	}
+	else
+	{
+		print_util_dbg_print("LSM330 sensor not responding (0x18) \r\n");
+		return;
+	} 
 	
-	// Problem here: BUG with the gyro ! ==> Skip the FIFO (set 1 in fifo_fill)
-	lsm330dlc_gyro_read_register((uint8_t*)&read_fifo.start_address, (uint8_t*)&read_fifo.fifo_fill, 1);
+	lsm330dlc_acc_init();
+	lsm330dlc_gyro_init();
+	lsm330dlc_get_acc_config();
+	lsm330dlc_get_gyro_config();
+}
+
+void lsm330dlc_acc_update(accelerometer_t *lsm_acc_outputs) 
+{
+	int16_t axes[LSM_FIFO_DEPTH][3];
+	float sum[3] = {0.0f, 0.0f, 0.0f};
+	uint8_t i, count;
 	
-	if (read_fifo.fifo_fill > 0)
+	count = lsm330dlc_acc_read_fifo(axes);
+	
+	if (count > 0)
 	{
-		if (read_fifo.fifo_fill > 1)
+		for (i = 0; i < count; i++)
 		{
-			read_fifo.fifo_fill = 1;
+			sum[0] += (float)axes[i][0];
+			sum[1] += (float)axes[i][1];
+			sum[2] += (float)axes[i][2];
 		}
 		
-		for (i = 0; i < read_fifo.fifo_fill; i++)
+		lsm_acc_outputs->data[0] = sum[0] / count;
+		lsm_acc_outputs->data[1] = sum[1] / count;
+		lsm_acc_outputs->data[2] = sum[2] / count;
+	}
+}
+
+void lsm330dlc_gyro_update(gyroscope_t *lsm_gyro_outputs) 
+{
+	int16_t axes[LSM_FIFO_DEPTH][3];
+	float sum[3] = {0.0f, 0.0f, 0.0f};
+	uint8_t i, count;
+	
+	count = lsm330dlc_gyro_read_fifo(axes);
+	
+	if (count > 0)
+	{
+		for (i = 0; i < count; i++)
 		{
-			lsm330dlc_gyro_read_register((uint8_t*)&fifo_values.start_address, (uint8_t*)&fifo_values.temperature, 8);
-			
-			temperature += (int16_t)fifo_values.temperature;
-			axes[0] += (float)((int16_t)fifo_values.axes[0]);
-			axes[1] += (float)((int16_t)fifo_values.axes[1]);
-			axes[2] += (float)((int16_t)fifo_values.axes[2]);
+			sum[0] += (float)axes[i][0];
+			sum[1] += (float)axes[i][1];
+			sum[2] += (float)axes[i][2];
 		}
 		
-		lsm_gyro_outputs->temperature = (int8_t)(temperature / read_fifo.fifo_fill);
-		lsm_gyro_outputs->data[0] = axes[0] / read_fifo.fifo_fill;
-		lsm_gyro_outputs->data[1] = axes[1] / read_fifo.fifo_fill;
-		lsm_gyro_outputs->data[2] = axes[2] / read_fifo.fifo_fill;
+		lsm_gyro_outputs->data[0] = sum[0] / count;
+		lsm_gyro_outputs->data[1] = sum[1] / count;
+		lsm_gyro_outputs->data[2] = sum[2] / count;
 	}
 }
+
+void lsm330dlc_acc_fifo_update(sample_buffer_t* samples)
+{
+	int16_t axes[LSM_FIFO_DEPTH][3];
+	uint8_t count = lsm330dlc_acc_read_fifo(axes);
+	
+	lsm330dlc_store_batch(&lsm_acc_timing, axes, count, samples);
+}
+
+void lsm330dlc_gyro_fifo_update(sample_buffer_t* samples)
+{
+	int16_t axes[LSM_FIFO_DEPTH][3];
+	uint8_t count = lsm330dlc_gyro_read_fifo(axes);
+	
+	lsm330dlc_store_batch(&lsm_gyro_timing, axes, count, samples);
+}
\ No newline at end of file
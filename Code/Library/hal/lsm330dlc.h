@@ -52,6 +52,7 @@
 #include <stdint.h>
 #include "gyroscope.h"
 #include "accelerometer.h"		
+#include "sample_buffer.h"
 
 /**
  * \brief	Structure containing the accelerometer's data
@@ -77,19 +78,33 @@ typedef struct
 void lsm330dlc_init(void);
 
 /**
- * \brief	Return the gyroscope's data
+ * \brief	Reads the mean of the gyroscope samples queued in the FIFO
  *
- * \return	A pointer to the gyroscope data structure
+ * \param	lsm_gyro_outputs	The gyroscope data structure
 */
 void lsm330dlc_gyro_update(gyroscope_t *lsm_gyro_outputs);
 
 /**
- * \brief	Return the accelerometer's data
+ * \brief	Reads the mean of the accelerometer samples queued in the FIFO
  *
- * \return	A pointer to the accelerometer data structure
+ * \param	lsm_acc_outputs		The accelerometer data structure
 */
 void lsm330dlc_acc_update(accelerometer_t *lsm_acc_outputs);
 
+/**
+ * \brief	Drains the gyroscope FIFO in one burst, and stores the samples with their time
+ *
+ * \param	samples		The buffer where the raw samples are stored
+*/
+void lsm330dlc_gyro_fifo_update(sample_buffer_t* samples);
+
+/**
+ * \brief	Drains the accelerometer FIFO in one burst, and stores the samples with their time
+ *
+ * \param	samples		The buffer where the raw samples are stored
+*/
+void lsm330dlc_acc_fifo_update(sample_buffer_t* samples);
+
 #ifdef __cplusplus
 	}
 #endif
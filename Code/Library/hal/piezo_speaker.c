@@ -133,7 +133,7 @@ void piezo_speaker_beep(int32_t duration_ms, int32_t frequency)
 	uint32_t now = time_keeper_get_micros();
 	uint32_t start = now;
 	
-	while( time_keeper_get_micros() < start + 1000 * duration_ms) 
+	while( time_keeper_get_micros() - start < (uint32_t)(1000 * duration_ms) ) 
 	{
 		piezo_speaker_set_value_binary(val);
 		val = -val;
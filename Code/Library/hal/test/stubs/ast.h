@@ -0,0 +1,66 @@
+/*******************************************************************************
+ * \file ast.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the AST driver, the registers are simulated by the test
+ *
+ ******************************************************************************/
+
+
+#ifndef AST_H_
+#define AST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "compiler.h"
+
+#define AST_OSC_PB 3
+
+#define AVR32_AST_SR_OVF_MASK 0x00000001
+#define AVR32_AST_SR_BUSY_MASK 0x01000000
+#define AVR32_AST_SCR_OVF_MASK 0x00000001
+#define AVR32_AST_SCR_ALARM0_MASK 0x00000100
+#define AVR32_AST_IER_OVF_MASK 0x00000001
+#define AVR32_AST_IER_ALARM0_MASK 0x00000100
+#define AVR32_AST_IDR_ALARM0_MASK 0x00000100
+
+#define AVR32_AST_ALARM_IRQ 1
+#define AVR32_AST_OVF_IRQ 2
+
+/**
+ * \brief	The registers of the AST used by the time keeper
+ */
+typedef struct
+{
+	uint32_t sr;						///< Status
+	uint32_t scr;						///< Status clear
+	uint32_t ier;						///< Interrupt enable
+	uint32_t idr;						///< Interrupt disable
+	uint32_t ar0;						///< Alarm 0
+} avr32_ast_t;
+
+/**
+ * \brief	Returns the simulated registers, after moving the simulated time on
+ */
+avr32_ast_t* test_ast_access(void);
+
+#define AVR32_AST (*test_ast_access())
+
+uint32_t ast_get_counter_value(volatile avr32_ast_t* ast);
+
+static inline int ast_init_counter(volatile avr32_ast_t* ast, uint8_t osc_type, uint8_t psel, uint32_t ast_counter)
+{
+	(void)ast;
+	(void)osc_type;
+	(void)psel;
+	(void)ast_counter;
+	return 1;
+}
+
+static inline void ast_enable(volatile avr32_ast_t* ast)
+{
+	(void)ast;
+}
+
+#endif /* AST_H_ */
\ No newline at end of file
@@ -0,0 +1,23 @@
+/*******************************************************************************
+ * \file compiler.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the compiler definitions used by the time keeper
+ *
+ ******************************************************************************/
+
+
+#ifndef COMPILER_H_
+#define COMPILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ISR(func, int_grp, int_lvl) static void func(void)
+
+#define Disable_global_interrupt()
+#define Enable_global_interrupt()
+
+#endif /* COMPILER_H_ */
\ No newline at end of file
@@ -0,0 +1,24 @@
+/*******************************************************************************
+ * \file intc.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the interrupt controller driver, the test takes the
+ *        registered handlers
+ *
+ ******************************************************************************/
+
+
+#ifndef INTC_H_
+#define INTC_H_
+
+#include "compiler.h"
+
+#define AVR32_INTC_INT1 1
+#define AVR32_INTC_INTLEV_INT1 1
+
+typedef void (*__int_handler)(void);
+
+void INTC_register_interrupt(__int_handler handler, uint32_t irq, uint32_t level);
+
+#endif /* INTC_H_ */
\ No newline at end of file
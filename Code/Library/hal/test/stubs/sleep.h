@@ -0,0 +1,26 @@
+/*******************************************************************************
+ * \file sleep.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the sleep modes of the power manager
+ *
+ ******************************************************************************/
+
+
+#ifndef SLEEP_H_
+#define SLEEP_H_
+
+#include "compiler.h"
+
+#define AVR32_PM_SMODE_IDLE 0
+#define AVR32_PM_SMODE_GMCLEAR_MASK 0x80
+
+/**
+ * \brief	Counts the sleeps, the simulated CPU wakes up at once
+ */
+void test_pm_sleep(uint32_t mode);
+
+#define pm_sleep(mode) test_pm_sleep(mode)
+
+#endif /* SLEEP_H_ */
\ No newline at end of file
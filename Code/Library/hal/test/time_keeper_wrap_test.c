@@ -0,0 +1,218 @@
+/*******************************************************************************
+ * \file time_keeper_wrap_test.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host test of the 64 bit time of the time keeper across AST wraps
+ *
+ * \details The AST registers are simulated (stubs/ast.h): the counter moves
+ * on at every register access, and the overflow interrupt fires at a random
+ * register access unless the interrupts are masked. The counter is kept just
+ * before a wrap most of the time, so that the overflow races every step of
+ * time_keeper_get_time_ticks64(): the retry on a change of the overflow count,
+ * and an overflow still pending while the interrupts are masked.
+ *
+ * time_keeper_sleep_until64() is also checked not to sleep once its wake-up
+ * flag is set, as by a task signalled from an interrupt.
+ *
+ * Build and run on the host with "make" in this directory.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "time_keeper.h"
+#include "intc.h"
+
+#define TEST_WRAP_COUNT 256						///< Number of counter wraps to go through
+#define TEST_MAX_READS 100000000				///< Reads after which the test stops anyway
+#define TEST_NEAR_WRAP 0xFFFFE000				///< Counter value jumped to between wraps
+
+avr32_ast_t test_ast;							///< The simulated AST registers
+
+static uint64_t true_ticks = 0;					///< The simulated time, the counter is its lower 32 bits
+static bool interrupts_enabled = false;			///< Whether the simulated CPU takes interrupts
+static bool in_interrupt = false;				///< Whether the overflow interrupt is being handled
+static __int_handler overflow_handler = NULL;	///< The handler registered for the AST overflow
+static uint32_t handled_overflows = 0;			///< Number of overflow interrupts taken
+static uint32_t sleeps = 0;						///< Number of times the CPU was put to sleep
+
+
+/**
+ * \brief	Moves the simulated time on, and takes the overflow interrupt at random
+ */
+static void test_ast_advance(void)
+{
+	uint32_t previous = (uint32_t)true_ticks;
+
+	// Status bits are cleared by writing to SCR
+	test_ast.sr &= ~test_ast.scr;
+	test_ast.scr = 0;
+
+	true_ticks += rand() % 4;
+	if ((uint32_t)true_ticks < previous)
+	{
+		test_ast.sr |= AVR32_AST_SR_OVF_MASK;
+	}
+
+	if (!in_interrupt && interrupts_enabled && (overflow_handler != NULL)
+		&& (test_ast.ier & AVR32_AST_IER_OVF_MASK) && (test_ast.sr & AVR32_AST_SR_OVF_MASK)
+		&& (rand() % 3 == 0))
+	{
+		in_interrupt = true;
+		overflow_handler();
+		in_interrupt = false;
+		handled_overflows++;
+
+		test_ast.sr &= ~test_ast.scr;
+		test_ast.scr = 0;
+	}
+}
+
+
+avr32_ast_t* test_ast_access(void)
+{
+	test_ast_advance();
+	return &test_ast;
+}
+
+
+uint32_t ast_get_counter_value(volatile avr32_ast_t* ast)
+{
+	(void)ast;
+	test_ast_advance();
+	return (uint32_t)true_ticks;
+}
+
+
+void test_pm_sleep(uint32_t mode)
+{
+	(void)mode;
+	sleeps++;
+}
+
+
+/**
+ * \brief	Checks when time_keeper_sleep_until64() puts the CPU to sleep
+ *
+ * \return	The number of errors
+ */
+static uint32_t test_sleep(void)
+{
+	volatile bool wake_flag = false;
+	uint64_t now = time_keeper_get_micros64();
+	uint32_t errors = 0;
+
+	interrupts_enabled = true;
+
+	// Sleeps until a later time, with or without flag
+	sleeps = 0;
+	time_keeper_sleep_until64(now + 100000, NULL);
+	time_keeper_sleep_until64(now + 100000, &wake_flag);
+	if (sleeps != 2)
+	{
+		printf("Did not sleep until a later time\n");
+		errors++;
+	}
+
+	// Not for less than TK_MIN_SLEEP_TICKS, nor once a signal set the flag
+	sleeps = 0;
+	time_keeper_sleep_until64(time_keeper_get_micros64(), NULL);
+	wake_flag = true;
+	time_keeper_sleep_until64(now + 100000, &wake_flag);
+	if (sleeps != 0)
+	{
+		printf("Slept with the wake-up flag set or no time to sleep\n");
+		errors++;
+	}
+
+	return errors;
+}
+
+
+void INTC_register_interrupt(__int_handler handler, uint32_t irq, uint32_t level)
+{
+	(void)level;
+	if (irq == AVR32_AST_OVF_IRQ)
+	{
+		overflow_handler = handler;
+	}
+}
+
+
+int main(void)
+{
+	uint64_t before, ticks, after;
+	uint64_t last_ticks = 0;
+	uint32_t last_millis = 0;
+	uint32_t millis;
+	uint32_t masked_wraps = 0;
+	uint32_t errors = 0;
+	uint32_t reads = 0;
+	bool masked;
+
+	srand(1);
+	true_ticks = TEST_NEAR_WRAP;
+
+	time_keeper_init();
+	time_keeper_init_interrupt();
+
+	while ((true_ticks >> 32) < TEST_WRAP_COUNT && reads < TEST_MAX_READS)
+	{
+		// Reads from masked sections, where the overflow stays pending
+		masked = (rand() % 8) == 0;
+		interrupts_enabled = !masked;
+
+		before = true_ticks;
+		ticks = time_keeper_get_time_ticks64();
+		after = true_ticks;
+
+		if ((ticks < before) || (ticks > after) || (ticks < last_ticks))
+		{
+			if (errors < 5)
+			{
+				printf("Wrong ticks %llx, expected [%llx, %llx], last %llx\n", (unsigned long long)ticks, (unsigned long long)before, (unsigned long long)after, (unsigned long long)last_ticks);
+			}
+			errors++;
+		}
+		else if (masked && (test_ast.sr & AVR32_AST_SR_OVF_MASK) && ((uint32_t)ticks < 0x80000000))
+		{
+			masked_wraps++;
+		}
+		last_ticks = ticks;
+
+		millis = time_keeper_get_millis();
+		if ((int32_t)(millis - last_millis) < 0)
+		{
+			if (errors < 5)
+			{
+				printf("Milliseconds went back from %lu to %lu\n", (unsigned long)last_millis, (unsigned long)millis);
+			}
+			errors++;
+		}
+		last_millis = millis;
+
+		reads++;
+
+		// Skip to just before the next wrap
+		if (((uint32_t)true_ticks > 0x00100000) && ((uint32_t)true_ticks < TEST_NEAR_WRAP))
+		{
+			true_ticks = (true_ticks & 0xFFFFFFFF00000000ULL) | TEST_NEAR_WRAP;
+		}
+	}
+
+	errors += test_sleep();
+
+	printf("%lu reads, %llu wraps, %lu overflow interrupts, %lu reads with a pending overflow, %lu errors\n", (unsigned long)reads, (unsigned long long)(true_ticks >> 32), (unsigned long)handled_overflows, (unsigned long)masked_wraps, (unsigned long)errors);
+
+	// The race must have been exercised, and never lost
+	if ((true_ticks >> 32) < TEST_WRAP_COUNT || handled_overflows == 0 || masked_wraps == 0 || errors != 0)
+	{
+		printf("FAILED\n");
+		return 1;
+	}
+
+	printf("PASSED\n");
+	return 0;
+}
\ No newline at end of file
@@ -41,6 +41,33 @@
 
 
 #include "time_keeper.h"
+#include "intc.h"
+#include "sleep.h"
+
+static volatile uint32_t time_keeper_overflows = 0;		///< Number of overflows of the AST counter, upper 32 bits of the time ticks
+
+/**
+ * \brief	Interrupt service routine of the AST counter overflow
+ */
+ISR(time_keeper_overflow_handler, AVR32_AST_OVF_IRQ, AVR32_INTC_INTLEV_INT1)
+{
+	// Wait until the AST registers are up-to-date
+	while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+	AVR32_AST.scr = AVR32_AST_SCR_OVF_MASK;
+
+	time_keeper_overflows++;
+}
+
+/**
+ * \brief	Interrupt service routine of the AST alarm, which only wakes the CPU up
+ */
+ISR(time_keeper_alarm_handler, AVR32_AST_ALARM_IRQ, AVR32_INTC_INTLEV_INT1)
+{
+	while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+	AVR32_AST.idr = AVR32_AST_IDR_ALARM0_MASK;
+	while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+	AVR32_AST.scr = AVR32_AST_SCR_ALARM0_MASK;
+}
 
 void time_keeper_init()
 {
@@ -48,16 +75,28 @@ void time_keeper_init()
 	ast_enable(&AVR32_AST);
 }
 
+void time_keeper_init_interrupt()
+{
+	INTC_register_interrupt( (__int_handler) &time_keeper_overflow_handler, AVR32_AST_OVF_IRQ, AVR32_INTC_INT1);
+
+	while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+	AVR32_AST.scr = AVR32_AST_SCR_OVF_MASK;
+	while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+	AVR32_AST.ier = AVR32_AST_IER_OVF_MASK;
+
+	INTC_register_interrupt( (__int_handler) &time_keeper_alarm_handler, AVR32_AST_ALARM_IRQ, AVR32_INTC_INT1);
+}
+
 double time_keeper_get_time()
 {
 	// time in seconds since system start
-	return time_keeper_ticks_to_seconds(time_keeper_get_time_ticks());
+	return (double)time_keeper_get_time_ticks64() / (double)TK_AST_FREQUENCY;
 }
 
 uint32_t time_keeper_get_millis()
 {
-	//milliseconds since system start
-	return time_keeper_get_time_ticks() / 1000; /// (TK_AST_FREQUENCY / 1000);
+	//milliseconds since system start, runs over after 49 days
+	return time_keeper_get_time_ticks64() / (TK_AST_FREQUENCY / 1000);
 }
 
 uint32_t time_keeper_get_micros()
@@ -66,12 +105,42 @@ uint32_t time_keeper_get_micros()
 	return time_keeper_get_time_ticks() * (1000000 / TK_AST_FREQUENCY);
 }
 
+uint64_t time_keeper_get_micros64()
+{
+	// microseconds since system start
+	return time_keeper_get_time_ticks64() * (1000000 / TK_AST_FREQUENCY);
+}
+
 uint32_t time_keeper_get_time_ticks()
 {
 	//raw timer ticks
 	return ast_get_counter_value(&AVR32_AST);
 }
 
+uint64_t time_keeper_get_time_ticks64()
+{
+	uint32_t overflows;
+	uint32_t ticks;
+	bool overflow_pending;
+
+	do
+	{
+		overflows = time_keeper_overflows;
+		ticks = ast_get_counter_value(&AVR32_AST);
+		overflow_pending = (AVR32_AST.sr & AVR32_AST_SR_OVF_MASK) != 0;
+	}
+	while (overflows != time_keeper_overflows);
+
+	// The counter ran over but the interrupt is not handled yet (interrupts 
+	// masked): the ticks were read after the overflow if they are small
+	if (overflow_pending && (ticks < 0x80000000))
+	{
+		overflows++;
+	}
+
+	return ((uint64_t)overflows << 32) | ticks;
+}
+
 float time_keeper_ticks_to_seconds(uint32_t timer_ticks)
 {
 	return ((double)timer_ticks / (double)TK_AST_FREQUENCY);
@@ -79,11 +148,45 @@ float time_keeper_ticks_to_seconds(uint32_t timer_ticks)
 
 void time_keeper_delay_micros(int32_t microseconds)
 {
-	uint32_t now = time_keeper_get_micros();
-	while (time_keeper_get_micros() < now + microseconds);
+	time_keeper_delay_until64(time_keeper_get_micros64() + microseconds);
 }
 
 void time_keeper_delay_until(uint32_t until_time)
 {
-	while (time_keeper_get_micros() < until_time);
+	while ((int32_t)(until_time - time_keeper_get_micros()) > 0);
+}
+
+void time_keeper_delay_until64(uint64_t until_time)
+{
+	while (time_keeper_get_micros64() < until_time);
+}
+
+void time_keeper_sleep_until64(uint64_t until_time, const volatile bool* wake_flag)
+{
+	uint64_t until_ticks = until_time / (1000000 / TK_AST_FREQUENCY);
+
+	// Neither the alarm nor an interrupt setting the flag may fire between the checks and the sleep
+	Disable_global_interrupt();
+
+	if (((wake_flag == NULL) || !*wake_flag) && (time_keeper_get_time_ticks64() + TK_MIN_SLEEP_TICKS < until_ticks))
+	{
+		// 32 bit alarm: a sleep longer than the counter period ends early
+		while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+		AVR32_AST.ar0 = (uint32_t)until_ticks;
+		while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+		AVR32_AST.scr = AVR32_AST_SCR_ALARM0_MASK;
+		while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+		AVR32_AST.ier = AVR32_AST_IER_ALARM0_MASK;
+
+		// Unmasks the interrupts when entering the sleep mode, any interrupt wakes the CPU up
+		pm_sleep(AVR32_PM_SMODE_GMCLEAR_MASK | AVR32_PM_SMODE_IDLE);
+
+		// Woken up by another interrupt
+		while (AVR32_AST.sr & AVR32_AST_SR_BUSY_MASK);
+		AVR32_AST.idr = AVR32_AST_IDR_ALARM0_MASK;
+	}
+	else
+	{
+		Enable_global_interrupt();
+	}
 }
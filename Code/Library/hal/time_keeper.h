@@ -48,16 +48,27 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "ast.h"
 
 #define TK_AST_FREQUENCY 1000000					///< Timer ticks per second (32 bit timer, >1h time-out at 1MHz, >years at 1kHz. We'll go for precision here...)
 #define AST_PRESCALER_SETTING 5						///< Log(SOURCE_CLOCK/AST_FREQ)/log(2)-1 when running from PBA (64Mhz), 5 (1Mhz), or 15 (~1khz, not precisely though).
+#define TK_MIN_SLEEP_TICKS 20						///< Shortest sleep, the alarm must be set before the counter reaches it
 
 /** 
  * \brief	This function initialize the clock of the microcontroller
  */
 void time_keeper_init(void);
 
+/** 
+ * \brief	This function enables the overflow interrupt of the clock, needed 
+ *			to extend the time to 64 bits, and the alarm interrupt which wakes 
+ *			the CPU up from time_keeper_sleep_until64()
+ *
+ * \warning	Should be called after INTC_init_interrupts()
+ */
+void time_keeper_init_interrupt(void);
+
 /** 
  * \brief	This function returns the time in seconds since system start
  * 
@@ -75,19 +86,39 @@ uint32_t time_keeper_get_millis(void);
 /**
  * \brief	This function returns the time in microseconds since system start. 
  *
- * \warning	Will run over after an hour.
+ * \warning	Will run over after an hour, only differences between two times 
+ *			are meaningful. Use time_keeper_get_micros64() for absolute times.
  *
  * \return The time in microseconds since system start
  */
 uint32_t time_keeper_get_micros(void);
 
+/**
+ * \brief	This function returns the time in microseconds since system start, 
+ *			which does not run over
+ *
+ * \return The time in microseconds since system start
+ */
+uint64_t time_keeper_get_micros64(void);
+
 /**
  * \brief	raw timer ticks
  *
+ * \warning	Will run over after an hour, only differences between two times 
+ *			are meaningful
+ *
  * \return	The raw timer ticks
  */
 uint32_t time_keeper_get_time_ticks(void);
 
+/**
+ * \brief	Raw timer ticks, extended to 64 bits by counting the overflows of 
+ *			the AST counter
+ *
+ * \return	The raw timer ticks since system start
+ */
+uint64_t time_keeper_get_time_ticks64(void);
+
 /**
  * \brief	Transforms the timer ticks into seconds
  *
@@ -111,6 +142,31 @@ void time_keeper_delay_micros(int32_t microseconds);
  */
 void time_keeper_delay_until(uint32_t until_time);
 
+/**
+ * \brief	Wait until time pass the parameter input
+ *
+ * \param	until_time		The time until which the function will run, as 
+ *							returned by time_keeper_get_micros64()
+ */
+void time_keeper_delay_until64(uint64_t until_time);
+
+/**
+ * \brief	Puts the CPU in idle sleep mode until a time or until an interrupt
+ *
+ * \details	The AST alarm wakes the CPU up, the peripherals keep running. 
+ *			Returns at once if the time is less than TK_MIN_SLEEP_TICKS away, 
+ *			or if the wake-up flag is set. The flag is checked with the 
+ *			interrupts masked, so that an interrupt setting it just before the 
+ *			sleep is not missed. Can be used as the idle function of the scheduler.
+ *
+ * \warning	Needs time_keeper_init_interrupt()
+ *
+ * \param	until_time		The time until which the CPU sleeps, as returned by 
+ *							time_keeper_get_micros64()
+ * \param	wake_flag		Flag set by interrupt handlers to end the sleep, NULL for none
+ */
+void time_keeper_sleep_until64(uint64_t until_time, const volatile bool* wake_flag);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,214 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file coroutine.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Resumable tasks, based on stackless coroutines
+ *
+ * \details A resumable task splits a long work into several invocations. When
+ * it yields, it returns TASK_RUN_BLOCKED: the scheduler runs it again at its
+ * next update, without waiting for the next period, and the task resumes
+ * after the yield point.
+ *
+ * The body of the task is enclosed between COROUTINE_BEGIN() and
+ * COROUTINE_END(), which expand to a switch statement:
+ * - local variables are lost at each yield, the state which has to
+ *   survive must be stored in the module structure
+ * - the body must not contain another switch statement with a yield point
+ * - at most one yield point per line
+ *
+ ******************************************************************************/
+
+
+#ifndef COROUTINE_H_
+#define COROUTINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scheduler.h"
+#include "time_keeper.h"
+
+#define COROUTINE_TIME_SLICE 1000		///<	Default execution time after which a resumable task yields (us)
+
+
+/**
+ * \brief	State of a resumable task
+ */
+typedef struct
+{
+	uint16_t resume_line;				///<	Line of the yield point to resume at, 0 when the coroutine is not running
+	uint32_t slice_start;				///<	Time at which the current invocation started (us)
+	uint32_t time_slice;				///<	Execution time after which COROUTINE_YIELD_IF_SLICE_SPENT() yields (us)
+} coroutine_t;
+
+
+/**
+ * \brief	Starts or resumes the body of a resumable task
+ *
+ * \param	cr		Pointer to the coroutine
+ */
+#define COROUTINE_BEGIN(cr) \
+		(cr)->slice_start = time_keeper_get_micros(); \
+		switch ( (cr)->resume_line ) \
+		{ \
+			case 0:
+
+
+/**
+ * \brief	Ends the body of a resumable task, the next invocation starts from the beginning
+ *
+ * \param	cr		Pointer to the coroutine
+ */
+#define COROUTINE_END(cr) \
+		} \
+		(cr)->resume_line = 0
+
+
+/**
+ * \brief	Returns TASK_RUN_BLOCKED, the next invocation resumes after this point
+ *
+ * \param	cr		Pointer to the coroutine
+ */
+#define COROUTINE_YIELD(cr) \
+		do \
+		{ \
+			(cr)->resume_line = __LINE__; \
+			return TASK_RUN_BLOCKED; \
+			case __LINE__:; \
+		} while (0)
+
+
+/**
+ * \brief	Yields if the current invocation has run for longer than the time slice
+ *
+ * \param	cr		Pointer to the coroutine
+ */
+#define COROUTINE_YIELD_IF_SLICE_SPENT(cr) \
+		do \
+		{ \
+			if ( ( time_keeper_get_micros() - (cr)->slice_start ) >= (cr)->time_slice ) \
+			{ \
+				(cr)->resume_line = __LINE__; \
+				return TASK_RUN_BLOCKED; \
+				case __LINE__:; \
+			} \
+		} while (0)
+
+
+/**
+ * \brief	Yields if the time left in the current invocation is shorter than the next step
+ *
+ * \details	Keeps each invocation within the time slice, as long as a step takes at 
+ *			most duration. After resuming, the step always runs.
+ *
+ * \param	cr			Pointer to the coroutine
+ * \param	duration	Execution time of the next step (us)
+ */
+#define COROUTINE_YIELD_UNLESS_TIME_LEFT(cr, duration) \
+		do \
+		{ \
+			if ( ( time_keeper_get_micros() - (cr)->slice_start + (duration) ) > (cr)->time_slice ) \
+			{ \
+				(cr)->resume_line = __LINE__; \
+				return TASK_RUN_BLOCKED; \
+				case __LINE__:; \
+			} \
+		} while (0)
+
+
+/**
+ * \brief	Yields until a condition is true
+ *
+ * \param	cr		Pointer to the coroutine
+ * \param	cond	Condition, evaluated again at each invocation
+ */
+#define COROUTINE_WAIT_UNTIL(cr, cond) \
+		do \
+		{ \
+			(cr)->resume_line = __LINE__; \
+			case __LINE__: \
+			if ( !(cond) ) \
+			{ \
+				return TASK_RUN_BLOCKED; \
+			} \
+		} while (0)
+
+
+/**
+ * \brief	Initialises a coroutine, not running
+ *
+ * \param	cr				Pointer to the coroutine
+ * \param	time_slice		Execution time after which COROUTINE_YIELD_IF_SLICE_SPENT() yields (us)
+ */
+static inline void coroutine_init(coroutine_t* cr, uint32_t time_slice)
+{
+	cr->resume_line = 0;
+	cr->slice_start = 0;
+	cr->time_slice = time_slice;
+}
+
+
+/**
+ * \brief	Stops a coroutine, its next invocation starts from the beginning
+ *
+ * \param	cr				Pointer to the coroutine
+ */
+static inline void coroutine_reset(coroutine_t* cr)
+{
+	cr->resume_line = 0;
+}
+
+
+/**
+ * \brief	Tells whether a coroutine has yielded and is waiting to be resumed
+ *
+ * \param	cr				Pointer to the coroutine
+ *
+ * \return	True if the coroutine is running
+ */
+static inline bool coroutine_is_running(const coroutine_t* cr)
+{
+	return ( cr->resume_line != 0 );
+}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COROUTINE_H_ */
\ No newline at end of file
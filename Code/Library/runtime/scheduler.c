@@ -44,7 +44,950 @@
 #include "scheduler.h"
 #include "time_keeper.h"
 #include "print_util.h"
+#include <string.h>
 
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS DECLARATION
+//------------------------------------------------------------------------------
+
+/**
+ * \brief 				Check whether a task comes before another one in a queue
+ * 
+ * \param 	ts 			Pointer to the task set
+ * \param 	a 			Index of the first task
+ * \param 	b 			Index of the second task
+ * 
+ * \return 				True if task a comes first
+ */
+static bool scheduler_queue_before(const task_set_t* ts, task_handle_t a, task_handle_t b);
+
+
+/**
+ * \brief 				Move the task at a given position of a queue towards the root
+ * 
+ * \param 	ts 			Pointer to the task set
+ * \param 	queue 		Pointer to the queue
+ * \param 	position 	Position of the task in the queue
+ */
+static void scheduler_queue_sift_up(task_set_t* ts, task_queue_t* queue, uint32_t position);
+
+
+/**
+ * \brief 				Move the task at a given position of a queue towards the leaves
+ * 
+ * \param 	ts 			Pointer to the task set
+ * \param 	queue 		Pointer to the queue
+ * \param 	position 	Position of the task in the queue
+ */
+static void scheduler_queue_sift_down(task_set_t* ts, task_queue_t* queue, uint32_t position);
+
+
+/**
+ * \brief 				Add a task to a queue
+ * 
+ * \param 	ts 			Pointer to the task set
+ * \param 	queue 		Pointer to the queue
+ * \param 	task_index 	Index of the task
+ * \param 	key 			Key by which the task is ordered
+ */
+static void scheduler_queue_push(task_set_t* ts, task_queue_t* queue, task_handle_t task_index, uint64_t key);
+
+
+/**
+ * \brief 				Remove the task at a given position of a queue
+ * 
+ * \param 	ts 			Pointer to the task set
+ * \param 	queue 		Pointer to the queue
+ * \param 	position 	Position of the task in the queue
+ * 
+ * \return 				Index of the removed task
+ */
+static task_handle_t scheduler_queue_remove(task_set_t* ts, task_queue_t* queue, uint32_t position);
+
+
+/**
+ * \brief 				Put a task back in the timer queue after it was modified
+ * 
+ * \details 			Tasks in the ready queue are left there, they are checked 
+ * 						again before being executed
+ * 
+ * \param 	te 			Pointer to the task entry
+ */
+static void scheduler_requeue_task(task_entry_t* te);
+
+
+/**
+ * \brief 				Queue all the active tasks in the timer queue
+ * 
+ * \param 	ts 			Pointer to the task set
+ */
+static void scheduler_rebuild_queues(task_set_t* ts);
+
+
+/**
+ * \brief 				Index all the tasks by ID, after their position has changed
+ * 
+ * \param 	ts 			Pointer to the task set
+ */
+static void scheduler_rebuild_index(task_set_t* ts);
+
+
+/**
+ * \brief 				Find a task by ID, with the index if the ID is in it
+ * 
+ * \param 	ts 			Pointer to the task set
+ * \param 	task_id 	ID of the task
+ * 
+ * \return 				Pointer to the task, NULL if there is no task with this ID
+ */
+static task_entry_t* scheduler_find_task(task_set_t* ts, uint32_t task_id);
+
+
+/**
+ * \brief 				Check whether a task comes before another one in the order of scheduler_sort_tasks()
+ * 
+ * \param 	a 			Pointer to the first task
+ * \param 	b 			Pointer to the second task
+ * 
+ * \return 				True if task a has higher priority, or the same priority and a shorter repeat period
+ */
+static bool scheduler_task_before(const task_entry_t* a, const task_entry_t* b);
+
+
+/**
+ * \brief 				Append a task to the task set
+ * 
+ * \param 	scheduler 		Pointer to the scheduler
+ * \param 	descriptor 		Pointer to the descriptor of the task, which is not copied
+ * \param 	run_mode 		Run mode
+ * \param 	repeat_period 	Repeat period (us)
+ * \param 	deadline 		Deadline relative to the release of the task (us), 0 for the repeat period
+ * 
+ * \return 					True if the task was added, False if the set is full or the ID is taken
+ */
+static bool scheduler_register_task(scheduler_t* scheduler, const task_descriptor_t* descriptor, task_run_mode_t run_mode, uint32_t repeat_period, uint32_t deadline);
+
+
+/**
+ * \brief 				Key of a due task in the ready queue
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * \param 	task_index 	Index of the task
+ * 
+ * \return 				Key, the task with the smallest key is executed first
+ */
+static uint64_t scheduler_ready_key(const scheduler_t* scheduler, task_handle_t task_index);
+
+
+/**
+ * \brief 				Update the deadline statistics of a task after its execution
+ * 
+ * \param 	te 			Pointer to the task entry
+ * \param 	release_time 	Time at which the task was due (us)
+ * \param 	completion_time 	Time at which the task completed (us)
+ */
+static void scheduler_account_deadline(task_entry_t* te, uint64_t release_time, uint64_t completion_time);
+
+
+/**
+ * \brief 				Count a duration in a task histogram, the counts saturate
+ * 
+ * \param 	histogram 	Histogram
+ * \param 	duration 	Duration (us)
+ */
+static void scheduler_histogram_add(uint16_t histogram[SCHEDULER_HISTOGRAM_BINS], uint32_t duration);
+
+
+/**
+ * \brief 				Update the delay and execution time statistics of a task after its execution
+ * 
+ * \param 	te 			Pointer to the task entry
+ * \param 	delay 		Delay between the release and the start of the task (us)
+ * \param 	start_time 	Time at which the task started (us)
+ * \param 	end_time 	Time at which the task completed (us)
+ */
+static void scheduler_account_execution(task_entry_t* te, uint32_t delay, uint64_t start_time, uint64_t end_time);
+
+
+/**
+ * \brief 				Release the tasks which were signalled since the last update
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ */
+static void scheduler_release_events(scheduler_t* scheduler);
+
+
+/**
+ * \brief 				Release the successors of a task which completed successfully
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * \param 	te 			Pointer to the task entry
+ */
+static void scheduler_release_successors(const scheduler_t* scheduler, const task_entry_t* te);
+
+
+/**
+ * \brief 				Replenish the CPU budget if its period is over and check that some is left
+ * 
+ * \details 			The budget is not accumulated: what a period does not use is 
+ * 						left to the tasks of the parent scheduler. An overrun of a 
+ * 						non-preemptive task is paid back on the next periods.
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * \param 	current_time	Current time (us)
+ * 
+ * \return 				True if a task may be executed
+ */
+static bool scheduler_budget_available(scheduler_t* scheduler, uint64_t current_time);
+
+
+/**
+ * \brief 				Charge the execution time of a task to the CPU budget
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * \param 	execution_time	Execution time of the task (us)
+ */
+static void scheduler_budget_charge(scheduler_t* scheduler, uint32_t execution_time);
+
+
+/**
+ * \brief 				Run update with the heap backend
+ * 
+ * \param 	scheduler 	Pointer to scheduler
+ * 
+ * \return 				Number of realtime violations
+ */
+static int32_t scheduler_update_heap(scheduler_t* scheduler);
+
+
+/**
+ * \brief 				Run update with the linear backend
+ * 
+ * \param 	scheduler 	Pointer to scheduler
+ * 
+ * \return 				Number of realtime violations
+ */
+static int32_t scheduler_update_linear(scheduler_t* scheduler);
+
+
+/**
+ * \brief 				Call the idle function until the next task is due, and account the CPU load
+ * 
+ * \param 	scheduler 	Pointer to scheduler
+ */
+static void scheduler_idle(scheduler_t* scheduler);
+
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+static bool scheduler_queue_before(const task_set_t* ts, task_handle_t a, task_handle_t b)
+{
+	return ( ts->tasks[a].queue_key < ts->tasks[b].queue_key ) || ( ( ts->tasks[a].queue_key == ts->tasks[b].queue_key ) && ( a < b ) );
+}
+
+
+static void scheduler_queue_sift_up(task_set_t* ts, task_queue_t* queue, uint32_t position)
+{
+	task_handle_t task_index = queue->heap[position];
+
+	while ( position > 0 )
+	{
+		uint32_t parent = (position - 1) / 2;
+
+		if ( scheduler_queue_before(ts, task_index, queue->heap[parent]) == false )
+		{
+			break;
+		}
+
+		queue->heap[position] = queue->heap[parent];
+		if ( queue == &ts->timer_queue )
+		{
+			ts->tasks[queue->heap[position]].queue_index = position;
+		}
+		position = parent;
+	}
+
+	queue->heap[position] = task_index;
+	if ( queue == &ts->timer_queue )
+	{
+		ts->tasks[task_index].queue_index = position;
+	}
+}
+
+
+static void scheduler_queue_sift_down(task_set_t* ts, task_queue_t* queue, uint32_t position)
+{
+	task_handle_t task_index = queue->heap[position];
+
+	while ( 2 * position + 1 < queue->count )
+	{
+		uint32_t child = 2 * position + 1;
+
+		if ( ( child + 1 < queue->count ) && scheduler_queue_before(ts, queue->heap[child + 1], queue->heap[child]) )
+		{
+			child += 1;
+		}
+
+		if ( scheduler_queue_before(ts, queue->heap[child], task_index) == false )
+		{
+			break;
+		}
+
+		queue->heap[position] = queue->heap[child];
+		if ( queue == &ts->timer_queue )
+		{
+			ts->tasks[queue->heap[position]].queue_index = position;
+		}
+		position = child;
+	}
+
+	queue->heap[position] = task_index;
+	if ( queue == &ts->timer_queue )
+	{
+		ts->tasks[task_index].queue_index = position;
+	}
+}
+
+
+static void scheduler_queue_push(task_set_t* ts, task_queue_t* queue, task_handle_t task_index, uint64_t key)
+{
+	ts->tasks[task_index].queue_key = key;
+	if ( queue == &ts->ready_queue )
+	{
+		ts->tasks[task_index].queue_index = SCHEDULER_READY;
+	}
+
+	queue->heap[queue->count] = task_index;
+	queue->count += 1;
+	scheduler_queue_sift_up(ts, queue, queue->count - 1);
+}
+
+
+static task_handle_t scheduler_queue_remove(task_set_t* ts, task_queue_t* queue, uint32_t position)
+{
+	task_handle_t task_index = queue->heap[position];
+
+	queue->count -= 1;
+	if ( position < queue->count )
+	{
+		// The last task fills the hole, and may have to move either way
+		queue->heap[position] = queue->heap[queue->count];
+		scheduler_queue_sift_down(ts, queue, position);
+		scheduler_queue_sift_up(ts, queue, position);
+	}
+
+	if ( queue == &ts->timer_queue )
+	{
+		ts->tasks[task_index].queue_index = SCHEDULER_NOT_QUEUED;
+	}
+
+	return task_index;
+}
+
+
+static void scheduler_requeue_task(task_entry_t* te)
+{
+	task_set_t* ts = te->task_set;
+
+	// Linear backend
+	if ( ( ts == NULL ) || ( ts->timer_queue.heap == NULL ) )
+	{
+		return;
+	}
+
+	if ( te->queue_index == SCHEDULER_READY )
+	{
+		return;
+	}
+
+	if ( te->queue_index != SCHEDULER_NOT_QUEUED )
+	{
+		scheduler_queue_remove(ts, &ts->timer_queue, te->queue_index);
+	}
+
+	if ( te->run_mode != RUN_NEVER )
+	{
+		scheduler_queue_push(ts, &ts->timer_queue, te - ts->tasks, te->next_run);
+	}
+}
+
+
+static void scheduler_rebuild_queues(task_set_t* ts)
+{
+	if ( ts->timer_queue.heap == NULL )
+	{
+		return;
+	}
+
+	ts->timer_queue.count = 0;
+	ts->ready_queue.count = 0;
+
+	for (uint32_t i = 0; i < ts->task_count; i++)
+	{
+		ts->tasks[i].queue_index = SCHEDULER_NOT_QUEUED;
+		scheduler_requeue_task(&ts->tasks[i]);
+	}
+}
+
+
+static void scheduler_rebuild_index(task_set_t* ts)
+{
+	if ( ts->id_index == NULL )
+	{
+		return;
+	}
+
+	for (uint32_t id = 0; id <= ts->max_task_id; id++)
+	{
+		ts->id_index[id] = SCHEDULER_NO_TASK;
+	}
+
+	for (uint32_t i = 0; i < ts->task_count; i++)
+	{
+		if ( ts->tasks[i].descriptor->task_id <= ts->max_task_id )
+		{
+			ts->id_index[ts->tasks[i].descriptor->task_id] = i;
+		}
+	}
+}
+
+
+static task_entry_t* scheduler_find_task(task_set_t* ts, uint32_t task_id)
+{
+	if ( ( ts->id_index != NULL ) && ( task_id <= ts->max_task_id ) )
+	{
+		if ( ts->id_index[task_id] == SCHEDULER_NO_TASK )
+		{
+			return NULL;
+		}
+		return &ts->tasks[ts->id_index[task_id]];
+	}
+
+	for (uint32_t i = 0; i < ts->task_count; i++) 
+	{
+		if ( ts->tasks[i].descriptor->task_id == task_id )
+		{ 
+			return &ts->tasks[i];
+		}
+	}
+
+	return NULL;
+}
+
+
+static bool scheduler_task_before(const task_entry_t* a, const task_entry_t* b)
+{
+	if ( a->descriptor->priority != b->descriptor->priority )
+	{
+		return ( a->descriptor->priority > b->descriptor->priority );
+	}
+
+	return ( a->repeat_period < b->repeat_period );
+}
+
+
+static bool scheduler_register_task(scheduler_t* scheduler, const task_descriptor_t* descriptor, task_run_mode_t run_mode, uint32_t repeat_period, uint32_t deadline)
+{
+	task_set_t* ts = scheduler->task_set;
+
+	// Check if the scheduler is not full
+	if ( ts->task_count >= ts->max_task_count ) 
+	{
+		print_util_dbg_print("[SCHEDULER] Error: Cannot add more task\r\n");
+		return false;
+	}
+
+	// Check if there is already a task with this ID
+	if ( scheduler_find_task(ts, descriptor->task_id) != NULL )
+	{
+		print_util_dbg_print("[SCHEDULER] Error: There is already a task with this ID\r\n");
+		return false;
+	}
+
+	task_entry_t* new_task = &ts->tasks[ts->task_count];
+
+	new_task->descriptor        = descriptor;
+	new_task->run_mode          = run_mode;
+	new_task->repeat_period     = repeat_period;
+	new_task->next_run          = time_keeper_get_micros64();
+	new_task->deadline          = deadline;
+	new_task->wcet_declared     = 0;
+	new_task->response_time_bound = 0;
+	new_task->event_pending     = false;
+	new_task->successor_count   = 0;
+	new_task->histograms        = ( ts->histograms != NULL ) ? &ts->histograms[ts->task_count] : NULL;
+	scheduler_reset_task_statistics(new_task);
+	new_task->task_set          = ts;
+	new_task->queue_index       = SCHEDULER_NOT_QUEUED;
+	new_task->queue_key         = 0;
+
+	if ( ( ts->id_index != NULL ) && ( descriptor->task_id <= ts->max_task_id ) )
+	{
+		ts->id_index[descriptor->task_id] = ts->task_count;
+	}
+
+	ts->task_count += 1;
+
+	scheduler_requeue_task(new_task);
+
+	return true;
+}
+
+
+static uint64_t scheduler_ready_key(const scheduler_t* scheduler, task_handle_t task_index)
+{
+	uint64_t key;
+
+	switch (scheduler->schedule_strategy)
+	{
+		case FIXED_PRIORITY:
+			// The task set is sorted by decreasing priority
+			key = task_index;
+		break;
+
+		case EARLIEST_DEADLINE_FIRST:
+			// Absolute deadline
+			key = scheduler->task_set->tasks[task_index].next_run;
+			if ( scheduler->task_set->tasks[task_index].deadline != 0 )
+			{
+				key += scheduler->task_set->tasks[task_index].deadline;
+			}
+			else
+			{
+				key += scheduler->task_set->tasks[task_index].repeat_period;
+			}
+		break;
+
+		case ROUND_ROBIN:
+		default:
+			// The task which has waited the longest
+			key = scheduler->task_set->tasks[task_index].next_run;
+		break;
+	}
+
+	return key;
+}
+
+
+static void scheduler_account_deadline(task_entry_t* te, uint64_t release_time, uint64_t completion_time)
+{
+	uint32_t response_time = completion_time - release_time;
+	uint32_t deadline = ( te->deadline != 0 ) ? te->deadline : te->repeat_period;
+	uint32_t lateness = 0;
+
+	if ( response_time > te->response_time_max )
+	{
+		te->response_time_max = response_time;
+	}
+
+	if ( response_time > deadline )
+	{
+		te->deadline_misses++;
+		lateness = response_time - deadline;
+	}
+
+	if ( te->histograms != NULL )
+	{
+		scheduler_histogram_add(te->histograms->lateness, lateness);
+	}
+}
+
+
+static void scheduler_histogram_add(uint16_t histogram[SCHEDULER_HISTOGRAM_BINS], uint32_t duration)
+{
+	uint8_t bin = scheduler_histogram_bin(duration);
+
+	if ( histogram[bin] < UINT16_MAX )
+	{
+		histogram[bin]++;
+	}
+}
+
+
+static void scheduler_account_execution(task_entry_t* te, uint32_t delay, uint64_t start_time, uint64_t end_time)
+{
+	uint32_t execution_time = end_time - start_time;
+	uint32_t deviation;
+	uint64_t delay_var_squared;
+
+	// Averages on 64 bits, so that long delays do not overflow
+	te->delay_avg = (7 * (uint64_t)te->delay_avg + delay) / 8;
+	if (delay > te->delay_max) 
+	{
+		te->delay_max = delay;
+	}
+	deviation = ( delay > te->delay_avg ) ? ( delay - te->delay_avg ) : ( te->delay_avg - delay );
+	delay_var_squared = 15 * (uint64_t)te->delay_var_squared / 16 + (uint64_t)deviation * deviation / 16;
+	te->delay_var_squared = ( delay_var_squared < UINT32_MAX ) ? delay_var_squared : UINT32_MAX;
+	te->execution_time = (7 * (uint64_t)te->execution_time + execution_time) / 8;
+
+	if ( execution_time > te->wcet )
+	{
+		te->wcet = execution_time;
+		te->wcet_time = start_time;
+	}
+
+	if ( te->histograms != NULL )
+	{
+		scheduler_histogram_add(te->histograms->execution, execution_time);
+		scheduler_histogram_add(te->histograms->latency, delay);
+	}
+}
+
+
+static void scheduler_release_events(scheduler_t* scheduler)
+{
+	task_set_t* ts = scheduler->task_set;
+
+	if ( ts->event_pending == false )
+	{
+		return;
+	}
+
+	// Cleared first, a signal arriving during the scan is seen at the next update
+	ts->event_pending = false;
+
+	for (uint32_t i = 0; i < ts->task_count; i++)
+	{
+		if ( ts->tasks[i].event_pending )
+		{
+			ts->tasks[i].event_pending = false;
+			scheduler_run_task_now(&ts->tasks[i]);
+		}
+	}
+}
+
+
+static void scheduler_release_successors(const scheduler_t* scheduler, const task_entry_t* te)
+{
+	for (uint32_t i = 0; i < te->successor_count; i++)
+	{
+		task_entry_t* successor = scheduler_get_task_by_id(scheduler, te->successors[i]);
+
+		if ( successor != NULL )
+		{
+			scheduler_run_task_now(successor);
+		}
+	}
+}
+
+
+static bool scheduler_budget_available(scheduler_t* scheduler, uint64_t current_time)
+{
+	if ( scheduler->cpu_budget == 0 )
+	{
+		return true;
+	}
+
+	if ( current_time >= scheduler->budget_replenish_time )
+	{
+		scheduler->budget_used_last = scheduler->budget_used;
+		scheduler->budget_used = 0;
+
+		if ( scheduler->budget_remaining > 0 )
+		{
+			scheduler->budget_remaining = 0;
+		}
+		scheduler->budget_remaining += scheduler->cpu_budget;
+
+		// Periods without any update are not replenished several times
+		scheduler->budget_replenish_time += scheduler->cpu_budget_period;
+		if ( scheduler->budget_replenish_time <= current_time )
+		{
+			scheduler->budget_replenish_time = current_time + scheduler->cpu_budget_period;
+		}
+	}
+
+	return ( scheduler->budget_remaining > 0 );
+}
+
+
+static void scheduler_budget_charge(scheduler_t* scheduler, uint32_t execution_time)
+{
+	if ( scheduler->cpu_budget == 0 )
+	{
+		return;
+	}
+
+	if ( ( scheduler->budget_remaining > 0 ) && ( (int32_t)execution_time >= scheduler->budget_remaining ) )
+	{
+		scheduler->budget_exhaustions++;
+	}
+
+	scheduler->budget_remaining -= (int32_t)execution_time;
+	scheduler->budget_used += execution_time;
+}
+
+
+static int32_t scheduler_update_heap(scheduler_t* scheduler)
+{
+	int32_t realtime_violation = 0;
+
+	task_set_t* ts = scheduler->task_set;
+
+	task_function_t call_task;
+	task_argument_t function_argument;
+	task_return_t treturn;
+
+	scheduler_release_events(scheduler);
+
+	// Single time snapshot to release the due tasks
+	uint64_t current_time = time_keeper_get_micros64();
+	uint64_t task_start_time = current_time;
+
+	while ( ( ts->timer_queue.count > 0 ) && ( current_time >= ts->tasks[ts->timer_queue.heap[0]].next_run ) )
+	{
+		task_handle_t i = scheduler_queue_remove(ts, &ts->timer_queue, 0);
+		scheduler_queue_push(ts, &ts->ready_queue, i, scheduler_ready_key(scheduler, i));
+	}
+
+	// Execute the due tasks in the order of the scheduling strategy, as long as the budget allows
+	while ( ( ts->ready_queue.count > 0 ) && scheduler_budget_available(scheduler, current_time) )
+	{
+		task_handle_t i = scheduler_queue_remove(ts, &ts->ready_queue, 0);
+		task_entry_t* te = &ts->tasks[i];
+
+		// The task may have been changed since it became due
+		if ( te->run_mode == RUN_NEVER )
+		{
+			te->queue_index = SCHEDULER_NOT_QUEUED;
+			continue;
+		}
+		if ( task_start_time < te->next_run )
+		{
+			te->queue_index = SCHEDULER_NOT_QUEUED;
+			scheduler_requeue_task(te);
+			continue;
+		}
+
+		uint64_t release_time = te->next_run;
+		uint32_t delay = task_start_time - release_time;
+
+		// Get function pointer and function argument
+		call_task = te->descriptor->call_function;
+		function_argument = te->descriptor->function_argument;
+
+		// Execute task
+		treturn = call_task(function_argument);
+
+		uint64_t task_end_time = time_keeper_get_micros64();
+
+		// Compute real-time statistics
+		scheduler_account_execution(te, delay, task_start_time, task_end_time);
+		scheduler_budget_charge(scheduler, task_end_time - task_start_time);
+		scheduler->busy_time += task_end_time - task_start_time;
+
+		// A blocked task keeps its release time and runs again at the next update
+		if ( treturn != TASK_RUN_BLOCKED )
+		{
+			// Set the next execution time of the task
+			switch (te->descriptor->timing_mode) 
+			{
+				case PERIODIC_ABSOLUTE:
+					// Do not take delays into account
+					te->next_run += te->repeat_period;
+				break;
+
+				case PERIODIC_RELATIVE:
+					// Take delays into account
+					te->next_run = task_end_time + te->repeat_period;
+				break;
+			}
+
+			// Set the task to inactive if it has to run only once
+			if (te->run_mode == RUN_ONCE)
+			{
+				te->run_mode = RUN_NEVER;
+			}
+
+			// Check real time violations
+			if ( te->next_run < task_start_time ) 
+			{
+				realtime_violation = -i; //realtime violation!!
+				te->rt_violations++;
+				te->next_run = task_start_time + te->repeat_period;
+			}
+
+			scheduler_account_deadline(te, release_time, task_end_time);
+		}
+
+		// Wait for the next execution time
+		te->queue_index = SCHEDULER_NOT_QUEUED;
+		scheduler_requeue_task(te);
+
+		if ( treturn == TASK_RUN_SUCCESS )
+		{
+			scheduler_release_successors(scheduler, te);
+		}
+
+		// Stop once the time budget is spent, the remaining due tasks are
+		// executed first at the next update
+		if ( ( scheduler->time_budget == 0 ) || ( task_end_time - current_time >= scheduler->time_budget ) )
+		{
+			break;
+		}
+
+		task_start_time = task_end_time;
+	}
+
+	return realtime_violation;
+}
+
+
+static int32_t scheduler_update_linear(scheduler_t* scheduler)
+{
+	int32_t i;
+	int32_t realtime_violation = 0;
+
+	task_set_t* ts = scheduler->task_set;
+
+	task_function_t call_task;
+	task_argument_t function_argument;
+	task_return_t treturn;
+
+	scheduler_release_events(scheduler);
+
+	// The due tasks wait for the next budget period
+	if ( scheduler_budget_available(scheduler, time_keeper_get_micros64()) == false )
+	{
+		return realtime_violation;
+	}
+
+	// Iterate through registered tasks
+	for (i = ts->current_schedule_slot; i < ts->task_count; i++) 
+	{
+		uint64_t current_time = time_keeper_get_micros64();
+
+		// If the task is active and has waited long enough...
+		if ( (ts->tasks[i].run_mode != RUN_NEVER) && (current_time >= ts->tasks[i].next_run) ) 
+		{
+			uint32_t delay = current_time - (ts->tasks[i].next_run);
+			uint64_t release_time = ts->tasks[i].next_run;
+			uint64_t task_start_time;
+			uint64_t task_end_time;
+
+		    task_start_time = time_keeper_get_micros64();
+
+		    // Get function pointer and function argument
+		    call_task = ts->tasks[i].descriptor->call_function;
+			function_argument = ts->tasks[i].descriptor->function_argument;
+
+			// Execute task
+		    treturn = call_task(function_argument);
+	
+			// A blocked task keeps its release time and runs again at the next update
+			if ( treturn != TASK_RUN_BLOCKED )
+			{
+				// Set the next execution time of the task
+				switch (ts->tasks[i].descriptor->timing_mode) 
+				{
+					case PERIODIC_ABSOLUTE:
+						// Do not take delays into account
+						ts->tasks[i].next_run += ts->tasks[i].repeat_period;
+					break;
+
+					case PERIODIC_RELATIVE:
+						// Take delays into account
+						ts->tasks[i].next_run = time_keeper_get_micros64() + ts->tasks[i].repeat_period;
+					break;
+				}
+				
+				// Set the task to inactive if it has to run only once
+				if (ts->tasks[i].run_mode == RUN_ONCE)
+				{
+					ts->tasks[i].run_mode = RUN_NEVER;
+				}
+
+				// Check real time violations
+				if (ts->tasks[i].next_run < current_time) 
+				{
+					realtime_violation = -i; //realtime violation!!
+					ts->tasks[i].rt_violations++;
+					ts->tasks[i].next_run = current_time + ts->tasks[i].repeat_period;
+				}
+			}
+			
+			// Compute real-time statistics
+			task_end_time = time_keeper_get_micros64();
+			scheduler_account_execution(&ts->tasks[i], delay, task_start_time, task_end_time);
+			if ( treturn != TASK_RUN_BLOCKED )
+			{
+				scheduler_account_deadline(&ts->tasks[i], release_time, task_end_time);
+			}
+			scheduler_budget_charge(scheduler, task_end_time - task_start_time);
+			scheduler->busy_time += task_end_time - task_start_time;
+
+			if ( treturn == TASK_RUN_SUCCESS )
+			{
+				scheduler_release_successors(scheduler, &ts->tasks[i]);
+			}
+				
+			// Depending on shceduling strategy, select next task slot	
+			switch (scheduler->schedule_strategy) 
+			{
+				case FIXED_PRIORITY: 
+					// Fixed priority scheme - scheduler will start over with tasks with the highest priority
+					ts->current_schedule_slot = 0;
+				break;		
+	
+				case ROUND_ROBIN:
+					// Round robin scheme - scheduler will pick up where it left.
+					if (i >= ts->task_count)
+					{ 
+						ts->current_schedule_slot = 0;
+					}
+				break;
+
+				default:
+				break;
+			}
+
+			return realtime_violation;			
+		}
+	}
+	return realtime_violation;
+}
+
+
+static void scheduler_idle(scheduler_t* scheduler)
+{
+	uint64_t current_time = time_keeper_get_micros64();
+
+	if ( scheduler->idle_function != NULL )
+	{
+		uint64_t wake_up_time = scheduler_get_next_run(scheduler);
+
+		// Signals from tasks were seen by scheduler_get_next_run(), signals from interrupts 
+		// are seen by the idle function or wake the CPU up
+		if ( wake_up_time > current_time )
+		{
+			scheduler->idle_function(wake_up_time, &scheduler->task_set->event_pending);
+
+			uint64_t end_time = time_keeper_get_micros64();
+			scheduler->idle_time += end_time - current_time;
+			current_time = end_time;
+		}
+	}
+
+	// Close the load window
+	if ( current_time >= scheduler->load_window_end )
+	{
+		scheduler->load_window_last = current_time - ( scheduler->load_window_end - SCHEDULER_LOAD_WINDOW );
+		scheduler->busy_time_last = scheduler->busy_time;
+		scheduler->idle_time_last = scheduler->idle_time;
+		scheduler->busy_time = 0;
+		scheduler->idle_time = 0;
+		scheduler->load_window_end = current_time + SCHEDULER_LOAD_WINDOW;
+	}
+}
+
+
+//------------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
 void scheduler_init(scheduler_t* scheduler, const scheduler_conf_t* config) 
 {
 
@@ -54,6 +997,44 @@ void scheduler_init(scheduler_t* scheduler, const scheduler_conf_t* config)
 	// Init debug mode
 	scheduler->debug = config->debug;
 
+	// Init backend
+	scheduler->backend = config->backend;
+	scheduler->time_budget = config->time_budget;
+
+	// Init CPU budget
+	scheduler->cpu_budget = ( config->cpu_budget_period > 0 ) ? config->cpu_budget : 0;
+	scheduler->cpu_budget_period = config->cpu_budget_period;
+	scheduler->budget_remaining = scheduler->cpu_budget;
+	scheduler->budget_replenish_time = time_keeper_get_micros64() + scheduler->cpu_budget_period;
+	scheduler->budget_used = 0;
+	scheduler->budget_used_last = 0;
+	scheduler->budget_exhaustions = 0;
+
+	// Init admission control, the tasks may use at most their budget
+	if ( config->utilisation_max > 0.0f )
+	{
+		scheduler->utilisation_max = config->utilisation_max;
+	}
+	else if ( scheduler->cpu_budget > 0 )
+	{
+		scheduler->utilisation_max = (float)scheduler->cpu_budget / (float)scheduler->cpu_budget_period;
+	}
+	else
+	{
+		scheduler->utilisation_max = 1.0f;
+	}
+	scheduler->wcet_default = config->wcet_default;
+	scheduler->utilisation = 0.0f;
+
+	// Init idle function and CPU load accounting
+	scheduler->idle_function = config->idle_function;
+	scheduler->load_window_end = time_keeper_get_micros64() + SCHEDULER_LOAD_WINDOW;
+	scheduler->busy_time = 0;
+	scheduler->idle_time = 0;
+	scheduler->busy_time_last = 0;
+	scheduler->idle_time_last = 0;
+	scheduler->load_window_last = 0;
+
 	// Allocate memory for the task set
 	scheduler->task_set = malloc( sizeof(task_set_t) + sizeof(task_entry_t[config->max_task_count]) );
 	if ( scheduler->task_set != NULL ) 
@@ -68,6 +1049,79 @@ void scheduler_init(scheduler_t* scheduler, const scheduler_conf_t* config)
 
 	scheduler->task_set->task_count = 0;
 	scheduler->task_set->current_schedule_slot = 0;
+	scheduler->task_set->event_pending = false;
+
+	// The descriptors of the tasks which are not in a table are allocated with the first one
+	scheduler->task_set->descriptors = NULL;
+	scheduler->task_set->descriptor_count = 0;
+	scheduler->task_set->max_descriptor_count = 0;
+
+	// Allocate memory for the histograms, only for the schedulers which report them
+	scheduler->task_set->histograms = NULL;
+
+	if ( config->histograms && ( scheduler->task_set->max_task_count > 0 ) )
+	{
+		scheduler->task_set->histograms = malloc( sizeof(task_histograms_t[scheduler->task_set->max_task_count]) );
+
+		if ( scheduler->task_set->histograms == NULL )
+		{
+			print_util_dbg_print("[SCHEDULER] ERROR ! Bad memory allocation, the tasks keep no histograms\r\n");
+		}
+	}
+
+	// Allocate memory for the index of the tasks by ID
+	scheduler->task_set->id_index = NULL;
+	scheduler->task_set->max_task_id = 0;
+
+	if ( ( config->max_task_id > 0 ) && ( scheduler->task_set->max_task_count < SCHEDULER_NO_TASK ) )
+	{
+		scheduler->task_set->id_index = malloc( sizeof(task_handle_t[config->max_task_id + 1]) );
+
+		if ( scheduler->task_set->id_index != NULL )
+		{
+			scheduler->task_set->max_task_id = config->max_task_id;
+			scheduler_rebuild_index(scheduler->task_set);
+		}
+		else
+		{
+			print_util_dbg_print("[SCHEDULER] ERROR ! Bad memory allocation, the tasks are found by ID without index\r\n");
+		}
+	}
+
+	// Deadlines are only used by the heap backend
+	if ( ( scheduler->schedule_strategy == EARLIEST_DEADLINE_FIRST ) && ( scheduler->backend != SCHEDULER_BACKEND_HEAP ) )
+	{
+		print_util_dbg_print("[SCHEDULER] Earliest deadline first scheduling uses the heap backend\r\n");
+		scheduler->backend = SCHEDULER_BACKEND_HEAP;
+	}
+
+	// Allocate memory for the queues of the heap backend
+	scheduler->task_set->timer_queue.heap = NULL;
+	scheduler->task_set->timer_queue.count = 0;
+	scheduler->task_set->ready_queue.heap = NULL;
+	scheduler->task_set->ready_queue.count = 0;
+
+	if ( scheduler->backend == SCHEDULER_BACKEND_HEAP )
+	{
+		if ( scheduler->task_set->max_task_count > SCHEDULER_MAX_QUEUED_TASKS )
+		{
+			print_util_dbg_print("[SCHEDULER] Error: Too many tasks for the heap backend\r\n");
+			scheduler->task_set->max_task_count = SCHEDULER_MAX_QUEUED_TASKS;
+		}
+
+		scheduler->task_set->timer_queue.heap = malloc( sizeof(task_handle_t[scheduler->task_set->max_task_count]) );
+		scheduler->task_set->ready_queue.heap = malloc( sizeof(task_handle_t[scheduler->task_set->max_task_count]) );
+
+		if ( ( scheduler->task_set->timer_queue.heap == NULL ) || ( scheduler->task_set->ready_queue.heap == NULL ) )
+		{
+			print_util_dbg_print("[SCHEDULER] ERROR ! Bad memory allocation, falling back to linear backend\r\n");
+			free(scheduler->task_set->timer_queue.heap);
+			free(scheduler->task_set->ready_queue.heap);
+			scheduler->task_set->timer_queue.heap = NULL;
+			scheduler->task_set->ready_queue.heap = NULL;
+			scheduler->backend = SCHEDULER_BACKEND_LINEAR;
+		}
+	}
 	
 	print_util_dbg_print("[SCHEDULER] Init\r\n");
 }
@@ -75,66 +1129,84 @@ void scheduler_init(scheduler_t* scheduler, const scheduler_conf_t* config)
 
 bool scheduler_add_task(scheduler_t* scheduler, uint32_t repeat_period, task_run_mode_t run_mode, task_timing_mode_t timing_mode, task_priority_t priority, task_function_t call_function, task_argument_t function_argument, uint32_t task_id) 
 {
-	bool task_successfully_added = false;
 	task_set_t* ts = scheduler->task_set;
 
-	// Check if the scheduler is not full
-	if ( ts->task_count < ts->max_task_count ) 
+	// Allocate memory for the descriptors, for the tasks which are not in a table
+	if ( ts->descriptors == NULL )
 	{
-		// Check if there is already a task with this ID
-		bool id_is_unique = true;
-		for (uint32_t i = 0; i < ts->task_count; ++i)
+		ts->max_descriptor_count = ts->max_task_count - ts->task_count;
+		ts->descriptor_count = 0;
+		ts->descriptors = malloc( sizeof(task_descriptor_t[ts->max_descriptor_count]) );
+
+		if ( ts->descriptors == NULL )
 		{
-			if ( ts->tasks[i].task_id == task_id )
-			{
-				id_is_unique = false;
-				break;
-			}
+			print_util_dbg_print("[SCHEDULER] ERROR ! Bad memory allocation\r\n");
+			ts->max_descriptor_count = 0;
 		}
+	}
 
-		// Add new task
-		if ( id_is_unique == true )
-		{
-			task_entry_t* new_task = &ts->tasks[ts->task_count];
+	if ( ts->descriptor_count >= ts->max_descriptor_count )
+	{
+		print_util_dbg_print("[SCHEDULER] Error: Cannot add more task\r\n");
+		return false;
+	}
+
+	task_descriptor_t* descriptor = &ts->descriptors[ts->descriptor_count];
+
+	descriptor->call_function     = call_function;
+	descriptor->function_argument = function_argument;
+	descriptor->task_id           = task_id;
+	descriptor->timing_mode       = timing_mode;
+	descriptor->priority          = priority;
 
-			new_task->call_function     = call_function;
-			new_task->function_argument = function_argument;
-			new_task->task_id           = task_id;		
-			new_task->run_mode          = run_mode;
-			new_task->timing_mode       = timing_mode;	
-			new_task->priority          = priority;	
-			new_task->repeat_period     = repeat_period;
-			new_task->next_run          = time_keeper_get_micros();
-			new_task->execution_time    = 0;
-			new_task->delay_max         = 0;
-			new_task->delay_avg         = 0;
-			new_task->delay_var_squared = 0;
+	if ( scheduler_register_task(scheduler, descriptor, run_mode, repeat_period, 0) == false )
+	{
+		return false;
+	}
+
+	ts->descriptor_count += 1;
+
+	return true;
+}
+
+
+bool scheduler_add_task_table(scheduler_t* scheduler, const task_table_entry_t table[], uint32_t count)
+{
+	bool tasks_successfully_added = true;
+	bool sorted = true;
 
-			ts->task_count += 1;
+	task_set_t* ts = scheduler->task_set;
 
-			task_successfully_added = true;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if ( scheduler_register_task(scheduler, &table[i].descriptor, table[i].run_mode, table[i].repeat_period, table[i].deadline) == false )
+		{
+			tasks_successfully_added = false;
 		}
-		else
+	}
+
+	// The table is expected in order, check it instead of sorting
+	for (uint32_t i = 1; i < ts->task_count; i++)
+	{
+		if ( scheduler_task_before(&ts->tasks[i], &ts->tasks[i - 1]) )
 		{
-			print_util_dbg_print("[SCHEDULER] Error: There is already a task with this ID\r\n");
-			task_successfully_added = false;
+			sorted = false;
+			break;
 		}
 	}
-	else
+
+	if ( sorted == false )
 	{
-		print_util_dbg_print("[SCHEDULER] Error: Cannot add more task\r\n");
-		task_successfully_added = false;
+		print_util_dbg_print("[SCHEDULER] Task table not in order, sorting\r\n");
+		scheduler_sort_tasks(scheduler);
 	}
 
-	return task_successfully_added;
+	return tasks_successfully_added;
 }
 
 
 void scheduler_sort_tasks(scheduler_t* scheduler)
 {
-	int32_t i;
-	bool sorted = false;
-
 	task_set_t* ts = scheduler->task_set;	
 	task_entry_t tmp;
 	
@@ -143,151 +1215,113 @@ void scheduler_sort_tasks(scheduler_t* scheduler)
 		return;
 	}
 
-	while ( sorted == false ) 
+	// Insertion sort, the task set is usually almost in order
+	for (uint32_t i = 1; i < ts->task_count; i++) 
 	{
-		sorted = true;
-		
-		// Iterate through registered tasks
-		for (i = 0; i < (ts->task_count - 1); i++) 
+		uint32_t j = i;
+
+		while ( ( j > 0 ) && scheduler_task_before(&ts->tasks[i], &ts->tasks[j - 1]) )
 		{
-			if ( ts->tasks[i].priority < ts->tasks[i + 1].priority )
-			{
-				// Task i has lower priority than task i+1 -> need swap
-				sorted = false;
-			}
-			else if ( ts->tasks[i].priority == ts->tasks[i + 1].priority )
-			{
-				if ( ts->tasks[i].repeat_period > ts->tasks[i + 1].repeat_period )
-				{
-					// Tasks i and i+1 have equal priority, but task i has higher
-					// repeat period than task i+1 -> need swap
-					sorted = false;
-				}
-			}
-			
-			// Swap tasks i and i+1 if necessary
-			if ( sorted == false )
-			{
-				tmp = ts->tasks[i];
-				ts->tasks[i] = ts->tasks[i + 1];
-				ts->tasks[i + 1] = tmp;
-				sorted = false;
-			}
+			j--;
+		}
+
+		if ( j < i )
+		{
+			tmp = ts->tasks[i];
+			memmove(&ts->tasks[j + 1], &ts->tasks[j], sizeof(task_entry_t[i - j]));
+			ts->tasks[j] = tmp;
 		}
-	}	
+	}
+
+	// Task indices have changed
+	scheduler_rebuild_index(ts);
+	scheduler_rebuild_queues(ts);
 }
 
 
 int32_t scheduler_update(scheduler_t* scheduler) 
 {
-	int32_t i;
-	int32_t realtime_violation = 0;
+	int32_t realtime_violation;
 
-	task_set_t* ts = scheduler->task_set;
+	if ( scheduler->backend == SCHEDULER_BACKEND_HEAP )
+	{
+		realtime_violation = scheduler_update_heap(scheduler);
+	}
+	else
+	{
+		realtime_violation = scheduler_update_linear(scheduler);
+	}
 
-	task_function_t call_task;
-	task_argument_t function_argument;
-	task_return_t treturn;
+	scheduler_idle(scheduler);
 
-	// Iterate through registered tasks
-	for (i = ts->current_schedule_slot; i < ts->task_count; i++) 
-	{
-		uint32_t current_time = time_keeper_get_micros();
+	return realtime_violation;
+}
 
-		// If the task is active and has waited long enough...
-		if ( (ts->tasks[i].run_mode != RUN_NEVER) && (current_time >= ts->tasks[i].next_run) ) 
-		{
-			uint32_t delay = current_time - (ts->tasks[i].next_run);
-			uint32_t task_start_time;
 
-		    task_start_time = time_keeper_get_micros();
+task_entry_t* scheduler_get_task_by_id(const scheduler_t* scheduler, uint16_t task_id)
+{
+	return scheduler_find_task(scheduler->task_set, task_id);
+}
 
-		    // Get function pointer and function argument
-		    call_task = ts->tasks[i].call_function;
-			function_argument = ts->tasks[i].function_argument;
 
-			// Execute task
-		    treturn = call_task(function_argument);
-	
-			// Set the next execution time of the task
-			switch (ts->tasks[i].timing_mode) 
-			{
-				case PERIODIC_ABSOLUTE:
-					// Do not take delays into account
-					ts->tasks[i].next_run += ts->tasks[i].repeat_period;
-				break;
+uint64_t scheduler_get_next_run(const scheduler_t* scheduler)
+{
+	task_set_t* ts = scheduler->task_set;
+	uint64_t next_run = UINT64_MAX;
 
-				case PERIODIC_RELATIVE:
-					// Take delays into account
-					ts->tasks[i].next_run = time_keeper_get_micros() + ts->tasks[i].repeat_period;
-				break;
-			}
-			
-			// Set the task to inactive if it has to run only once
-			if (ts->tasks[i].run_mode == RUN_ONCE)
-			{
-				ts->tasks[i].run_mode = RUN_NEVER;
-			}
+	if ( ts->event_pending )
+	{
+		return 0;
+	}
 
-			// Check real time violations
-			if (ts->tasks[i].next_run < current_time) 
-			{
-				realtime_violation = -i; //realtime violation!!
-				ts->tasks[i].rt_violations++;
-				ts->tasks[i].next_run = current_time + ts->tasks[i].repeat_period;
-			}
-			
-			// Compute real-time statistics
-			ts->tasks[i].delay_avg = (7 * ts->tasks[i].delay_avg + delay) / 8;
-			if (delay > ts->tasks[i].delay_max) 
-			{
-				ts->tasks[i].delay_max = delay;
-			}
-			ts->tasks[i].delay_var_squared = (15 * ts->tasks[i].delay_var_squared + (delay - ts->tasks[i].delay_avg) * (delay - ts->tasks[i].delay_avg)) / 16;
-			ts->tasks[i].execution_time = (7 * ts->tasks[i].execution_time + (time_keeper_get_micros() - task_start_time)) / 8;
-				
-			// Depending on shceduling strategy, select next task slot	
-			switch (scheduler->schedule_strategy) 
+	if ( scheduler->backend == SCHEDULER_BACKEND_HEAP )
+	{
+		// Due tasks left over by the time budget
+		if ( ts->ready_queue.count > 0 )
+		{
+			next_run = 0;
+		}
+		else if ( ts->timer_queue.count > 0 )
+		{
+			next_run = ts->tasks[ts->timer_queue.heap[0]].next_run;
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < ts->task_count; i++)
+		{
+			if ( ( ts->tasks[i].run_mode != RUN_NEVER ) && ( ts->tasks[i].next_run < next_run ) )
 			{
-				case FIXED_PRIORITY: 
-					// Fixed priority scheme - scheduler will start over with tasks with the highest priority
-					ts->current_schedule_slot = 0;
-				break;		
-	
-				case ROUND_ROBIN:
-					// Round robin scheme - scheduler will pick up where it left.
-					if (i >= ts->task_count)
-					{ 
-						ts->current_schedule_slot = 0;
-					}
-				break;
-
-				default:
-				break;
+				next_run = ts->tasks[i].next_run;
 			}
-
-			return realtime_violation;			
 		}
 	}
-	return realtime_violation;
-}
 
+	// Due tasks wait for the next budget period
+	if ( ( scheduler->cpu_budget > 0 ) && ( scheduler->budget_remaining <= 0 ) && ( next_run < scheduler->budget_replenish_time ) )
+	{
+		next_run = scheduler->budget_replenish_time;
+	}
 
-task_entry_t* scheduler_get_task_by_id(const scheduler_t* scheduler, uint16_t task_id)
-{
-	int32_t i = 0;
+	return next_run;
+}
 
-	task_set_t* ts = scheduler->task_set;
 
-	for (i = 0; i < ts->task_count; i++) 
+float scheduler_get_cpu_load(const scheduler_t* scheduler)
+{
+	if ( scheduler->load_window_last == 0 )
 	{
-		if ( ts->tasks[i].task_id == task_id )
-		{ 
-			return &ts->tasks[i];
-		}
+		return 0.0f;
 	}
 
-	return NULL;
+	if ( scheduler->idle_function != NULL )
+	{
+		return 1.0f - (float)scheduler->idle_time_last / (float)scheduler->load_window_last;
+	}
+	else
+	{
+		return (float)scheduler->busy_time_last / (float)scheduler->load_window_last;
+	}
 }
 
 
@@ -307,6 +1341,7 @@ task_entry_t* scheduler_get_task_by_index(const scheduler_t* scheduler, uint16_t
 void scheduler_change_run_mode(task_entry_t *te, task_run_mode_t new_run_mode) 
 {
 	te->run_mode = new_run_mode;
+	scheduler_requeue_task(te);
 }
 
 
@@ -318,9 +1353,76 @@ void scheduler_change_task_period(task_entry_t *te, uint32_t repeat_period)
 }
 
 
+void scheduler_change_task_deadline(task_entry_t *te, uint32_t deadline)
+{
+	te->deadline = deadline;
+}
+
+
+void scheduler_change_task_wcet(task_entry_t *te, uint32_t wcet)
+{
+	te->wcet_declared = wcet;
+}
+
+
+uint8_t scheduler_histogram_bin(uint32_t duration)
+{
+	uint8_t bin = 0;
+	uint32_t bound = 2 * SCHEDULER_HISTOGRAM_RESOLUTION;
+
+	if ( duration > 0 )
+	{
+		bin = 1;
+		while ( ( duration >= bound ) && ( bin < SCHEDULER_HISTOGRAM_BINS - 1 ) )
+		{
+			bin++;
+			bound *= 2;
+		}
+	}
+
+	return bin;
+}
+
+
+void scheduler_reset_task_statistics(task_entry_t *te)
+{
+	te->execution_time    = 0;
+	te->delay_max         = 0;
+	te->delay_avg         = 0;
+	te->delay_var_squared = 0;
+	te->rt_violations     = 0;
+	te->deadline_misses   = 0;
+	te->response_time_max = 0;
+	te->wcet              = 0;
+	te->wcet_time         = 0;
+
+	if ( te->histograms != NULL )
+	{
+		for (uint32_t i = 0; i < SCHEDULER_HISTOGRAM_BINS; ++i)
+		{
+			te->histograms->lateness[i]  = 0;
+			te->histograms->execution[i] = 0;
+			te->histograms->latency[i]   = 0;
+		}
+	}
+}
+
+
+void scheduler_reset_statistics(scheduler_t* scheduler)
+{
+	for (uint32_t i = 0; i < scheduler->task_set->task_count; ++i)
+	{
+		scheduler_reset_task_statistics(&scheduler->task_set->tasks[i]);
+	}
+
+	scheduler->budget_exhaustions = 0;
+}
+
+
 void scheduler_suspend_task(task_entry_t *te, uint32_t delay) 
 {
-	te->next_run = time_keeper_get_micros() + delay;
+	te->next_run = time_keeper_get_micros64() + delay;
+	scheduler_requeue_task(te);
 }
 
 
@@ -331,5 +1433,36 @@ void scheduler_run_task_now(task_entry_t *te)
 		te->run_mode = RUN_ONCE;
 	} 
 
-	te->next_run = time_keeper_get_micros();
+	te->next_run = time_keeper_get_micros64();
+	scheduler_requeue_task(te);
+}
+
+
+void scheduler_signal_task(task_entry_t *te)
+{
+	te->event_pending = true;
+	te->task_set->event_pending = true;
+}
+
+
+bool scheduler_add_precedence(scheduler_t* scheduler, uint32_t predecessor_id, uint32_t successor_id)
+{
+	task_entry_t* predecessor = scheduler_get_task_by_id(scheduler, predecessor_id);
+
+	if ( ( predecessor == NULL ) || ( scheduler_get_task_by_id(scheduler, successor_id) == NULL ) )
+	{
+		print_util_dbg_print("[SCHEDULER] Error: Precedence between unknown tasks\r\n");
+		return false;
+	}
+
+	if ( predecessor->successor_count >= SCHEDULER_MAX_SUCCESSORS )
+	{
+		print_util_dbg_print("[SCHEDULER] Error: Cannot add more successors\r\n");
+		return false;
+	}
+
+	predecessor->successors[predecessor->successor_count] = successor_id;
+	predecessor->successor_count += 1;
+
+	return true;
 }
\ No newline at end of file
@@ -55,6 +55,19 @@ extern "C"
 
 #define SCHEDULER_TIMEBASE 1000000
 
+#define SCHEDULER_NOT_QUEUED 0xFF		///<	Queue index of a task which is in no queue
+#define SCHEDULER_READY 0xFE			///<	Queue index of a task which is in the ready queue, or being executed
+#define SCHEDULER_MAX_QUEUED_TASKS 0xFE	///<	Maximum number of tasks with the heap backend
+
+#define SCHEDULER_HISTOGRAM_BINS 16		///<	Number of bins of the task histograms
+#define SCHEDULER_HISTOGRAM_RESOLUTION 16	///<	Resolution of the task histograms (us), see scheduler_histogram_bin()
+
+#define SCHEDULER_MAX_SUCCESSORS 2			///<	Maximum number of tasks released by the completion of a task
+
+#define SCHEDULER_NO_TASK 0xFF				///<	Entry of the task ID index for an ID without task
+
+#define SCHEDULER_LOAD_WINDOW 1000000		///<	Period over which the CPU load is measured (us)
+
 
 typedef uint8_t task_handle_t;
 
@@ -82,6 +95,18 @@ typedef void* task_argument_t;
 typedef task_return_t (*task_function_t)(task_argument_t);
 
 
+/**
+ * \brief 	Prototype of an idle function, which waits until a time or an interrupt
+ * 
+ * \details 	The time is on time_keeper_get_micros64(). The function may return 
+ * 			earlier, the scheduler then checks for due tasks and idles again.
+ * 			An interrupt can signal a task after the scheduler looked for due 
+ * 			tasks: the function must check event_pending again with the 
+ * 			interrupts masked, and return at once if it is set.
+ */ 
+typedef void (*scheduler_idle_function_t)(uint64_t wake_up_time, const volatile bool* event_pending);
+
+
 /**
  * \brief 	Task run mode
  */
@@ -122,31 +147,98 @@ typedef enum
 typedef enum  
 {
 	ROUND_ROBIN,				///<	Round robin scheduling
-	FIXED_PRIORITY				///<	Fixed priority scheduling
+	FIXED_PRIORITY,				///<	Fixed priority scheduling
+	EARLIEST_DEADLINE_FIRST		///<	Earliest deadline first scheduling, the due task with the earliest absolute deadline is executed first (heap backend)
 } schedule_strategy_t;
 
 
 /**
- * \brief 	Task entry
+ * \brief 	Scheduler backend, ie. how the tasks ready for execution are found
+ */
+typedef enum
+{
+	SCHEDULER_BACKEND_LINEAR,	///<	The task set is scanned from the current schedule slot, at most one task is executed per update
+	SCHEDULER_BACKEND_HEAP		///<	The tasks are queued by next execution time, all due tasks are executed per update within the time budget
+} scheduler_backend_t;
+
+
+/**
+ * \brief 	Task descriptor, the part of a task which does not change once it is registered
  */
 typedef struct
-{	
+{
 	task_function_t 	call_function;			///<	Function to be called
 	task_argument_t 	function_argument;		///<	Argument to be passed to the function
 	uint32_t 			task_id;				///<	Unique task identifier
-	task_run_mode_t  	run_mode;				///<	Run mode
 	task_timing_mode_t 	timing_mode;			///<	Timing mode
 	task_priority_t 	priority;				///< 	Priority
+} task_descriptor_t;
+
+
+/**
+ * \brief 	Entry of a const task table, see scheduler_add_task_table()
+ */
+typedef struct
+{
+	task_descriptor_t	descriptor;				///<	Descriptor of the task, referred to by the task entry
+	task_run_mode_t  	run_mode;				///<	Run mode at registration
+	uint32_t 			repeat_period;   		///<	Period between two calls at registration (us)
+	uint32_t			deadline;				///<	Deadline at registration (us), 0 for the repeat period
+} task_table_entry_t;
+
+
+/**
+ * \brief 	Histograms of a task, see scheduler_histogram_bin()
+ */
+typedef struct
+{
+	uint16_t			lateness[SCHEDULER_HISTOGRAM_BINS];		///<	Completion time after the deadline, bin 0 counts the executions on time
+	uint16_t			execution[SCHEDULER_HISTOGRAM_BINS];	///<	Execution times
+	uint16_t			latency[SCHEDULER_HISTOGRAM_BINS];		///<	Delays between the release and the start of the task
+} task_histograms_t;
+
+
+/**
+ * \brief 	Task entry
+ */
+typedef struct
+{	
+	const task_descriptor_t* descriptor;		///<	Function, argument, ID, timing mode and priority of the task
+	task_run_mode_t  	run_mode;				///<	Run mode
 	uint32_t 			repeat_period;   		///<	Period between two calls (us)
-	uint32_t 			next_run;				///<	Next execution time
+	uint64_t 			next_run;				///<	Next execution time (us), on the 64 bits time which does not run over
 	uint32_t 			execution_time;			///<	Execution time
 	uint32_t 			delay_max;				///<	Maximum delay between expected execution and actual execution
 	uint32_t 			delay_avg;				///<	Average delay between expected execution and actual execution
 	uint32_t 			delay_var_squared;		///<	Standard deviation of the delay
 	uint32_t 			rt_violations;			///<	Number of Real-time violations, this is incremented each time an execution is skipped
+	uint32_t			deadline;				///<	Deadline relative to the release of the task (us), 0 for the repeat period
+	uint32_t			deadline_misses;		///<	Number of executions which completed after their deadline
+	uint32_t			response_time_max;		///<	Maximum time between the release and the completion of the task (us)
+	task_histograms_t*	histograms;				///<	Histograms of the task, NULL if the scheduler keeps none
+	uint32_t			wcet;					///<	Worst case execution time (us)
+	uint64_t			wcet_time;				///<	Time at which the worst case execution started (us)
+	uint32_t			wcet_declared;			///<	Declared worst case execution time (us), the admission control uses the measured one once it is longer
+	uint32_t			response_time_bound;	///<	Bound on the response time from the last admission control (us), UINT32_MAX if the deadline can be missed
+	volatile bool		event_pending;			///<	Set by scheduler_signal_task(), the task is released at the next update
+	uint32_t			successors[SCHEDULER_MAX_SUCCESSORS];	///<	IDs of the tasks released each time the task completes successfully
+	uint8_t				successor_count;		///<	Number of successors
+	struct task_set_t*	task_set;				///<	Task set the task belongs to
+	task_handle_t		queue_index;			///<	Position in the timer queue, SCHEDULER_READY or SCHEDULER_NOT_QUEUED (heap backend)
+	uint64_t			queue_key;				///<	Key by which the task is ordered in its queue (heap backend)
 } task_entry_t;
 
 
+/**
+ * \brief 	Binary min-heap of task indices, ordered by task_entry_t::queue_key
+ */
+typedef struct
+{
+	task_handle_t* heap;						///<	Task indices, needs memory allocation
+	uint32_t count;								///<	Number of queued tasks
+} task_queue_t;
+
+
 /**
  * \brief 	Task set
  * 
@@ -158,6 +250,15 @@ typedef struct task_set_t
 	uint32_t task_count;						///<	Number_of_tasks
 	uint32_t max_task_count;					///<	Maximum number of tasks
 	uint32_t current_schedule_slot;				///<	Slot of the task being executed
+	volatile bool event_pending;				///<	Set when a task of the set was signalled
+	task_descriptor_t* descriptors;				///<	Descriptors of the tasks registered by scheduler_add_task(), allocated at the first one
+	uint32_t descriptor_count;					///<	Number of descriptors used
+	uint32_t max_descriptor_count;				///<	Maximum number of descriptors
+	task_handle_t* id_index;					///<	Index of the task of each ID up to max_task_id, SCHEDULER_NO_TASK if there is none, needs memory allocation
+	uint32_t max_task_id;						///<	Largest ID in the index, tasks with a larger ID are found by a scan of the task set
+	task_queue_t timer_queue;					///<	Tasks waiting for their next execution time, by next_run (heap backend)
+	task_queue_t ready_queue;					///<	Tasks due for execution, by scheduling strategy (heap backend)
+	task_histograms_t* histograms;				///<	Histograms of each task slot, NULL if they are not kept, needs memory allocation
 	task_entry_t tasks[];						///<	Array of tasks_entry to be executed, needs memory allocation
 } task_set_t;
 
@@ -172,6 +273,25 @@ typedef struct
 {
 	bool debug;									///<	Indicates whether the scheduler should print debug messages
 	schedule_strategy_t schedule_strategy;		///<	Scheduling strategy
+	scheduler_backend_t backend;				///<	Scheduler backend
+	uint32_t time_budget;						///<	Time after which an update stops executing due tasks (us), 0 to execute one task per update (heap backend)
+	float utilisation_max;						///<	CPU utilisation the task set may use, see scheduler_analysis_admission_control()
+	uint32_t wcet_default;						///<	Execution time assumed for the tasks which have neither run nor declared one (us)
+	float utilisation;							///<	CPU utilisation of the task set from the last admission control
+	uint32_t cpu_budget;						///<	Execution time the tasks may use per budget period (us), 0 for no budget
+	uint32_t cpu_budget_period;					///<	Period at which the budget is replenished (us)
+	int32_t budget_remaining;					///<	Budget left in the current period (us), negative after an overrun
+	uint64_t budget_replenish_time;				///<	Time of the next replenishment (us)
+	uint32_t budget_used;						///<	Execution time used in the current period (us)
+	uint32_t budget_used_last;					///<	Execution time used in the last complete period (us)
+	uint32_t budget_exhaustions;				///<	Number of periods in which the budget was exhausted
+	scheduler_idle_function_t idle_function;	///<	Called when no task is due, NULL to poll
+	uint64_t load_window_end;					///<	End of the current CPU load window (us)
+	uint32_t busy_time;							///<	Execution time of the tasks in the current load window (us)
+	uint32_t idle_time;							///<	Time spent in the idle function in the current load window (us)
+	uint32_t busy_time_last;					///<	Execution time of the tasks in the last complete load window (us)
+	uint32_t idle_time_last;					///<	Time spent in the idle function in the last complete load window (us)
+	uint32_t load_window_last;					///<	Length of the last complete load window (us)
 	task_set_t* task_set;						///<	Pointer to task set, needs memory allocation
 } scheduler_t;
 
@@ -183,6 +303,15 @@ typedef struct
 {
 	uint32_t max_task_count;					///<	Maximum number of tasks
 	schedule_strategy_t schedule_strategy;		///<	Schedule strategy
+	scheduler_backend_t backend;				///<	Scheduler backend, SCHEDULER_BACKEND_LINEAR if not set
+	uint32_t time_budget;						///<	Time after which an update stops executing due tasks (us), 0 to execute one task per update (heap backend)
+	float utilisation_max;						///<	CPU utilisation the task set may use, cpu_budget / cpu_budget_period or 1 if not set
+	uint32_t wcet_default;						///<	Execution time assumed for the tasks which have neither run nor declared one (us)
+	uint32_t cpu_budget;						///<	Execution time the tasks may use per budget period (us), 0 for no budget
+	uint32_t cpu_budget_period;					///<	Period at which the budget is replenished (us), usually the one of the task running the scheduler
+	uint32_t max_task_id;						///<	Largest task ID found by direct index, 0 to find the tasks by a scan of the task set
+	scheduler_idle_function_t idle_function;	///<	Called with the next execution time when no task is due, NULL to poll (nested schedulers)
+	bool histograms;							///<	Whether the tasks keep lateness, execution time and latency histograms (96 bytes per task slot)
 	bool debug;									///<	Indicates whether the schduler should print debug messages
 } scheduler_conf_t;
 
@@ -199,6 +328,9 @@ void scheduler_init( scheduler_t* scheduler, const scheduler_conf_t* config);
 /**
  * \brief               	Register a new task to the task set, in the first available slot
  * 
+ * \details 				The descriptor of the task is kept in RAM, the descriptors are 
+ * 						allocated at the first call for all the slots left
+ * 
  * \param scheduler         Pointer to scheduler
  * \param repeat_period     Repeat period (us)
  * \param run_mode      	Run mode
@@ -213,6 +345,22 @@ void scheduler_init( scheduler_t* scheduler, const scheduler_conf_t* config);
 bool scheduler_add_task(scheduler_t* scheduler, uint32_t repeat_period, task_run_mode_t run_mode, task_timing_mode_t timing_mode, task_priority_t priority, task_function_t call_function, task_argument_t function_argument, uint32_t task_id);
 
 
+/**
+ * \brief               	Register a table of tasks, laid out in the order of scheduler_sort_tasks()
+ * 
+ * \details 				The task entries refer to the descriptors of the table, which are 
+ * 						not copied: the table can be const and stay in flash. The task 
+ * 						set is only sorted if the table is not in order.
+ * 
+ * \param scheduler         Pointer to scheduler
+ * \param table     		Tasks, must remain valid as long as the scheduler
+ * \param count     		Number of tasks in the table
+ * 
+ * \return              	True if all the tasks were successfully added, False if not
+ */
+bool scheduler_add_task_table(scheduler_t* scheduler, const task_table_entry_t table[], uint32_t count);
+
+
 /**
 * \brief  	 			Sort tasks by decreasing priority, then by increasing repeat period 
 *
@@ -224,6 +372,13 @@ void scheduler_sort_tasks(scheduler_t* scheduler);
 /**
  * \brief                Run update (check for tasks ready for execution and execute them)
  * 
+ * \details 			With the heap backend, the time is read once to find the due 
+ * 						tasks, which are then executed in the order of the scheduling 
+ * 						strategy until the time budget is spent. Due tasks left over 
+ * 						are executed first at the next update.
+ * 						If no task is due afterwards, the idle function is called with 
+ * 						the next execution time.
+ * 
  * \param 	scheduler    Pointer to scheduler
  * 
  * \return               Number of realtime violations
@@ -234,6 +389,8 @@ int32_t scheduler_update(scheduler_t* scheduler);
 /**
  * \brief         		Find a task according to its idea
  * 
+ * \details 			Direct index for the IDs up to max_task_id, scan of the task set otherwise
+ * 
  * \param 	scheduler   Pointer to scheduler
  * \param 	task_id 	ID of the target task
  * 
@@ -242,6 +399,31 @@ int32_t scheduler_update(scheduler_t* scheduler);
 task_entry_t* scheduler_get_task_by_id(const scheduler_t* scheduler, uint16_t task_id);
 
 
+/**
+ * \brief         		Earliest time at which a task can be executed
+ * 
+ * \param 	scheduler   Pointer to scheduler
+ * 
+ * \return        		Time on time_keeper_get_micros64() (us), now if a task is due 
+ * 						or signalled, UINT64_MAX if no task is active
+ */
+uint64_t scheduler_get_next_run(const scheduler_t* scheduler);
+
+
+/**
+ * \brief         		CPU load over the last load window
+ * 
+ * \details 			Share of the time not spent in the idle function. Without 
+ * 						idle function the CPU never rests, the share of the time 
+ * 						spent executing tasks is returned instead.
+ * 
+ * \param 	scheduler   Pointer to scheduler
+ * 
+ * \return        		CPU load, between 0 and 1
+ */
+float scheduler_get_cpu_load(const scheduler_t* scheduler);
+
+
 /**
  * \brief            	Find a task according to its index
  * 
@@ -271,6 +453,58 @@ void scheduler_change_run_mode(task_entry_t *te, task_run_mode_t new_run_mode);
 void scheduler_change_task_period(task_entry_t *te, uint32_t repeat_period);
 
 
+/**
+ * \brief      		Modifies the deadline of an existing task
+ * 
+ * \param te   		Pointer to a task entry
+ * \param deadline 	New deadline relative to the release of the task (us), 0 for the repeat period
+ */
+void scheduler_change_task_deadline(task_entry_t *te, uint32_t deadline);
+
+
+/**
+ * \brief      		Declares the worst case execution time of an existing task
+ * 
+ * \param te   		Pointer to a task entry
+ * \param wcet 		Worst case execution time (us)
+ */
+void scheduler_change_task_wcet(task_entry_t *te, uint32_t wcet);
+
+
+/**
+ * \brief      		Histogram bin of a duration
+ * 
+ * \details 		Bin 0 counts null durations, bin 1 durations below 
+ * 					2 * SCHEDULER_HISTOGRAM_RESOLUTION, and each next bin 
+ * 					twice longer durations. The last bin counts all the longer ones.
+ * 
+ * \param duration 	Duration (us)
+ * 
+ * \return 			Bin index
+ */
+uint8_t scheduler_histogram_bin(uint32_t duration);
+
+
+/**
+ * \brief      		Resets the execution statistics of a task
+ * 
+ * \details 		Clears the delay and execution time statistics, the 
+ * 					real-time violations, the deadline accounting, the 
+ * 					histograms and the worst case execution time
+ * 
+ * \param te   		Pointer to a task entry
+ */
+void scheduler_reset_task_statistics(task_entry_t *te);
+
+
+/**
+ * \brief      		Resets the execution statistics of all the tasks and the budget exhaustion count
+ * 
+ * \param scheduler Pointer to the scheduler
+ */
+void scheduler_reset_statistics(scheduler_t* scheduler);
+
+
 /**
  * \brief      		Suspends a task
  * 
@@ -287,6 +521,34 @@ void scheduler_suspend_task(task_entry_t *te, uint32_t delay);
  */
 void scheduler_run_task_now(task_entry_t *te);
 
+
+/**
+ * \brief    	Signals an event to a task, which is released at the next update
+ * 
+ * \details 	The task is then run as with scheduler_run_task_now(): a task 
+ * 				which does not run regularly runs once per signal, a periodic 
+ * 				task runs early and its period restarts from the event.
+ * 				Only sets flags, so that it can be called from an interrupt.
+ * 
+ * \param te 	Pointer to a task entry
+ */
+void scheduler_signal_task(task_entry_t *te);
+
+
+/**
+ * \brief    				Declares that a task is to be released each time another one completes
+ * 
+ * \details 				The successor is released when the predecessor returns 
+ * 							TASK_RUN_SUCCESS, as with scheduler_signal_task()
+ * 
+ * \param scheduler 		Pointer to the scheduler
+ * \param predecessor_id 	ID of the predecessor task
+ * \param successor_id 		ID of the successor task
+ * 
+ * \return 					True if the precedence was added, false if a task does not exist or the predecessor has too many successors
+ */
+bool scheduler_add_precedence(scheduler_t* scheduler, uint32_t predecessor_id, uint32_t successor_id);
+
 #ifdef __cplusplus
 }
 #endif
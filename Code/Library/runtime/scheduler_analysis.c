@@ -0,0 +1,387 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file scheduler_analysis.c
+ * 
+ * \author MAV'RIC Team
+ *   
+ * \brief Admission control of the task set of a scheduler
+ *
+ ******************************************************************************/
+
+
+#include "scheduler_analysis.h"
+#include "print_util.h"
+
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS DECLARATION
+//------------------------------------------------------------------------------
+
+/**
+ * \brief 				Execution time of a task used by the analysis
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * \param 	te 			Pointer to the task entry
+ * 
+ * \return 				The longest of the measured and declared worst case execution times, or the default one (us)
+ */
+static uint32_t scheduler_analysis_wcet(const scheduler_t* scheduler, const task_entry_t* te);
+
+
+/**
+ * \brief 				Relative deadline of a task
+ * 
+ * \param 	te 			Pointer to the task entry
+ * 
+ * \return 				The deadline, or the repeat period if the task has none (us)
+ */
+static uint32_t scheduler_analysis_deadline(const task_entry_t* te);
+
+
+/**
+ * \brief 				Check whether a task can delay another one by being executed before it
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * \param 	task_index 	Index of the analysed task
+ * \param 	other_index Index of the other task
+ * 
+ * \return 				True if the other task interferes, false if it can only block the analysed one
+ */
+static bool scheduler_analysis_interferes(const scheduler_t* scheduler, uint32_t task_index, uint32_t other_index);
+
+
+/**
+ * \brief 				Non-preemptive response time analysis of a task
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * \param 	task_index 	Index of the task
+ * 
+ * \return 				Bound on the response time (us), UINT32_MAX if it exceeds the deadline
+ */
+static uint32_t scheduler_analysis_response_time(const scheduler_t* scheduler, uint32_t task_index);
+
+
+/**
+ * \brief 				Non-preemptive processor demand test at a given time
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * \param 	time 		Length of the interval starting at a synchronous release (us)
+ * 
+ * \return 				True if the jobs with a deadline in the interval, and one 
+ * 						job with a later deadline started just before, fit in it
+ */
+static bool scheduler_analysis_demand_fits(const scheduler_t* scheduler, uint32_t time);
+
+
+/**
+ * \brief 				Non-preemptive processor demand test over the synchronous busy period
+ * 
+ * \param 	scheduler 	Pointer to the scheduler
+ * 
+ * \return 				0 if the test holds, else the first time at which it fails (us)
+ */
+static uint32_t scheduler_analysis_demand_failure(const scheduler_t* scheduler);
+
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+static uint32_t scheduler_analysis_wcet(const scheduler_t* scheduler, const task_entry_t* te)
+{
+	uint32_t wcet = ( te->wcet > te->wcet_declared ) ? te->wcet : te->wcet_declared;
+
+	if ( wcet == 0 )
+	{
+		wcet = scheduler->wcet_default;
+	}
+
+	return wcet;
+}
+
+
+static uint32_t scheduler_analysis_deadline(const task_entry_t* te)
+{
+	return ( te->deadline != 0 ) ? te->deadline : te->repeat_period;
+}
+
+
+static bool scheduler_analysis_interferes(const scheduler_t* scheduler, uint32_t task_index, uint32_t other_index)
+{
+	bool interferes;
+
+	switch (scheduler->schedule_strategy)
+	{
+		case FIXED_PRIORITY:
+			// The task set is sorted by decreasing priority
+			interferes = ( other_index < task_index );
+		break;
+
+		case ROUND_ROBIN:
+		default:
+			interferes = true;
+		break;
+	}
+
+	return interferes;
+}
+
+
+static uint32_t scheduler_analysis_response_time(const scheduler_t* scheduler, uint32_t task_index)
+{
+	const task_set_t* ts = scheduler->task_set;
+	uint32_t wcet = scheduler_analysis_wcet(scheduler, &ts->tasks[task_index]);
+	uint32_t deadline = scheduler_analysis_deadline(&ts->tasks[task_index]);
+	uint64_t blocking = 0;
+	uint64_t window;
+	uint64_t previous_window;
+
+	// A task which is already running can not be interrupted
+	for (uint32_t j = 0; j < ts->task_count; j++)
+	{
+		if ( ( j != task_index ) && ( ts->tasks[j].run_mode != RUN_NEVER ) && ( scheduler_analysis_interferes(scheduler, task_index, j) == false ) )
+		{
+			if ( scheduler_analysis_wcet(scheduler, &ts->tasks[j]) > blocking )
+			{
+				blocking = scheduler_analysis_wcet(scheduler, &ts->tasks[j]);
+			}
+		}
+	}
+
+	// Longest time before the task starts, the interfering tasks are 
+	// released with it and then as often as possible
+	window = blocking;
+	do
+	{
+		previous_window = window;
+		window = blocking;
+
+		for (uint32_t j = 0; j < ts->task_count; j++)
+		{
+			if ( ( j != task_index ) && ( ts->tasks[j].run_mode != RUN_NEVER ) && scheduler_analysis_interferes(scheduler, task_index, j) )
+			{
+				uint32_t period = ( ts->tasks[j].repeat_period > 0 ) ? ts->tasks[j].repeat_period : 1;
+
+				window += ( previous_window / period + 1 ) * scheduler_analysis_wcet(scheduler, &ts->tasks[j]);
+			}
+		}
+
+		if ( window + wcet > deadline )
+		{
+			return UINT32_MAX;
+		}
+	}
+	while ( window != previous_window );
+
+	return window + wcet;
+}
+
+
+static bool scheduler_analysis_demand_fits(const scheduler_t* scheduler, uint32_t time)
+{
+	const task_set_t* ts = scheduler->task_set;
+	uint64_t demand = 0;
+	uint32_t blocking = 0;
+
+	for (uint32_t j = 0; j < ts->task_count; j++)
+	{
+		const task_entry_t* te = &ts->tasks[j];
+		uint32_t deadline = scheduler_analysis_deadline(te);
+		uint32_t period = ( te->repeat_period > 0 ) ? te->repeat_period : 1;
+
+		if ( te->run_mode == RUN_NEVER )
+		{
+			continue;
+		}
+
+		if ( deadline <= time )
+		{
+			demand += ( (time - deadline) / period + 1 ) * (uint64_t)scheduler_analysis_wcet(scheduler, te);
+		}
+		else if ( scheduler_analysis_wcet(scheduler, te) > blocking )
+		{
+			blocking = scheduler_analysis_wcet(scheduler, te);
+		}
+	}
+
+	return ( demand + blocking <= time );
+}
+
+
+static uint32_t scheduler_analysis_demand_failure(const scheduler_t* scheduler)
+{
+	const task_set_t* ts = scheduler->task_set;
+	uint64_t busy_period = 0;
+	uint64_t previous_busy_period;
+
+	// Synchronous busy period
+	for (uint32_t j = 0; j < ts->task_count; j++)
+	{
+		if ( ts->tasks[j].run_mode != RUN_NEVER )
+		{
+			busy_period += scheduler_analysis_wcet(scheduler, &ts->tasks[j]);
+		}
+	}
+
+	do
+	{
+		previous_busy_period = busy_period;
+		busy_period = 0;
+
+		for (uint32_t j = 0; j < ts->task_count; j++)
+		{
+			if ( ts->tasks[j].run_mode != RUN_NEVER )
+			{
+				uint32_t period = ( ts->tasks[j].repeat_period > 0 ) ? ts->tasks[j].repeat_period : 1;
+
+				busy_period += ( (previous_busy_period + period - 1) / period ) * scheduler_analysis_wcet(scheduler, &ts->tasks[j]);
+			}
+		}
+
+		if ( busy_period > SCHEDULER_ANALYSIS_HORIZON )
+		{
+			return SCHEDULER_ANALYSIS_HORIZON;
+		}
+	}
+	while ( busy_period != previous_busy_period );
+
+	// The demand can only exceed the time at an absolute deadline
+	for (uint32_t i = 0; i < ts->task_count; i++)
+	{
+		const task_entry_t* te = &ts->tasks[i];
+		uint32_t period = ( te->repeat_period > 0 ) ? te->repeat_period : 1;
+
+		if ( te->run_mode == RUN_NEVER )
+		{
+			continue;
+		}
+
+		for (uint64_t time = scheduler_analysis_deadline(te); time <= busy_period; time += period)
+		{
+			if ( scheduler_analysis_demand_fits(scheduler, time) == false )
+			{
+				return time;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+bool scheduler_analysis_admission_control(scheduler_t* scheduler)
+{
+	task_set_t* ts = scheduler->task_set;
+	bool schedulable = true;
+	uint32_t demand_failure = 0;
+
+	// CPU utilisation
+	scheduler->utilisation = 0.0f;
+	for (uint32_t i = 0; i < ts->task_count; i++)
+	{
+		if ( ts->tasks[i].run_mode != RUN_NEVER )
+		{
+			if ( ts->tasks[i].repeat_period > 0 )
+			{
+				scheduler->utilisation += (float)scheduler_analysis_wcet(scheduler, &ts->tasks[i]) / (float)ts->tasks[i].repeat_period;
+			}
+			else
+			{
+				scheduler->utilisation += 1.0f;
+			}
+		}
+	}
+
+	if ( scheduler->utilisation > scheduler->utilisation_max )
+	{
+		print_util_dbg_print("[SCHEDULER] Warning: CPU utilisation of ");
+		print_util_dbg_print_num((int32_t)(scheduler->utilisation * 100.0f), 10);
+		print_util_dbg_print("% over the budget of ");
+		print_util_dbg_print_num((int32_t)(scheduler->utilisation_max * 100.0f), 10);
+		print_util_dbg_print("%\r\n");
+		schedulable = false;
+	}
+
+	if ( scheduler->schedule_strategy == EARLIEST_DEADLINE_FIRST )
+	{
+		demand_failure = scheduler_analysis_demand_failure(scheduler);
+	}
+
+	// Response time bounds
+	for (uint32_t i = 0; i < ts->task_count; i++)
+	{
+		task_entry_t* te = &ts->tasks[i];
+
+		if ( te->run_mode == RUN_NEVER )
+		{
+			te->response_time_bound = 0;
+		}
+		else if ( scheduler->schedule_strategy == EARLIEST_DEADLINE_FIRST )
+		{
+			// The tasks with a deadline after the failure still meet it
+			if ( ( demand_failure == 0 ) || ( scheduler_analysis_deadline(te) > demand_failure ) )
+			{
+				te->response_time_bound = scheduler_analysis_deadline(te);
+			}
+			else
+			{
+				te->response_time_bound = UINT32_MAX;
+			}
+		}
+		else
+		{
+			te->response_time_bound = scheduler_analysis_response_time(scheduler, i);
+		}
+
+		if ( te->response_time_bound == UINT32_MAX )
+		{
+			print_util_dbg_print("[SCHEDULER] Warning: task ");
+			print_util_dbg_print_num(te->descriptor->task_id, 10);
+			print_util_dbg_print(" can miss its deadline\r\n");
+			schedulable = false;
+		}
+	}
+
+	if ( scheduler->debug )
+	{
+		print_util_dbg_print("[SCHEDULER] CPU utilisation: ");
+		print_util_dbg_print_num((int32_t)(scheduler->utilisation * 100.0f), 10);
+		print_util_dbg_print("%\r\n");
+	}
+
+	return schedulable;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file scheduler_analysis.h
+ * 
+ * \author MAV'RIC Team
+ *   
+ * \brief Admission control of the task set of a scheduler
+ *
+ * \details The scheduler is cooperative: once started, a task runs to 
+ * completion. The analysis therefore uses non-preemptive bounds, with the 
+ * execution time of each task taken as the longest of its measured and 
+ * declared worst case execution times.
+ *
+ ******************************************************************************/
+
+
+#ifndef SCHEDULER_ANALYSIS_H_
+#define SCHEDULER_ANALYSIS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "scheduler.h"
+
+#define SCHEDULER_ANALYSIS_HORIZON 1000000		///<	Longest busy period checked by the processor demand test (us), a longer one is deemed infeasible
+
+
+/**
+ * \brief		Checks whether the task set of a scheduler is schedulable
+ * 
+ * \details		The CPU utilisation of the active tasks must not exceed 
+ * 				scheduler->utilisation_max. The response time of each task is 
+ * 				then bounded according to the schedule strategy:
+ * 				- FIXED_PRIORITY: response time analysis, the tasks before it 
+ * 				  in the sorted task set interfere and the longest task after it 
+ * 				  blocks it
+ * 				- ROUND_ROBIN: response time analysis, all the other tasks 
+ * 				  interfere
+ * 				- EARLIEST_DEADLINE_FIRST: processor demand test over the 
+ * 				  synchronous busy period, the bound is the deadline if it holds
+ * 				The result is stored in scheduler->utilisation and in the 
+ * 				response_time_bound of each task, and a warning is printed for 
+ * 				each task which can miss its deadline.
+ * 
+ * \param	scheduler	Pointer to the scheduler
+ * 
+ * \return	True if the task set is schedulable
+ */
+bool scheduler_analysis_admission_control(scheduler_t* scheduler);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCHEDULER_ANALYSIS_H_ */
\ No newline at end of file
@@ -42,6 +42,146 @@
 
 #include "scheduler_telemetry.h"
 #include "time_keeper.h"
+#include "print_util.h"
+
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS DECLARATION
+//------------------------------------------------------------------------------
+
+/**
+ * \brief	Write the name of a task statistic, a prefix followed by the task ID
+ * 
+ * \param	name			The name, at least 11 characters long
+ * \param	prefix			The prefix, at most 3 characters long
+ * \param	task_id			The task ID
+ */
+static void scheduler_telemetry_task_name(char* name, const char* prefix, uint32_t task_id);
+
+
+/**
+ * \brief	Pack a task histogram in a MAVLink MEMORY_VECT message
+ * 
+ * \param	mavlink_stream			The pointer to the MAVLink stream structure
+ * \param	msg						The pointer to the MAVLink message
+ * \param	task_id					The task ID
+ * \param	kind					The histogram kind
+ * \param	histogram				The histogram
+ */
+static void scheduler_telemetry_pack_histogram(const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg, uint32_t task_id, uint8_t kind, const uint16_t histogram[SCHEDULER_HISTOGRAM_BINS]);
+
+
+/**
+ * \brief	Reset the statistics of one or all the tasks
+ * 
+ * \param	scheduler				The pointer to the scheduler
+ * \param	packet					The pointer to the decoded MAVLink command long
+ * 
+ * \return	The MAV_RESULT of the command
+ */
+static mav_result_t scheduler_telemetry_reset_statistics(scheduler_t* scheduler, mavlink_command_long_t* packet);
+
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+static void scheduler_telemetry_task_name(char* name, const char* prefix, uint32_t task_id)
+{
+	char digits[10];
+	uint8_t digit_count = 0;
+	uint8_t c = 0;
+
+	while ( *prefix != '\0' )
+	{
+		name[c++] = *prefix++;
+	}
+
+	do
+	{
+		digits[digit_count++] = '0' + task_id % 10;
+		task_id /= 10;
+	}
+	while ( task_id > 0 );
+
+	while ( digit_count > 0 )
+	{
+		name[c++] = digits[--digit_count];
+	}
+
+	name[c] = '\0';
+}
+
+
+static void scheduler_telemetry_pack_histogram(const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg, uint32_t task_id, uint8_t kind, const uint16_t histogram[SCHEDULER_HISTOGRAM_BINS])
+{
+	int8_t value[32] = {0};
+
+	// 16 x uint16_t, little endian as the rest of the MAVLink payload
+	for (uint8_t i = 0; ( i < SCHEDULER_HISTOGRAM_BINS ) && ( i < 16 ); i++)
+	{
+		value[2 * i]     = (int8_t)(histogram[i] & 0xFF);
+		value[2 * i + 1] = (int8_t)(histogram[i] >> 8);
+	}
+
+	mavlink_msg_memory_vect_pack(	mavlink_stream->sysid,
+									mavlink_stream->compid,
+									msg,
+									task_id * SCHEDULER_TELEMETRY_HISTOGRAM_KINDS + kind,
+									1,
+									1,
+									value);
+}
+
+
+static mav_result_t scheduler_telemetry_reset_statistics(scheduler_t* scheduler, mavlink_command_long_t* packet)
+{
+	mav_result_t result;
+	task_entry_t* te;
+
+	if ( packet->param1 < 0 )
+	{
+		print_util_dbg_print("Reset the statistics of all tasks\r\n");
+		scheduler_reset_statistics(scheduler);
+		result = MAV_RESULT_ACCEPTED;
+	}
+	else
+	{
+		te = scheduler_get_task_by_id(scheduler, (uint16_t)packet->param1);
+
+		if ( te != NULL )
+		{
+			scheduler_reset_task_statistics(te);
+			result = MAV_RESULT_ACCEPTED;
+		}
+		else
+		{
+			result = MAV_RESULT_DENIED;
+		}
+	}
+
+	return result;
+}
+
+
+//------------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+void scheduler_telemetry_init(scheduler_t* scheduler, mavlink_message_handler_t* message_handler)
+{
+	// Add callbacks for scheduler commands requests
+	mavlink_message_handler_cmd_callback_t callbackcmd;
+
+	callbackcmd.command_id = SCHEDULER_TELEMETRY_CMD_RESET_STATISTICS; // 250
+	callbackcmd.sysid_filter = MAVLINK_BASE_STATION_ID;
+	callbackcmd.compid_filter = MAV_COMP_ID_ALL;
+	callbackcmd.compid_target = MAV_COMP_ID_ALL; // 0
+	callbackcmd.function = (mavlink_cmd_callback_function_t)	&scheduler_telemetry_reset_statistics;
+	callbackcmd.module_struct =									scheduler;
+	mavlink_message_handler_add_cmd_callback(message_handler, &callbackcmd);
+}
+
 
 void scheduler_telemetry_send_rt_stats(const scheduler_t* scheduler, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg)
 {
@@ -89,4 +229,92 @@ void scheduler_telemetry_send_rt_stats(const scheduler_t* scheduler, const mavli
 	
 	stab_task->rt_violations = 0;
 	stab_task->delay_max = 0;
+}
+
+
+void scheduler_telemetry_send_deadline_stats(const scheduler_t* scheduler, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg)
+{
+	const task_set_t* ts = scheduler->task_set;
+
+	mavlink_msg_named_value_int_pack(	mavlink_stream->sysid,
+										mavlink_stream->compid,
+										msg,
+										time_keeper_get_millis(),
+										"dl_tasks",
+										ts->task_count);
+
+	for (uint32_t i = 0; i < ts->task_count; i++)
+	{
+		const task_entry_t* te = &ts->tasks[i];
+		char name[11];
+
+		mavlink_stream_send(mavlink_stream, msg);
+
+		scheduler_telemetry_task_name(name, "dl_", te->descriptor->task_id);
+		mavlink_msg_debug_vect_pack(	mavlink_stream->sysid,
+										mavlink_stream->compid,
+										msg,
+										name,
+										time_keeper_get_micros(),
+										te->deadline_misses,
+										te->response_time_max,
+										( te->deadline != 0 ) ? te->deadline : te->repeat_period);
+
+		if ( te->histograms != NULL )
+		{
+			mavlink_stream_send(mavlink_stream, msg);
+
+			scheduler_telemetry_pack_histogram(mavlink_stream, msg, te->descriptor->task_id, SCHEDULER_TELEMETRY_LATENESS, te->histograms->lateness);
+		}
+	}
+}
+
+
+void scheduler_telemetry_send_execution_stats(const scheduler_t* scheduler, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg)
+{
+	const task_set_t* ts = scheduler->task_set;
+
+	for (uint32_t i = 0; i < ts->task_count; i++)
+	{
+		const task_entry_t* te = &ts->tasks[i];
+		char name[11];
+
+		if ( i > 0 )
+		{
+			mavlink_stream_send(mavlink_stream, msg);
+		}
+
+		scheduler_telemetry_task_name(name, "ex_", te->descriptor->task_id);
+		mavlink_msg_debug_vect_pack(	mavlink_stream->sysid,
+										mavlink_stream->compid,
+										msg,
+										name,
+										te->wcet_time,
+										te->wcet,
+										te->execution_time,
+										te->delay_max);
+
+		if ( te->histograms != NULL )
+		{
+			mavlink_stream_send(mavlink_stream, msg);
+
+			scheduler_telemetry_pack_histogram(mavlink_stream, msg, te->descriptor->task_id, SCHEDULER_TELEMETRY_EXECUTION, te->histograms->execution);
+			mavlink_stream_send(mavlink_stream, msg);
+
+			scheduler_telemetry_pack_histogram(mavlink_stream, msg, te->descriptor->task_id, SCHEDULER_TELEMETRY_LATENCY, te->histograms->latency);
+		}
+	}
+}
+
+
+void scheduler_telemetry_send_budget(const scheduler_t* scheduler, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg)
+{
+	mavlink_msg_debug_vect_pack(	mavlink_stream->sysid,
+									mavlink_stream->compid,
+									msg,
+									"budget",
+									time_keeper_get_micros(),
+									scheduler->budget_used_last,
+									scheduler->cpu_budget,
+									scheduler->budget_exhaustions);
 }
\ No newline at end of file
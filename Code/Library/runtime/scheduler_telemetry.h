@@ -45,12 +45,34 @@
 #define SCHEDULER_TELEMETRY_H_
 
 #include "mavlink_stream.h"
+#include "mavlink_message_handler.h"
 #include "scheduler.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define SCHEDULER_TELEMETRY_HISTOGRAM_KINDS 4		///<	Number of histogram kinds per task in the MEMORY_VECT addresses
+#define SCHEDULER_TELEMETRY_LATENESS 0				///<	Lateness histogram
+#define SCHEDULER_TELEMETRY_EXECUTION 1				///<	Execution time histogram
+#define SCHEDULER_TELEMETRY_LATENCY 2				///<	Start latency histogram
+
+#define SCHEDULER_TELEMETRY_CMD_RESET_STATISTICS 250	///<	MAVLink command ID to reset the task statistics, not used by the common message set
+
+
+/**
+ * \brief	Initialize the MAVLink communication module for the scheduler
+ * 
+ * \details	Registers the command SCHEDULER_TELEMETRY_CMD_RESET_STATISTICS. 
+ * 			Its param1 is the ID of the task whose statistics are reset, 
+ * 			or -1 for all the tasks.
+ * 
+ * \param	scheduler				The pointer to the scheduler
+ * \param	message_handler			The pointer to the MAVLink message handler
+ */
+void scheduler_telemetry_init(scheduler_t* scheduler, mavlink_message_handler_t* message_handler);
+
+
 
 /**
  * \brief	Function to send real time statistics
@@ -62,6 +84,56 @@ extern "C" {
 void scheduler_telemetry_send_rt_stats(const scheduler_t* scheduler, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg);
 
 
+/**
+ * \brief	Function to send the deadline statistics of every task
+ * 
+ * \details	For each task, a DEBUG_VECT message named "dl_<task id>" carries the 
+ * 			number of deadline misses (x), the maximum response time (y) and the 
+ * 			deadline in us (z). If the scheduler keeps histograms, a MEMORY_VECT 
+ * 			message carries the lateness histogram as 16 x uint16_t, its address is 
+ * 			task id * SCHEDULER_TELEMETRY_HISTOGRAM_KINDS + SCHEDULER_TELEMETRY_LATENESS.
+ * 			A NAMED_VALUE_INT message "dl_tasks" gives the number of tasks first.
+ * 
+ * \param	scheduler				The pointer to the scheduler
+ * \param	mavlink_stream			The pointer to the MAVLink stream structure
+ * \param	msg						The pointer to the MAVLink message
+ */
+void scheduler_telemetry_send_deadline_stats(const scheduler_t* scheduler, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg);
+
+
+/**
+ * \brief	Function to send the execution time statistics of every task
+ * 
+ * \details	For each task, a DEBUG_VECT message named "ex_<task id>" carries the 
+ * 			worst case execution time (x), the average execution time (y) and 
+ * 			the maximum start latency (z) in us. Its timestamp is the time at 
+ * 			which the worst case execution started. If the scheduler keeps 
+ * 			histograms, two MEMORY_VECT messages carry the execution time and 
+ * 			start latency histograms, their 
+ * 			addresses are task id * SCHEDULER_TELEMETRY_HISTOGRAM_KINDS + 
+ * 			SCHEDULER_TELEMETRY_EXECUTION or SCHEDULER_TELEMETRY_LATENCY.
+ * 
+ * \param	scheduler				The pointer to the scheduler
+ * \param	mavlink_stream			The pointer to the MAVLink stream structure
+ * \param	msg						The pointer to the MAVLink message
+ */
+void scheduler_telemetry_send_execution_stats(const scheduler_t* scheduler, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg);
+
+
+/**
+ * \brief	Function to send the CPU budget consumption of a scheduler
+ * 
+ * \details	A DEBUG_VECT message named "budget" carries the execution time 
+ * 			used in the last budget period (x), the budget per period (y) in us 
+ * 			and the number of periods in which the budget was exhausted (z).
+ * 
+ * \param	scheduler				The pointer to the scheduler
+ * \param	mavlink_stream			The pointer to the MAVLink stream structure
+ * \param	msg						The pointer to the MAVLink message
+ */
+void scheduler_telemetry_send_budget(const scheduler_t* scheduler, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg);
+
+
 #ifdef __cplusplus
 }
 #endif
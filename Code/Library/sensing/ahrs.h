@@ -52,6 +52,16 @@ extern "C" {
 #include "quaternions.h"
 
 
+/**
+ * \brief The attitude estimation filters
+ */
+typedef enum
+{
+	AHRS_QFILTER,					///< Complementary filter, see qfilter.h
+	AHRS_MEKF						///< Multiplicative extended Kalman filter, see mekf.h
+} ahrs_estimator_t;
+
+
 /**
  * \brief Structure containing the Attitude and Heading Reference System
  */
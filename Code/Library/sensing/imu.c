@@ -49,6 +49,10 @@
 #include "tasks.h"
 #include "coord_conventions.h"
 
+#define IMU_FILTER_GYRO 0					///< The first channel of the gyroscope in the filter bank
+#define IMU_FILTER_ACC 3					///< The first channel of the accelerometer in the filter bank
+#define IMU_FILTER_MAG 6					///< The first channel of the compass in the filter bank
+
 
 //------------------------------------------------------------------------------
 // PRIVATE FUNCTIONS DECLARATION
@@ -69,6 +73,37 @@ static void imu_raw2oriented(imu_t *imu);
  */
 static void imu_oriented2scale(imu_t *imu);
 
+
+/**
+ * \brief	Integrates the gyroscope samples of the FIFO batch at their own time, and 
+ *			sets the raw gyroscope values to the mean of the batch
+ * 
+ * \param	imu		Pointer structure of the imu
+ *
+ * \return	False if there was no sample
+ */
+static bool imu_consume_gyro_samples(imu_t *imu);
+
+
+/**
+ * \brief	Sets the raw accelerometer values to the mean of the FIFO batch
+ * 
+ * \param	imu		Pointer structure of the imu
+ */
+static void imu_consume_acc_samples(imu_t *imu);
+
+
+/**
+ * \brief	Computes the coefficients of the filter bank from the filter configuration
+ *
+ * \details	Stage 0 is the low-pass filter of every channel, the next stages are 
+ *			the notches of the gyroscope and accelerometer channels. The states are 
+ *			set to the current scaled values to avoid a transient.
+ * 
+ * \param	imu		Pointer structure of the imu
+ */
+static void imu_compute_filter(imu_t *imu);
+
 //------------------------------------------------------------------------------
 // PRIVATE FUNCTIONS IMPLEMENTATION
 //------------------------------------------------------------------------------
@@ -115,14 +150,117 @@ static void imu_raw2oriented(imu_t *imu)
 
 static void imu_oriented2scale(imu_t *imu)
 {
+	float values[BIQUAD_BANK_CHANNELS];
+	
 	for (int16_t i = 0; i < 3; i++)
 	{
-		imu->scaled_gyro.data[i]  		= (1.0f - GYRO_LPF) * imu->scaled_gyro.data[i] 		+ GYRO_LPF * ( ( imu->oriented_gyro.data[i]     - imu->calib_gyro.bias[i]     ) * imu->calib_gyro.scale_factor[i]     );
-		imu->scaled_accelero.data[i]   	= (1.0f - ACC_LPF)  * imu->scaled_accelero.data[i] 	+ ACC_LPF  * ( ( imu->oriented_accelero.data[i] - imu->calib_accelero.bias[i] ) * imu->calib_accelero.scale_factor[i] );
-		imu->scaled_compass.data[i] 	= (1.0f - MAG_LPF)  * imu->scaled_compass.data[i] 	+ MAG_LPF  * ( ( imu->oriented_compass.data[i]  - imu->calib_compass.bias[i]  ) * imu->calib_compass.scale_factor[i]  );
+		values[IMU_FILTER_GYRO + i]	= ( imu->oriented_gyro.data[i]     - imu->calib_gyro.bias[i]     ) * imu->calib_gyro.scale_factor[i];
+		values[IMU_FILTER_ACC + i]	= ( imu->oriented_accelero.data[i] - imu->calib_accelero.bias[i] ) * imu->calib_accelero.scale_factor[i];
+		values[IMU_FILTER_MAG + i]	= ( imu->oriented_compass.data[i]  - imu->calib_compass.bias[i]  ) * imu->calib_compass.scale_factor[i];
+	}
+	
+	biquad_bank_update(&imu->filter, values);
+	
+	for (int16_t i = 0; i < 3; i++)
+	{
+		imu->scaled_gyro.data[i]		= values[IMU_FILTER_GYRO + i];
+		imu->scaled_accelero.data[i]	= values[IMU_FILTER_ACC + i];
+		imu->scaled_compass.data[i]		= values[IMU_FILTER_MAG + i];
 	}
 }
 
+
+static bool imu_consume_gyro_samples(imu_t *imu)
+{
+	float sample[3], rates[3], sum[3] = {0.0f, 0.0f, 0.0f};
+	uint32_t time, count = 0;
+	int16_t i;
+	
+	while (sample_buffer_get(&imu->gyro_samples, sample, &time))
+	{
+		for (i = 0; i < 3; i++)
+		{
+			rates[i] = (sample[imu->calib_gyro.axis[i]] * imu->calib_gyro.orientation[i] - imu->calib_gyro.bias[i]) * imu->calib_gyro.scale_factor[i];
+			sum[i] += sample[i];
+		}
+		
+		if (imu->gyro_sample_time != 0)
+		{
+			imu_integrate_gyro(imu, rates, (time - imu->gyro_sample_time) / 1000000.0f);
+		}
+		imu->gyro_sample_time = time;
+		count++;
+	}
+	
+	if (count == 0)
+	{
+		return false;
+	}
+	
+	for (i = 0; i < 3; i++)
+	{
+		imu->raw_gyro.data[i] = sum[i] / count;
+	}
+	
+	return true;
+}
+
+
+static void imu_consume_acc_samples(imu_t *imu)
+{
+	float sample[3], sum[3] = {0.0f, 0.0f, 0.0f};
+	uint32_t time, count = 0;
+	int16_t i;
+	
+	while (sample_buffer_get(&imu->acc_samples, sample, &time))
+	{
+		for (i = 0; i < 3; i++)
+		{
+			sum[i] += sample[i];
+		}
+		count++;
+	}
+	
+	if (count > 0)
+	{
+		for (i = 0; i < 3; i++)
+		{
+			imu->raw_accelero.data[i] = sum[i] / count;
+		}
+	}
+}
+
+
+static void imu_compute_filter(imu_t *imu)
+{
+	imu_filter_conf_t* config = &imu->filter_config;
+	float values[BIQUAD_BANK_CHANNELS];
+	
+	biquad_bank_init(&imu->filter);
+	
+	biquad_bank_set_lowpass(&imu->filter, 0, IMU_FILTER_GYRO, 3, config->gyro_cutoff, config->sample_rate);
+	biquad_bank_set_lowpass(&imu->filter, 0, IMU_FILTER_ACC,  3, config->acc_cutoff,  config->sample_rate);
+	biquad_bank_set_lowpass(&imu->filter, 0, IMU_FILTER_MAG,  3, config->mag_cutoff,  config->sample_rate);
+	
+	for (uint8_t i = 0; i < IMU_NOTCH_COUNT; i++)
+	{
+		if (config->notch_frequency[i] > 0.0f)
+		{
+			biquad_bank_set_notch(&imu->filter, i + 1, IMU_FILTER_GYRO, 6, config->notch_frequency[i], config->notch_bandwidth[i], config->sample_rate);
+		}
+	}
+	
+	for (int16_t i = 0; i < 3; i++)
+	{
+		values[IMU_FILTER_GYRO + i] = imu->scaled_gyro.data[i];
+		values[IMU_FILTER_ACC + i] = imu->scaled_accelero.data[i];
+		values[IMU_FILTER_MAG + i] = imu->scaled_compass.data[i];
+	}
+	biquad_bank_prime(&imu->filter, values);
+	
+	imu->filter_applied = *config;
+}
+
 //------------------------------------------------------------------------------
 // PUBLIC FUNCTIONS IMPLEMENTATION
 //------------------------------------------------------------------------------
@@ -199,6 +337,39 @@ void imu_init (imu_t *imu, state_t* state)
 	imu->last_update = time_keeper_get_time_ticks();
 	imu->dt = 0.004;
 	
+	for (int16_t i = 0; i < 3; i++)
+	{
+		imu->gyro_integration.alpha[i] = 0.0f;
+		imu->gyro_integration.beta[i] = 0.0f;
+		imu->gyro_integration.last_increment[i] = 0.0f;
+	}
+	imu->gyro_integration.dt = 0.0f;
+	imu->gyro_integration.sample_count = 0;
+	imu->gyro_integration.coning_compensation = true;
+	
+	sample_buffer_init(&imu->gyro_samples);
+	sample_buffer_init(&imu->acc_samples);
+	imu->gyro_sample_time = 0;
+	
+	//init filters
+	imu->filter_config.gyro_cutoff = GYRO_LPF_CUTOFF;
+	imu->filter_config.acc_cutoff = ACC_LPF_CUTOFF;
+	imu->filter_config.mag_cutoff = MAG_LPF_CUTOFF;
+	for (int16_t i = 0; i < IMU_NOTCH_COUNT; i++)
+	{
+		imu->filter_config.notch_frequency[i] = 0.0f;
+		imu->filter_config.notch_bandwidth[i] = 20.0f;
+	}
+	imu->filter_config.sample_rate = IMU_FILTER_SAMPLE_RATE;
+	
+	for (int16_t i = 0; i < 3; i++)
+	{
+		imu->scaled_gyro.data[i] = 0.0f;
+		imu->scaled_accelero.data[i] = 0.0f;
+		imu->scaled_compass.data[i] = 0.0f;
+	}
+	imu_compute_filter(imu);
+	
 	print_util_dbg_print("[IMU] Initialisation\r\n");
 }
 		
@@ -238,6 +409,102 @@ void imu_update(imu_t *imu)
 	imu->dt = time_keeper_ticks_to_seconds(t - imu->last_update);
 	imu->last_update = t;
 
+	// the gyroscope samples are integrated before the biais is updated by the attitude filter
+	bool gyro_batch = imu_consume_gyro_samples(imu);
+	imu_consume_acc_samples(imu);
+	
 	imu_raw2oriented(imu);
 	imu_oriented2scale(imu);
+	
+	// without FIFO batch, the raw gyroscope value is integrated over the update period
+	// the attitude is integrated from the unfiltered rates, the low pass filter would delay it
+	if (!gyro_batch)
+	{
+		float rates[3];
+		for (int16_t i = 0; i < 3; i++)
+		{
+			rates[i] = (imu->oriented_gyro.data[i] - imu->calib_gyro.bias[i]) * imu->calib_gyro.scale_factor[i];
+		}
+		imu_integrate_gyro(imu, rates, imu->dt);
+	}
+}
+
+
+task_return_t imu_update_filter(imu_t *imu)
+{
+	imu_filter_conf_t* config = &imu->filter_config;
+	imu_filter_conf_t* applied = &imu->filter_applied;
+	bool changed = (config->gyro_cutoff != applied->gyro_cutoff) 
+				|| (config->acc_cutoff != applied->acc_cutoff) 
+				|| (config->mag_cutoff != applied->mag_cutoff) 
+				|| (config->sample_rate != applied->sample_rate);
+	
+	for (uint8_t i = 0; i < IMU_NOTCH_COUNT; i++)
+	{
+		changed |= (config->notch_frequency[i] != applied->notch_frequency[i]) 
+				 || (config->notch_bandwidth[i] != applied->notch_bandwidth[i]);
+	}
+	
+	if (changed)
+	{
+		imu_compute_filter(imu);
+	}
+	
+	return TASK_RUN_SUCCESS;
+}
+
+
+void imu_integrate_gyro(imu_t *imu, const float rates[3], float dt)
+{
+	gyro_integration_t* integration = &imu->gyro_integration;
+	float increment[3], tmp[3], coning[3];
+	
+	increment[X] = rates[X] * dt;
+	increment[Y] = rates[Y] * dt;
+	increment[Z] = rates[Z] * dt;
+	
+	if (integration->coning_compensation)
+	{
+		// beta += 1/2 (alpha + last_increment / 6) x increment
+		for (int16_t i = 0; i < 3; i++)
+		{
+			tmp[i] = integration->alpha[i] + integration->last_increment[i] / 6.0f;
+		}
+		CROSS(tmp, increment, coning);
+		for (int16_t i = 0; i < 3; i++)
+		{
+			integration->beta[i] += 0.5f * coning[i];
+		}
+	}
+	
+	for (int16_t i = 0; i < 3; i++)
+	{
+		integration->alpha[i] += increment[i];
+		integration->last_increment[i] = increment[i];
+	}
+	integration->dt += dt;
+	integration->sample_count++;
+}
+
+
+bool imu_get_rotation(imu_t *imu, float rotation[3], float* dt)
+{
+	gyro_integration_t* integration = &imu->gyro_integration;
+	
+	if (integration->sample_count == 0)
+	{
+		return false;
+	}
+	
+	for (int16_t i = 0; i < 3; i++)
+	{
+		rotation[i] = integration->alpha[i] + integration->beta[i];
+		integration->alpha[i] = 0.0f;
+		integration->beta[i] = 0.0f;
+	}
+	*dt = integration->dt;
+	integration->dt = 0.0f;
+	integration->sample_count = 0;
+	
+	return true;
 }
\ No newline at end of file
@@ -54,13 +54,17 @@ extern "C" {
 #include "gyroscope.h"
 #include "accelerometer.h"
 #include "magnetometer.h"
+#include "sample_buffer.h"
+#include "biquad_bank.h"
 #include "quaternions.h"
 #include "scheduler.h"
 #include "state.h"
 
-#define GYRO_LPF 0.1f						///< The gyroscope linear pass filter gain
-#define ACC_LPF 0.05f						///< The accelerometer linear pass filter gain
-#define MAG_LPF 0.1f						///< The magnetometer linear pass filter gain
+#define GYRO_LPF_CUTOFF 4.0f				///< The default cutoff frequency of the gyroscope low-pass filter (Hz)
+#define ACC_LPF_CUTOFF 2.0f					///< The default cutoff frequency of the accelerometer low-pass filter (Hz)
+#define MAG_LPF_CUTOFF 4.0f					///< The default cutoff frequency of the magnetometer low-pass filter (Hz)
+#define IMU_NOTCH_COUNT 2					///< The number of notch filters on the gyroscope and accelerometer
+#define IMU_FILTER_SAMPLE_RATE 250.0f		///< The rate of imu_update (Hz)
 
 
 /**
@@ -79,6 +83,41 @@ typedef struct
 } sensor_calib_t;
 
 
+/**
+ * \brief The configuration of the filters of the scaled sensor values
+ *
+ * A frequency of 0 disables the filter. The notches are applied to the 
+ * gyroscope and the accelerometer, to remove the vibrations of the motors.
+ */
+typedef struct
+{
+	float gyro_cutoff;						///< The cutoff frequency of the gyroscope low-pass filter (Hz)
+	float acc_cutoff;						///< The cutoff frequency of the accelerometer low-pass filter (Hz)
+	float mag_cutoff;						///< The cutoff frequency of the magnetometer low-pass filter (Hz)
+	float notch_frequency[IMU_NOTCH_COUNT];	///< The centre frequency of each notch (Hz)
+	float notch_bandwidth[IMU_NOTCH_COUNT];	///< The bandwidth of each notch (Hz)
+	float sample_rate;						///< The rate of the filter updates (Hz)
+} imu_filter_conf_t;
+
+
+/**
+ * \brief The integration of the gyroscope samples between two attitude updates
+ *
+ * The angle increments of the samples are summed into a rotation vector. With 
+ * the coning compensation, the rotation of the rates vector during the update 
+ * period is taken into account (second order correction of the rotation vector).
+ */
+typedef struct
+{
+	float alpha[3];							///< The sum of the angle increments (rad)
+	float beta[3];							///< The coning correction of the rotation vector (rad)
+	float last_increment[3];				///< The angle increment of the previous sample (rad)
+	float dt;								///< The time covered by the samples (s)
+	uint32_t sample_count;					///< The number of samples since the last attitude update
+	bool coning_compensation;				///< Whether the coning correction is applied
+} gyro_integration_t;
+
+
 /**
  * \brief The IMU structure
  */
@@ -100,6 +139,16 @@ typedef struct
 	magnetometer_t   oriented_compass;		///< The compass oriented values structure
 	magnetometer_t   scaled_compass;		///< The compass scaled values structure
 	
+	sample_buffer_t  gyro_samples;			///< The raw gyroscope samples read from the sensor FIFO, with their time
+	sample_buffer_t  acc_samples;			///< The raw accelerometer samples read from the sensor FIFO, with their time
+	uint32_t         gyro_sample_time;		///< The time of the last gyroscope sample taken from gyro_samples (us)
+	
+	gyro_integration_t gyro_integration;	///< The integration of the gyroscope samples for the attitude filters
+	
+	imu_filter_conf_t filter_config;		///< The configuration of the filters, set by the onboard parameters
+	imu_filter_conf_t filter_applied;		///< The configuration the filter coefficients were computed from
+	biquad_bank_t    filter;				///< The filters of the gyroscope, accelerometer and compass channels
+	
 	float dt;								///< The time interval between two IMU updates
 	uint32_t last_update;					///< The time of the last IMU update in ms
 	uint8_t calibration_level;				///< The level of calibration
@@ -128,10 +177,48 @@ void imu_calibrate_gyros(imu_t *imu);
 /**
  * \brief	Updates the scaled sensors values from raw measurements
  *
+ * \details	If the sensor FIFOs were read into gyro_samples and acc_samples, the raw 
+ *			values are the mean of the batches and every gyroscope sample is 
+ *			integrated at its own time. Otherwise raw_gyro and raw_accelero are used.
+ *
  * \param	imu						The pointer to the IMU structure
  */
 void imu_update(imu_t *imu);
 
+
+/**
+ * \brief	Recomputes the filter coefficients if the filter configuration was changed
+ *
+ * \details	Runs outside of imu_update, which only applies the coefficients
+ *
+ * \param	imu						The pointer to the IMU structure
+ *
+ * \return	The result of the task
+ */
+task_return_t imu_update_filter(imu_t *imu);
+
+
+/**
+ * \brief	Adds a gyroscope sample to the rotation of the next attitude update
+ *
+ * \param	imu						The pointer to the IMU structure
+ * \param	rates					The angular rates, scaled and without biais (rad/s)
+ * \param	dt						The time covered by the sample (s)
+ */
+void imu_integrate_gyro(imu_t *imu, const float rates[3], float dt);
+
+
+/**
+ * \brief	Gets the rotation integrated since the last call, and starts a new integration
+ *
+ * \param	imu						The pointer to the IMU structure
+ * \param	rotation				The rotation vector in body frame (rad), output
+ * \param	dt						The time covered by the rotation (s), output
+ *
+ * \return	False if no sample was integrated since the last call
+ */
+bool imu_get_rotation(imu_t *imu, float rotation[3], float* dt);
+
 #ifdef __cplusplus
 }
 #endif
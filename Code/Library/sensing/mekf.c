@@ -0,0 +1,329 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file mekf.c
+ * 
+ * \author MAV'RIC Team
+ *   
+ * \brief This file implements a multiplicative extended Kalman filter for the 
+ * attitude estimation
+ *
+ ******************************************************************************/
+
+
+#include "mekf.h"
+#include "qfilter.h"			// for the calibration levels
+#include "conf_platform.h"
+#include "print_util.h" 
+#include "time_keeper.h"
+#include <math.h>
+#include "maths.h"
+#include "vectors.h"
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS DECLARATION
+//------------------------------------------------------------------------------
+
+/**
+ * \brief	Propagates the covariance of the error state
+ *
+ * The transition matrix is [[I - [w x], -dt I], [0, I]]. The products are 
+ * expanded per 3x3 block, and the multiplications by the skew symmetric matrix 
+ * [w x] are done as cross products, so the zero blocks are never computed.
+ *
+ * \param	mekf		The pointer to the MEKF structure
+ * \param	rotation	The rotation vector w = rates * dt in body frame (rad)
+ * \param	dt			The integration time (s)
+ */
+static void mekf_propagate(mekf_t* mekf, const float rotation[3], float dt);
+
+
+/**
+ * \brief	Corrects the error state with a scalar measurement
+ *
+ * The measurement depends only on the attitude error, so the measurement row 
+ * has 3 non zero entries and the biais only enters through the covariance.
+ *
+ * \param	mekf		The pointer to the MEKF structure
+ * \param	h			The measurement row on the attitude error
+ * \param	innovation	The difference between the measurement and its prediction
+ * \param	variance	The variance of the measurement
+ * \param	error		The error state, updated in place
+ */
+static void mekf_correct(mekf_t* mekf, const float h[3], float innovation, float variance, float error[MEKF_STATE_COUNT]);
+
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+static void mekf_propagate(mekf_t* mekf, const float rotation[3], float dt)
+{
+	int32_t i, j;
+	float (*p)[MEKF_STATE_COUNT] = mekf->covariance;
+	const float* w = rotation;
+	float col[3], tmp[3];
+	float ta[3][3], tb[3][3], a[3][3];
+	
+	// ta = (I - [w x]) A, tb = (I - [w x]) B, column by column
+	for (j = 0; j < 3; j++)
+	{
+		col[0] = p[0][j]; col[1] = p[1][j]; col[2] = p[2][j];
+		CROSS(w, col, tmp);
+		ta[0][j] = col[0] - tmp[0];
+		ta[1][j] = col[1] - tmp[1];
+		ta[2][j] = col[2] - tmp[2];
+		
+		col[0] = p[0][j + 3]; col[1] = p[1][j + 3]; col[2] = p[2][j + 3];
+		CROSS(w, col, tmp);
+		tb[0][j] = col[0] - tmp[0];
+		tb[1][j] = col[1] - tmp[1];
+		tb[2][j] = col[2] - tmp[2];
+	}
+	
+	// a = ta (I - [w x])^T = ta + ta [w x], the row i of ta [w x] being -(w x row i of ta)
+	for (i = 0; i < 3; i++)
+	{
+		CROSS(w, ta[i], tmp);
+		a[i][0] = ta[i][0] - tmp[0];
+		a[i][1] = ta[i][1] - tmp[1];
+		a[i][2] = ta[i][2] - tmp[2];
+	}
+	
+	// A' = a - dt (tb + tb^T) + dt^2 C + Qa, B' = tb - dt C, C' = C + Qb
+	for (i = 0; i < 3; i++)
+	{
+		for (j = i; j < 3; j++)
+		{
+			p[i][j] = 0.5f * (a[i][j] + a[j][i]) - dt * (tb[i][j] + tb[j][i]) + dt * dt * p[i + 3][j + 3];
+			p[j][i] = p[i][j];
+		}
+		p[i][i] += SQR(mekf->gyro_noise) * dt;
+	}
+	for (i = 0; i < 3; i++)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			p[i][j + 3] = tb[i][j] - dt * p[i + 3][j + 3];
+		}
+	}
+	for (i = 0; i < 3; i++)
+	{
+		for (j = 0; j < 3; j++)
+		{
+			p[j + 3][i] = p[i][j + 3];
+		}
+		p[i + 3][i + 3] += SQR(mekf->gyro_bias_noise) * dt;
+	}
+}
+
+
+static void mekf_correct(mekf_t* mekf, const float h[3], float innovation, float variance, float error[MEKF_STATE_COUNT])
+{
+	int32_t i, j;
+	float (*p)[MEKF_STATE_COUNT] = mekf->covariance;
+	float pht[MEKF_STATE_COUNT], gain[MEKF_STATE_COUNT], s;
+	
+	for (i = 0; i < MEKF_STATE_COUNT; i++)
+	{
+		pht[i] = p[i][0] * h[0] + p[i][1] * h[1] + p[i][2] * h[2];
+	}
+	
+	s = h[0] * pht[0] + h[1] * pht[1] + h[2] * pht[2] + variance;
+	if (s < 1e-12f)
+	{
+		return;
+	}
+	
+	// the previous corrections of this step already moved the error state
+	innovation -= h[0] * error[0] + h[1] * error[1] + h[2] * error[2];
+	
+	for (i = 0; i < MEKF_STATE_COUNT; i++)
+	{
+		gain[i] = pht[i] / s;
+		error[i] += gain[i] * innovation;
+	}
+	
+	for (i = 0; i < MEKF_STATE_COUNT; i++)
+	{
+		for (j = i; j < MEKF_STATE_COUNT; j++)
+		{
+			p[i][j] -= gain[i] * pht[j];
+			p[j][i] = p[i][j];
+		}
+	}
+}
+
+
+//------------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+void mekf_init(mekf_t* mekf, imu_t* imu, ahrs_t* ahrs)
+{
+	int32_t i, j;
+	
+	mekf->imu = imu;
+	mekf->ahrs = ahrs;
+	
+	mekf->imu->calibration_level = LEVELING;
+	
+	mekf->gyro_noise = 0.005f;
+	mekf->gyro_bias_noise = 0.0005f;
+	mekf->acc_noise = 0.3f;
+	mekf->acc_dynamic_noise = 2.0f;
+	mekf->mag_noise = 0.1f;
+	
+	for (i = 0; i < MEKF_STATE_COUNT; i++)
+	{
+		for (j = 0; j < MEKF_STATE_COUNT; j++)
+		{
+			mekf->covariance[i][j] = 0.0f;
+		}
+	}
+	for (i = 0; i < 3; i++)
+	{
+		mekf->covariance[i][i] = SQR(0.5f);
+		mekf->covariance[i + 3][i + 3] = SQR(0.05f);
+	}
+	
+	print_util_dbg_print("[MEKF] Initialized.\r\n");
+}
+
+
+void mekf_update(mekf_t* mekf)
+{
+	int32_t i;
+	float error[MEKF_STATE_COUNT] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+	float h[3], acc[3], rotation[3], rotation_dt, s_acc_norm, acc_norm, s_mag_norm, variance_scale;
+	quat_t up, up_bf, qtmp1, mag_global;
+	const quat_t front_vec_global = 
+	{
+		.s = 0.0f, 
+		.v = {1.0f, 0.0f, 0.0f}
+	};
+	
+	// Update time
+	uint32_t t = time_keeper_get_time_ticks();
+	float dt = time_keeper_ticks_to_seconds(t - mekf->ahrs->last_update);
+	mekf->ahrs->dt = dt;
+	mekf->ahrs->last_update = t;
+	
+	// Prediction, the biais is already removed from the gyro rates. The 
+	// covariance is propagated over the time covered by the rotation, which 
+	// is the span of the gyroscope samples rather than the time between updates
+	if (!imu_get_rotation(mekf->imu, rotation, &rotation_dt))
+	{
+		for (i = 0; i < 3; i++)
+		{
+			rotation[i] = mekf->imu->scaled_gyro.data[i] * dt;
+		}
+		rotation_dt = dt;
+	}
+	mekf->ahrs->qe = quaternions_integrate(mekf->ahrs->qe, rotation);
+	mekf_propagate(mekf, rotation, rotation_dt);
+	
+	// Trust the measurements more while levelling
+	if (mekf->imu->calibration_level == LEVELING)
+	{
+		variance_scale = 0.1f;
+	}
+	else
+	{
+		variance_scale = 1.0f;
+	}
+	
+	// up_bf = qe^-1 *(0,0,0,-1) * qe
+	up.s = 0; up.v[0] = UPVECTOR_X; up.v[1] = UPVECTOR_Y; up.v[2] = UPVECTOR_Z;
+	up_bf = quaternions_global_to_local(mekf->ahrs->qe, up);
+	
+	// Accelerometer correction, d(up_bf) = up_bf x error
+	s_acc_norm = SQR(mekf->imu->scaled_accelero.data[0]) + SQR(mekf->imu->scaled_accelero.data[1]) + SQR(mekf->imu->scaled_accelero.data[2]);
+	if ( (s_acc_norm > 0.7f * 0.7f) && (s_acc_norm < 1.3f * 1.3f) ) 
+	{
+		acc_norm = maths_fast_sqrt(s_acc_norm);
+		float variance = variance_scale * (SQR(mekf->acc_noise) + SQR(mekf->acc_dynamic_noise * (acc_norm - 1.0f)));
+		
+		for (i = 0; i < 3; i++)
+		{
+			acc[i] = mekf->imu->scaled_accelero.data[i] / acc_norm;
+		}
+		
+		h[0] = 0.0f; h[1] = -up_bf.v[2]; h[2] = up_bf.v[1];
+		mekf_correct(mekf, h, acc[0] - up_bf.v[0], variance, error);
+		
+		h[0] = up_bf.v[2]; h[1] = 0.0f; h[2] = -up_bf.v[0];
+		mekf_correct(mekf, h, acc[1] - up_bf.v[1], variance, error);
+		
+		h[0] = -up_bf.v[1]; h[1] = up_bf.v[0]; h[2] = 0.0f;
+		mekf_correct(mekf, h, acc[2] - up_bf.v[2], variance, error);
+	}
+	
+	// Magnetometer heading correction, only along the global vertical axis
+	qtmp1 = quaternions_create_from_vector(mekf->imu->scaled_compass.data); 
+	mag_global = quaternions_local_to_global(mekf->ahrs->qe, qtmp1);
+	
+	s_mag_norm = SQR(mag_global.v[0]) + SQR(mag_global.v[1]);
+	if ( (s_mag_norm > 0.004f * 0.004f) && (s_mag_norm < 1.8f * 1.8f) ) 
+	{
+		mekf->ahrs->north_vec = quaternions_global_to_local(mekf->ahrs->qe, front_vec_global);
+		
+		// the global z axis points down, opposite to the up vector
+		h[0] = -up_bf.v[0]; h[1] = -up_bf.v[1]; h[2] = -up_bf.v[2];
+		mekf_correct(mekf, h, -atan2f(mag_global.v[1], mag_global.v[0]), variance_scale * SQR(mekf->mag_noise), error);
+	}
+	
+	// Fold the error into the attitude and the gyro biais, the error state is back to 0
+	qtmp1.s = 1.0f;
+	qtmp1.v[0] = 0.5f * error[0];
+	qtmp1.v[1] = 0.5f * error[1];
+	qtmp1.v[2] = 0.5f * error[2];
+	mekf->ahrs->qe = quaternions_normalise(quaternions_multiply(mekf->ahrs->qe, qtmp1));
+	
+	for (i = 0; i < 3; i++)
+	{
+		mekf->imu->calib_gyro.bias[i] += error[i + 3] / mekf->imu->calib_gyro.scale_factor[i];
+	}
+	
+	// set up-vector (bodyframe) in attitude
+	mekf->ahrs->up_vec = quaternions_global_to_local(mekf->ahrs->qe, up);
+	
+	// Update linear acceleration
+	mekf->ahrs->linear_acc[0] = 9.81f * (mekf->imu->scaled_accelero.data[0] - mekf->ahrs->up_vec.v[0]);
+	mekf->ahrs->linear_acc[1] = 9.81f * (mekf->imu->scaled_accelero.data[1] - mekf->ahrs->up_vec.v[1]);
+	mekf->ahrs->linear_acc[2] = 9.81f * (mekf->imu->scaled_accelero.data[2] - mekf->ahrs->up_vec.v[2]);
+	
+	//update angular_speed, with the biais estimated in this step
+	mekf->ahrs->angular_speed[X] = mekf->imu->scaled_gyro.data[X] - error[X + 3];
+	mekf->ahrs->angular_speed[Y] = mekf->imu->scaled_gyro.data[Y] - error[Y + 3];
+	mekf->ahrs->angular_speed[Z] = mekf->imu->scaled_gyro.data[Z] - error[Z + 3];
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file mekf.h
+ * 
+ * \author MAV'RIC Team
+ *   
+ * \brief This file implements a multiplicative extended Kalman filter for the 
+ * attitude estimation
+ *
+ * The filter estimates a 3 dimensional attitude error and the gyroscope biais.
+ * The error is folded into the attitude quaternion and the biais into the 
+ * gyroscope calibration after each update, so that the error state stays 
+ * small and its Jacobians keep their sparse structure.
+ *
+ ******************************************************************************/
+
+
+#ifndef MEKF_H_
+#define MEKF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "imu.h"
+#include "ahrs.h"
+
+#define MEKF_STATE_COUNT 6			///< Attitude error (3) and gyroscope biais (3)
+
+
+/**
+ * \brief The structure for the multiplicative extended Kalman filter
+ */
+typedef struct
+{
+	imu_t* 	imu;									///< Pointer to inertial sensors readout
+	ahrs_t* ahrs;									///< Pointer to estimated attiude
+	
+	float	covariance[MEKF_STATE_COUNT][MEKF_STATE_COUNT];	///< The covariance of the error state
+	
+	float   gyro_noise;								///< The noise density of the gyroscope (rad/s/sqrt(Hz))
+	float   gyro_bias_noise;						///< The random walk of the gyroscope biais (rad/s^2/sqrt(Hz))
+	float   acc_noise;								///< The standard deviation of the normalised acceleration
+	float   acc_dynamic_noise;						///< The standard deviation added per g of acceleration norm away from 1 g
+	float   mag_noise;								///< The standard deviation of the heading measured by the magnetometer (rad)
+} mekf_t;
+
+
+/**
+ * \brief	Initialize the multiplicative extended Kalman filter
+ *
+ * \param	mekf				The pointer to the MEKF structure
+ * \param	imu					The pointer to the IMU structure
+ * \param	ahrs				The pointer to the attitude estimation structure
+ */
+void mekf_init(mekf_t* mekf, imu_t* imu, ahrs_t* ahrs);
+
+
+/**
+ * \brief	Performs the attitude estimation via the multiplicative extended Kalman filter
+ *
+ * \param	mekf		The pointer to the MEKF structure
+ */
+void mekf_update(mekf_t* mekf);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEKF_H_ */
\ No newline at end of file
@@ -69,8 +69,8 @@ void qfilter_init(qfilter_t* qf, imu_t* imu, ahrs_t* ahrs)
 void qfilter_update(qfilter_t *qf)
 {
 	uint8_t i;
-	float  omc[3], omc_mag[3] , tmp[3], snorm, norm, s_acc_norm, acc_norm, s_mag_norm, mag_norm;
-	quat_t qed, qtmp1, up, up_bf;
+	float  omc[3], omc_mag[3] , tmp[3], rotation[3], rotation_dt, s_acc_norm, acc_norm, s_mag_norm, mag_norm;
+	quat_t qtmp1, up, up_bf;
 	quat_t mag_global, mag_corrected_local;
 	quat_t front_vec_global = 
 	{
@@ -176,42 +176,30 @@ void qfilter_update(qfilter_t *qf)
 			break;
 	}
 
-	// apply error correction with appropriate gains for accelerometer and compass
+	// rotation measured by the gyroscope since the last update, the 
+	// corrections are integrated over the same time
+	if (!imu_get_rotation(qf->imu, rotation, &rotation_dt))
+	{
+		for (i = 0; i < 3; i++)
+		{
+			rotation[i] = qf->imu->scaled_gyro.data[i] * dt;
+		}
+		rotation_dt = dt;
+	}
 
+	// apply error correction with appropriate gains for accelerometer and compass
 	for (i = 0; i < 3; i++)
 	{
-		qtmp1.v[i] = 0.5f * (qf->imu->scaled_gyro.data[i] + kp * omc[i] + kp_mag * omc_mag[i]);
+		rotation[i] += (kp * omc[i] + kp_mag * omc_mag[i]) * rotation_dt;
 	}
-	qtmp1.s = 0;
 
 	// apply step rotation with corrections
-	qed = quaternions_multiply(qf->ahrs->qe,qtmp1);
-
-	// TODO: correct this formulas! 
-	qf->ahrs->qe.s = qf->ahrs->qe.s + qed.s * dt;
-	qf->ahrs->qe.v[0] += qed.v[0] * dt;
-	qf->ahrs->qe.v[1] += qed.v[1] * dt;
-	qf->ahrs->qe.v[2] += qed.v[2] * dt;
-
-	snorm = qf->ahrs->qe.s * qf->ahrs->qe.s + qf->ahrs->qe.v[0] * qf->ahrs->qe.v[0] + qf->ahrs->qe.v[1] * qf->ahrs->qe.v[1] + qf->ahrs->qe.v[2] * qf->ahrs->qe.v[2];
-	if (snorm < 0.0001f)
-	{
-		norm = 0.01f;
-	}
-	else
-	{
-		// approximate square root by running 2 iterations of newton method
-		norm = maths_fast_sqrt(snorm);
-	}
-	qf->ahrs->qe.s /= norm;
-	qf->ahrs->qe.v[0] /= norm;
-	qf->ahrs->qe.v[1] /= norm;
-	qf->ahrs->qe.v[2] /= norm;
+	qf->ahrs->qe = quaternions_integrate(qf->ahrs->qe, rotation);
 
 	// bias estimate update
-	qf->imu->calib_gyro.bias[0] += - dt * qf->ki * omc[0] / qf->imu->calib_gyro.scale_factor[0];
-	qf->imu->calib_gyro.bias[1] += - dt * qf->ki * omc[1] / qf->imu->calib_gyro.scale_factor[1];
-	qf->imu->calib_gyro.bias[2] += - dt * qf->ki * omc[2] / qf->imu->calib_gyro.scale_factor[2];
+	qf->imu->calib_gyro.bias[0] += - rotation_dt * qf->ki * omc[0] / qf->imu->calib_gyro.scale_factor[0];
+	qf->imu->calib_gyro.bias[1] += - rotation_dt * qf->ki * omc[1] / qf->imu->calib_gyro.scale_factor[1];
+	qf->imu->calib_gyro.bias[2] += - rotation_dt * qf->ki * omc[2] / qf->imu->calib_gyro.scale_factor[2];
 
 	// set up-vector (bodyframe) in attitude
 	qf->ahrs->up_vec.v[0] = up_bf.v[0];
@@ -307,7 +307,7 @@ void simulation_calib_set(simulation_model_t *sim)
 void simulation_update(simulation_model_t *sim)
 {
 	int32_t i;
-	quat_t qtmp1, qvel_bf,  qed;
+	quat_t qtmp1, qvel_bf;
 	const quat_t front = {.s = 0.0f, .v = {1.0f, 0.0f, 0.0f}};
 	const quat_t up = {.s = 0.0f, .v = {UPVECTOR_X, UPVECTOR_Y, UPVECTOR_Z}};
 	
@@ -334,23 +334,14 @@ void simulation_update(simulation_model_t *sim)
 	sim->rates_bf[2] = maths_clip((1.0f - 0.1f * sim->dt) * sim->rates_bf[2] + sim->dt * sim->torques_bf[2] / sim->vehicle_config.yaw_momentum, 10.0f);
 	
 	
+	float rotation[3];
 	for (i = 0; i < 3; i++)
 	{
-			qtmp1.v[i] = 0.5f * sim->rates_bf[i];
+			rotation[i] = sim->rates_bf[i] * sim->dt;
 	}
-	
-	qtmp1.s = 0;
 
 	// apply step rotation 
-	qed = quaternions_multiply(sim->ahrs.qe,qtmp1);
-
-	// TODO: correct this formulas when using the right scales
-	sim->ahrs.qe.s = sim->ahrs.qe.s + qed.s * sim->dt;
-	sim->ahrs.qe.v[0] += qed.v[0] * sim->dt;
-	sim->ahrs.qe.v[1] += qed.v[1] * sim->dt;
-	sim->ahrs.qe.v[2] += qed.v[2] * sim->dt;
-
-	sim->ahrs.qe = quaternions_normalise(sim->ahrs.qe);
+	sim->ahrs.qe = quaternions_integrate(sim->ahrs.qe, rotation);
 	sim->ahrs.up_vec = quaternions_global_to_local(sim->ahrs.qe, up);
 	
 	sim->ahrs.north_vec = quaternions_global_to_local(sim->ahrs.qe, front);	
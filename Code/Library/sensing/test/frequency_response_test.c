@@ -0,0 +1,408 @@
+/*******************************************************************************
+ * \file frequency_response_test.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host test of the frequency response of the filter bank and of the
+ * peak detection of the vibration analyser
+ *
+ * \details Known sinusoids are driven through biquad_bank_update(): the gain
+ * of each channel is measured by correlation over whole periods, and checked
+ * against the transfer function of the coefficients and against the design
+ * of the filters (depth of the notches, -3dB points, low-pass roll off).
+ *
+ * The same kind of sinusoids are fed to the vibration analyser through the
+ * IMU structure, its dependencies being stubbed (stubs/). The analysis runs as a resumable task on a
+ * simulated clock, the peaks it finds must be within one bin of the driven
+ * frequencies, and the notches it places must attenuate them.
+ *
+ * Build and run on the host with "make" in this directory.
+ *
+ ******************************************************************************/
+
+
+#include <stdio.h>
+#include <math.h>
+#include "biquad_bank.h"
+#include "vibration_analyser.h"
+
+#define TEST_SAMPLE_RATE 1000.0f				///< Rate of the filter bank and of the IMU updates (Hz)
+#define TEST_SETTLE_SAMPLES 3000				///< Samples run before measuring a gain, for the transient to decay
+#define TEST_MEASURE_SAMPLES 1000				///< Samples of a gain measurement, whole periods for integer frequencies
+#define TEST_MODEL_TOLERANCE 0.002f				///< Difference allowed between a measured gain and the transfer function
+
+#define TEST_NOTCH_FREQUENCY 80.0f				///< Centre of the first notch (Hz)
+#define TEST_NOTCH2_FREQUENCY 160.0f			///< Centre of the second notch (Hz)
+#define TEST_NOTCH_BANDWIDTH 20.0f				///< Bandwidth of the notches (Hz)
+#define TEST_NOTCH_DEPTH 0.01f					///< Maximum gain at the centre of a notch (-40dB)
+#define TEST_LOWPASS_CUTOFF 20.0f				///< Cutoff of the low-pass channels (Hz)
+
+#define TEST_DECIMATION 2						///< Decimation of the vibration analyser
+#define TEST_TIME_BUDGET 200					///< Time budget of an invocation of the analysis (us)
+#define TEST_MICROS_PER_CALL 3					///< Simulated time spent between two reads of the clock (us)
+#define TEST_MAX_INVOCATIONS 10000				///< Invocations after which an analysis is considered stuck
+#define TEST_TRACKED_NOTCH_BANDWIDTH 10.0f		///< Bandwidth of the notches placed on the detected peaks (Hz)
+#define TEST_TRACKED_NOTCH_DEPTH 0.25f			///< Maximum gain of a driven sinusoid through the placed notches (-12dB)
+
+static uint32_t test_micros = 0;				///< The simulated time
+static uint32_t filter_updates = 0;				///< Number of calls to imu_update_filter()
+static uint32_t failures = 0;					///< Number of failed checks
+
+
+uint32_t time_keeper_get_micros(void)
+{
+	test_micros += TEST_MICROS_PER_CALL;
+	return test_micros;
+}
+
+
+task_return_t imu_update_filter(imu_t *imu)
+{
+	(void)imu;
+	filter_updates++;
+	return TASK_RUN_SUCCESS;
+}
+
+
+/**
+ * \brief	Counts a failed check and prints it
+ *
+ * \param	ok				The result of the check
+ * \param	what			The description of the check
+ * \param	value			The value checked
+ */
+static void test_check(bool ok, const char* what, float value)
+{
+	if (!ok)
+	{
+		printf("  FAILED: %s (%g)\n", what, value);
+		failures++;
+	}
+}
+
+
+/**
+ * \brief	Computes the gain of a channel of the bank from its coefficients
+ *
+ * \param	bank			Pointer to the filter bank
+ * \param	channel			The channel
+ * \param	frequency		The frequency (Hz)
+ *
+ * \return	The magnitude of the transfer function of the cascaded stages
+ */
+static double test_model_gain(const biquad_bank_t* bank, uint8_t channel, float frequency)
+{
+	double omega = 2.0 * M_PI * frequency / TEST_SAMPLE_RATE;
+	double gain = 1.0;
+	double c1 = cos(omega), s1 = sin(omega), c2 = cos(2.0 * omega), s2 = sin(2.0 * omega);
+	uint8_t i;
+
+	for (i = 0; i < bank->stage_count; i++)
+	{
+		// H(z) at z = exp(i omega), with z^-1 = c1 - i s1 and z^-2 = c2 - i s2
+		double num_re = bank->b0[i][channel] + bank->b1[i][channel] * c1 + bank->b2[i][channel] * c2;
+		double num_im = -bank->b1[i][channel] * s1 - bank->b2[i][channel] * s2;
+		double den_re = 1.0 + bank->a1[i][channel] * c1 + bank->a2[i][channel] * c2;
+		double den_im = -bank->a1[i][channel] * s1 - bank->a2[i][channel] * s2;
+
+		gain *= sqrt( (num_re * num_re + num_im * num_im) / (den_re * den_re + den_im * den_im) );
+	}
+
+	return gain;
+}
+
+
+/**
+ * \brief	Measures the gain of every channel of the bank for a sinusoid
+ *
+ * \details	The states are cleared, the sinusoid is driven on all channels and the
+ *			amplitude of the output at the driven frequency is found by correlation
+ *
+ * \param	bank			Pointer to the filter bank
+ * \param	frequency		The frequency (Hz)
+ * \param	gain			The gain of each channel
+ */
+static void test_measure_gain(biquad_bank_t* bank, float frequency, float gain[BIQUAD_BANK_CHANNELS])
+{
+	const float zeros[BIQUAD_BANK_CHANNELS] = {0.0f};
+	float values[BIQUAD_BANK_CHANNELS];
+	double in_phase[BIQUAD_BANK_CHANNELS] = {0.0}, quadrature[BIQUAD_BANK_CHANNELS] = {0.0};
+	double phase;
+	uint32_t n;
+	uint8_t j;
+
+	biquad_bank_prime(bank, zeros);
+
+	for (n = 0; n < TEST_SETTLE_SAMPLES + TEST_MEASURE_SAMPLES; n++)
+	{
+		phase = 2.0 * M_PI * fmod((double)frequency * n / TEST_SAMPLE_RATE, 1.0);
+
+		for (j = 0; j < BIQUAD_BANK_CHANNELS; j++)
+		{
+			values[j] = (float)sin(phase);
+		}
+
+		biquad_bank_update(bank, values);
+
+		if (n >= TEST_SETTLE_SAMPLES)
+		{
+			for (j = 0; j < BIQUAD_BANK_CHANNELS; j++)
+			{
+				in_phase[j] += values[j] * sin(phase);
+				quadrature[j] += values[j] * cos(phase);
+			}
+		}
+	}
+
+	for (j = 0; j < BIQUAD_BANK_CHANNELS; j++)
+	{
+		gain[j] = (float)(2.0 * sqrt(in_phase[j] * in_phase[j] + quadrature[j] * quadrature[j]) / TEST_MEASURE_SAMPLES);
+	}
+}
+
+
+/**
+ * \brief	Drives sinusoids through a bank with two notches on channels 0 to 2,
+ *			a low-pass filter on channels 3 to 5 and channels 6 to 8 unfiltered
+ */
+static void test_biquad_bank(void)
+{
+	biquad_bank_t bank;
+	float gain[BIQUAD_BANK_CHANNELS];
+	float frequency, model, error, max_error = 0.0f;
+	float notch_depth = 0.0f, notch_edge_min = 1.0f, notch_edge_max = 0.0f;
+	uint8_t j;
+
+	biquad_bank_init(&bank);
+	biquad_bank_set_notch(&bank, 0, 0, 3, TEST_NOTCH_FREQUENCY, TEST_NOTCH_BANDWIDTH, TEST_SAMPLE_RATE);
+	biquad_bank_set_notch(&bank, 1, 0, 3, TEST_NOTCH2_FREQUENCY, TEST_NOTCH_BANDWIDTH, TEST_SAMPLE_RATE);
+	biquad_bank_set_lowpass(&bank, 0, 3, 3, TEST_LOWPASS_CUTOFF, TEST_SAMPLE_RATE);
+
+	// Sweep, every measured gain follows the transfer function
+	for (frequency = 5.0f; frequency < 0.5f * TEST_SAMPLE_RATE; frequency += 5.0f)
+	{
+		test_measure_gain(&bank, frequency, gain);
+
+		for (j = 0; j < BIQUAD_BANK_CHANNELS; j++)
+		{
+			model = (float)test_model_gain(&bank, j, frequency);
+			error = fabsf(gain[j] - model);
+			if (error > max_error)
+			{
+				max_error = error;
+			}
+			test_check(error <= TEST_MODEL_TOLERANCE, "measured gain differs from the transfer function", error);
+			test_check( (j < 3) || (gain[j] == gain[3 * (j / 3)]), "channels with the same filter differ", gain[j]);
+		}
+
+		test_check(fabsf(gain[6] - 1.0f) <= 1e-4f, "unfiltered channel is not passed through", gain[6]);
+	}
+
+	// Notches, deep at the centre and -3dB at half the bandwidth from it
+	test_measure_gain(&bank, TEST_NOTCH_FREQUENCY, gain);
+	notch_depth = gain[0];
+	test_measure_gain(&bank, TEST_NOTCH2_FREQUENCY, gain);
+	notch_depth = fmaxf(notch_depth, gain[0]);
+	test_check(notch_depth <= TEST_NOTCH_DEPTH, "notch centre not attenuated", notch_depth);
+
+	test_measure_gain(&bank, TEST_NOTCH_FREQUENCY - 0.5f * TEST_NOTCH_BANDWIDTH, gain);
+	notch_edge_min = fminf(notch_edge_min, gain[0]);
+	notch_edge_max = fmaxf(notch_edge_max, gain[0]);
+	test_measure_gain(&bank, TEST_NOTCH_FREQUENCY + 0.5f * TEST_NOTCH_BANDWIDTH, gain);
+	notch_edge_min = fminf(notch_edge_min, gain[0]);
+	notch_edge_max = fmaxf(notch_edge_max, gain[0]);
+	test_check( (notch_edge_min >= 0.6f) && (notch_edge_max <= 0.8f), "notch edges not near -3dB", notch_edge_min);
+
+	test_measure_gain(&bank, 10.0f, gain);
+	test_check(gain[0] >= 0.98f, "notch attenuates the pass band", gain[0]);
+
+	// Low-pass, -3dB at the cutoff and -34dB a decade above
+	test_measure_gain(&bank, TEST_LOWPASS_CUTOFF, gain);
+	test_check(fabsf(gain[3] - 0.70710678f) <= 0.01f, "low-pass not -3dB at the cutoff", gain[3]);
+	test_measure_gain(&bank, 10.0f * TEST_LOWPASS_CUTOFF, gain);
+	test_check(gain[3] <= 0.02f, "low-pass does not roll off", gain[3]);
+
+	printf("Filter bank: notch depth %.1f dB, notch edges %.2f to %.2f, transfer function error %.1e\n",
+		20.0f * log10f(notch_depth), notch_edge_min, notch_edge_max, max_error);
+}
+
+
+/**
+ * \brief	Feeds sinusoids to the vibration analyser and runs an analysis
+ *
+ * \param	analyser		Pointer to the vibration analyser, initialised
+ * \param	imu				Pointer to the IMU stub of the analyser
+ * \param	gyro_frequency	The frequencies of the sinusoids on gyroscope X and Y (Hz)
+ * \param	gyro_amplitude	The amplitudes of the sinusoids on gyroscope X and Y (rad/s)
+ * \param	acc_frequency	The frequency of the sinusoid on accelerometer Z (Hz)
+ * \param	acc_amplitude	The amplitude of the sinusoid on accelerometer Z
+ * \param	invocations		The number of invocations of the analysis
+ * \param	max_duration	The longest simulated duration of an invocation, from its first clock read (us)
+ *
+ * \return	False if the analysis did not complete
+ */
+static bool test_run_analysis(vibration_analyser_t* analyser, imu_t* imu, const float gyro_frequency[2], const float gyro_amplitude[2],
+	float acc_frequency, float acc_amplitude, uint32_t* invocations, uint32_t* max_duration)
+{
+	uint32_t n, completed = analyser->analysis_count;
+	double t;
+	task_return_t result;
+
+	for (n = 0; n < TEST_DECIMATION * VIBRATION_FFT_SIZE + 37; n++)
+	{
+		t = n / (double)TEST_SAMPLE_RATE;
+
+		// A constant offset on every axis, removed with the mean
+		imu->oriented_gyro.data[0] = 0.02f + gyro_amplitude[0] * (float)sin(2.0 * M_PI * gyro_frequency[0] * t);
+		imu->oriented_gyro.data[1] = -0.01f + gyro_amplitude[1] * (float)sin(2.0 * M_PI * gyro_frequency[1] * t + 1.0);
+		imu->oriented_gyro.data[2] = 0.03f;
+		imu->oriented_accelero.data[0] = 0.1f;
+		imu->oriented_accelero.data[1] = -0.2f;
+		imu->oriented_accelero.data[2] = -9.81f + acc_amplitude * (float)sin(2.0 * M_PI * acc_frequency * t + 2.0);
+
+		vibration_analyser_add_sample(analyser);
+	}
+
+	*invocations = 0;
+	*max_duration = 0;
+	do
+	{
+		result = vibration_analyser_update(analyser);
+		if (test_micros - analyser->coroutine.slice_start > *max_duration)
+		{
+			*max_duration = test_micros - analyser->coroutine.slice_start;
+		}
+		(*invocations)++;
+	}
+	while ( (result == TASK_RUN_BLOCKED) && (*invocations < TEST_MAX_INVOCATIONS) );
+
+	return (result == TASK_RUN_SUCCESS) && (analyser->analysis_count == completed + 1);
+}
+
+
+/**
+ * \brief	Checks that the peaks found by the vibration analyser are within one bin of
+ *			the driven sinusoids, and that the notches placed on them attenuate them
+ */
+static void test_vibration_analyser(void)
+{
+	static const float gyro_frequencies[][2] = {{87.0f, 151.3f}, {33.3f, 201.7f}, {62.5f, 105.1f}, {180.4f, 47.9f}};
+	static const float acc_frequencies[] = {40.2f, 120.0f, 230.0f, 71.7f};
+	const float gyro_amplitude[2] = {0.5f, 0.25f};
+	const float acc_amplitude = 2.0f;
+	const float sample_rate = TEST_SAMPLE_RATE / TEST_DECIMATION;
+	const float bin = sample_rate / VIBRATION_FFT_SIZE;
+	const vibration_analyser_conf_t config =
+	{
+		.decimation = TEST_DECIMATION,
+		.min_frequency = 10.0f,
+		.min_amplitude = 0.1f,
+		.time_budget = TEST_TIME_BUDGET,
+		.notch_tracking = true,
+	};
+
+	static vibration_analyser_t analyser;
+	static imu_t imu;
+	biquad_bank_t bank;
+	float gain[BIQUAD_BANK_CHANNELS];
+	float expected, error, max_bin_error = 0.0f, max_amplitude_error = 0.0f, max_notch_gain = 0.0f;
+	float low, high;
+	uint32_t invocations, max_invocations = 0, duration, max_duration = 0, updates;
+	uint8_t c, i, k;
+
+	for (c = 0; c < sizeof(acc_frequencies) / sizeof(acc_frequencies[0]); c++)
+	{
+		for (i = 0; i < 3; i++)
+		{
+			imu.calib_gyro.bias[i] = 0.0f;
+			imu.calib_gyro.scale_factor[i] = 1.0f;
+			imu.calib_accelero.bias[i] = 0.0f;
+			imu.calib_accelero.scale_factor[i] = 1.0f;
+		}
+		for (i = 0; i < IMU_NOTCH_COUNT; i++)
+		{
+			imu.filter_config.notch_frequency[i] = 0.0f;
+			imu.filter_config.notch_bandwidth[i] = TEST_TRACKED_NOTCH_BANDWIDTH;
+		}
+		imu.filter_config.sample_rate = TEST_SAMPLE_RATE;
+
+		vibration_analyser_init(&analyser, &config, &imu);
+		updates = filter_updates;
+
+		if (!test_run_analysis(&analyser, &imu, gyro_frequencies[c], gyro_amplitude, acc_frequencies[c], acc_amplitude, &invocations, &duration))
+		{
+			test_check(false, "analysis did not complete", invocations);
+			continue;
+		}
+		max_invocations = invocations > max_invocations ? invocations : max_invocations;
+		max_duration = duration > max_duration ? duration : max_duration;
+
+		// Peaks by decreasing amplitude, the decimation averages pairs of samples
+		for (k = 0; k < 2; k++)
+		{
+			error = fabsf(analyser.peaks[VIBRATION_GYRO].frequency[k] - gyro_frequencies[c][k]) / bin;
+			max_bin_error = fmaxf(max_bin_error, error);
+			test_check(error <= 1.0f, "gyroscope peak more than one bin away", analyser.peaks[VIBRATION_GYRO].frequency[k]);
+
+			expected = gyro_amplitude[k] * fabsf(cosf(PI * gyro_frequencies[c][k] / TEST_SAMPLE_RATE));
+			error = fabsf(analyser.peaks[VIBRATION_GYRO].amplitude[k] - expected) / expected;
+			max_amplitude_error = fmaxf(max_amplitude_error, error);
+			test_check(error <= 0.1f, "gyroscope peak amplitude", analyser.peaks[VIBRATION_GYRO].amplitude[k]);
+		}
+		test_check(analyser.peaks[VIBRATION_GYRO].amplitude[2] < 0.1f * gyro_amplitude[1], "spurious gyroscope peak", analyser.peaks[VIBRATION_GYRO].amplitude[2]);
+
+		error = fabsf(analyser.peaks[VIBRATION_ACCELERO].frequency[0] - acc_frequencies[c]) / bin;
+		max_bin_error = fmaxf(max_bin_error, error);
+		test_check(error <= 1.0f, "accelerometer peak more than one bin away", analyser.peaks[VIBRATION_ACCELERO].frequency[0]);
+
+		expected = acc_amplitude * fabsf(cosf(PI * acc_frequencies[c] / TEST_SAMPLE_RATE));
+		error = fabsf(analyser.peaks[VIBRATION_ACCELERO].amplitude[0] - expected) / expected;
+		max_amplitude_error = fmaxf(max_amplitude_error, error);
+		test_check(error <= 0.1f, "accelerometer peak amplitude", analyser.peaks[VIBRATION_ACCELERO].amplitude[0]);
+
+		// Notches on the gyroscope peaks, by increasing frequency
+		test_check(filter_updates == updates + 1, "filters not updated after the analysis", filter_updates - updates);
+
+		low = fminf(gyro_frequencies[c][0], gyro_frequencies[c][1]);
+		high = fmaxf(gyro_frequencies[c][0], gyro_frequencies[c][1]);
+		test_check(fabsf(imu.filter_config.notch_frequency[0] - low) <= bin, "first notch not on the lower peak", imu.filter_config.notch_frequency[0]);
+		test_check(fabsf(imu.filter_config.notch_frequency[1] - high) <= bin, "second notch not on the higher peak", imu.filter_config.notch_frequency[1]);
+
+		// The notches placed on the detected peaks attenuate the driven sinusoids
+		biquad_bank_init(&bank);
+		for (i = 0; i < IMU_NOTCH_COUNT; i++)
+		{
+			biquad_bank_set_notch(&bank, i, 0, BIQUAD_BANK_CHANNELS, imu.filter_config.notch_frequency[i], imu.filter_config.notch_bandwidth[i], TEST_SAMPLE_RATE);
+		}
+		for (k = 0; k < 2; k++)
+		{
+			test_measure_gain(&bank, gyro_frequencies[c][k], gain);
+			max_notch_gain = fmaxf(max_notch_gain, gain[0]);
+			test_check(gain[0] <= TEST_TRACKED_NOTCH_DEPTH, "placed notch does not attenuate the peak", gain[0]);
+		}
+	}
+
+	test_check(max_invocations > 1, "analysis never yielded", max_invocations);
+	// The clock read which decides to run a step is not part of its measured duration
+	test_check(max_duration <= TEST_TIME_BUDGET + TEST_MICROS_PER_CALL, "invocation over the time budget", max_duration);
+
+	printf("Vibration analyser: peaks within %.2f bin, amplitudes within %.1f %%, placed notches %.1f dB, "
+		"%u invocations of at most %u us per analysis\n",
+		max_bin_error, 100.0f * max_amplitude_error, 20.0f * log10f(max_notch_gain), (unsigned)max_invocations, (unsigned)max_duration);
+}
+
+
+int main(void)
+{
+	test_biquad_bank();
+	test_vibration_analyser();
+
+	if (failures > 0)
+	{
+		printf("FAILED: %u checks\n", (unsigned)failures);
+		return 1;
+	}
+
+	printf("PASSED\n");
+	return 0;
+}
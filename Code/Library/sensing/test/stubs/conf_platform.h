@@ -0,0 +1,14 @@
+/*******************************************************************************
+ * \file conf_platform.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the platform configuration, not used by the IMU structure
+ *
+ ******************************************************************************/
+
+
+#ifndef CONF_PLATFORM_H_
+#define CONF_PLATFORM_H_
+
+#endif /* CONF_PLATFORM_H_ */
@@ -0,0 +1,16 @@
+/*******************************************************************************
+ * \file print_util.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the debug prints
+ *
+ ******************************************************************************/
+
+
+#ifndef PRINT_UTIL_H_
+#define PRINT_UTIL_H_
+
+#define print_util_dbg_print(s)
+
+#endif /* PRINT_UTIL_H_ */
@@ -0,0 +1,16 @@
+/*******************************************************************************
+ * \file state.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the state structure, only pointed to by the IMU
+ *
+ ******************************************************************************/
+
+
+#ifndef STATE_H_
+#define STATE_H_
+
+typedef struct state state_t;
+
+#endif /* STATE_H_ */
@@ -0,0 +1,18 @@
+/*******************************************************************************
+ * \file time_keeper.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Host stub of the time keeper, the time is simulated by the test
+ *
+ ******************************************************************************/
+
+
+#ifndef TIME_KEEPER_H_
+#define TIME_KEEPER_H_
+
+#include <stdint.h>
+
+uint32_t time_keeper_get_micros(void);
+
+#endif /* TIME_KEEPER_H_ */
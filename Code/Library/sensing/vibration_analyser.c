@@ -0,0 +1,435 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file vibration_analyser.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Spectrum analysis of the gyroscope and accelerometer vibrations
+ *
+ ******************************************************************************/
+
+
+#include "vibration_analyser.h"
+#include "time_keeper.h"
+#include "print_util.h"
+#include "maths.h"
+#include <math.h>
+
+#define VIBRATION_FFT_MASK (VIBRATION_FFT_SIZE - 1)		///< Mask to wrap the indexes of the ring buffer
+#define VIBRATION_NOTCH_HYSTERESIS 1.0f					///< Change of peak frequency from which a notch is moved (Hz)
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS DECLARATION
+//------------------------------------------------------------------------------
+
+/**
+ * \brief	Copies the last samples of a pair of channels in the FFT input, the first
+ *			channel as real part and the second as imaginary part
+ *
+ * \details	The mean is removed and the window applied, the samples are stored in bit
+ *			reversed order
+ *
+ * \param	analyser				The pointer to the vibration analyser structure
+ */
+static void vibration_analyser_copy_pair(vibration_analyser_t* analyser);
+
+
+/**
+ * \brief	Adds a batch of bins of the pair of channels to the power spectra of their sensors
+ *
+ * \details	The spectra X and Y of the two real channels are separated from the
+ *			FFT Z = X + iY by X[k] = (Z[k] + Z*[N-k]) / 2 and Y[k] = (Z[k] - Z*[N-k]) / 2i
+ *
+ * \param	analyser				The pointer to the vibration analyser structure
+ */
+static void vibration_analyser_add_spectrum(vibration_analyser_t* analyser);
+
+
+/**
+ * \brief	Finds the strongest peaks of the power spectrum of each sensor
+ *
+ * \param	analyser				The pointer to the vibration analyser structure
+ */
+static void vibration_analyser_find_peaks(vibration_analyser_t* analyser);
+
+
+/**
+ * \brief	Moves the notch filters of the IMU onto the strongest gyroscope peaks
+ *
+ * \param	analyser				The pointer to the vibration analyser structure
+ */
+static void vibration_analyser_track_notches(vibration_analyser_t* analyser);
+
+
+/**
+ * \brief	Runs a step of the analysis and measures its execution time
+ *
+ * \param	analyser				The pointer to the vibration analyser structure
+ * \param	step					The kind of step
+ */
+static void vibration_analyser_run_step(vibration_analyser_t* analyser, vibration_step_t step);
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+static void vibration_analyser_copy_pair(vibration_analyser_t* analyser)
+{
+	uint16_t i, index, position;
+	const float* first = analyser->samples[2 * analyser->pair];
+	const float* second = analyser->samples[2 * analyser->pair + 1];
+	float mean_first = 0.0f, mean_second = 0.0f;
+
+	for (i = 0; i < VIBRATION_FFT_SIZE; i++)
+	{
+		mean_first += first[i];
+		mean_second += second[i];
+	}
+	mean_first /= VIBRATION_FFT_SIZE;
+	mean_second /= VIBRATION_FFT_SIZE;
+
+	// from the oldest sample, at head once the buffer is full
+	for (i = 0; i < VIBRATION_FFT_SIZE; i++)
+	{
+		index = (analyser->head + i) & VIBRATION_FFT_MASK;
+		position = fft_bit_reversed_index(&analyser->fft, i);
+
+		analyser->re[position] = (first[index] - mean_first) * analyser->window[i];
+		analyser->im[position] = (second[index] - mean_second) * analyser->window[i];
+	}
+
+	if (analyser->pair == 0)
+	{
+		for (i = 0; i < VIBRATION_FFT_SIZE / 2; i++)
+		{
+			analyser->power[VIBRATION_GYRO][i] = 0.0f;
+			analyser->power[VIBRATION_ACCELERO][i] = 0.0f;
+		}
+	}
+}
+
+
+static void vibration_analyser_add_spectrum(vibration_analyser_t* analyser)
+{
+	uint16_t k, mirror;
+	uint16_t last = analyser->step_start + VIBRATION_STEP_BATCH;
+	float* power_first = analyser->power[(2 * analyser->pair) / 3];
+	float* power_second = analyser->power[(2 * analyser->pair + 1) / 3];
+	float x_re, x_im, y_re, y_im;
+
+	if (last > VIBRATION_FFT_SIZE / 2)
+	{
+		last = VIBRATION_FFT_SIZE / 2;
+	}
+
+	for (k = analyser->step_start; k < last; k++)
+	{
+		mirror = (VIBRATION_FFT_SIZE - k) & VIBRATION_FFT_MASK;
+
+		x_re = analyser->re[k] + analyser->re[mirror];
+		x_im = analyser->im[k] - analyser->im[mirror];
+		y_re = analyser->re[k] - analyser->re[mirror];
+		y_im = analyser->im[k] + analyser->im[mirror];
+
+		power_first[k] += 0.25f * (x_re * x_re + x_im * x_im);
+		power_second[k] += 0.25f * (y_re * y_re + y_im * y_im);
+	}
+}
+
+
+static void vibration_analyser_find_peaks(vibration_analyser_t* analyser)
+{
+	uint8_t sensor, i, j;
+	uint16_t k, first_bin;
+	float sample_rate = analyser->imu->filter_config.sample_rate / analyser->decimation;
+	float before, centre, after, offset, amplitude;
+
+	first_bin = (uint16_t)(analyser->min_frequency * VIBRATION_FFT_SIZE / sample_rate) + 1;
+	if (first_bin < 1)
+	{
+		first_bin = 1;
+	}
+
+	for (sensor = 0; sensor < VIBRATION_SENSOR_COUNT; sensor++)
+	{
+		const float* power = analyser->power[sensor];
+		vibration_peaks_t* peaks = &analyser->peaks[sensor];
+
+		for (i = 0; i < VIBRATION_PEAK_COUNT; i++)
+		{
+			peaks->frequency[i] = 0.0f;
+			peaks->amplitude[i] = 0.0f;
+		}
+
+		for (k = first_bin; k < VIBRATION_FFT_SIZE / 2 - 1; k++)
+		{
+			if ( (power[k] <= power[k - 1]) || (power[k] < power[k + 1]) )
+			{
+				continue;
+			}
+
+			// parabola through the magnitudes of the 3 bins around the maximum
+			before = sqrtf(power[k - 1]);
+			centre = sqrtf(power[k]);
+			after = sqrtf(power[k + 1]);
+			offset = 0.5f * (before - after) / (before - 2.0f * centre + after);
+
+			// with the Hann window, a sine of amplitude A puts at least 98% of 3 A^2 N^2 / 32 in these bins
+			amplitude = sqrtf(32.0f / 3.0f * (power[k - 1] + power[k] + power[k + 1])) / VIBRATION_FFT_SIZE;
+
+			for (i = 0; i < VIBRATION_PEAK_COUNT; i++)
+			{
+				if (amplitude > peaks->amplitude[i])
+				{
+					for (j = VIBRATION_PEAK_COUNT - 1; j > i; j--)
+					{
+						peaks->frequency[j] = peaks->frequency[j - 1];
+						peaks->amplitude[j] = peaks->amplitude[j - 1];
+					}
+					peaks->frequency[i] = (k + offset) * sample_rate / VIBRATION_FFT_SIZE;
+					peaks->amplitude[i] = amplitude;
+					break;
+				}
+			}
+		}
+	}
+
+	analyser->analysis_count++;
+}
+
+
+static void vibration_analyser_track_notches(vibration_analyser_t* analyser)
+{
+	uint8_t i, j, count = 0;
+	float frequency[IMU_NOTCH_COUNT];
+	float tmp;
+	const vibration_peaks_t* peaks = &analyser->peaks[VIBRATION_GYRO];
+	imu_filter_conf_t* filter_config = &analyser->imu->filter_config;
+
+	// the strongest peaks, by increasing frequency so that each notch keeps its peak
+	for (i = 0; (i < VIBRATION_PEAK_COUNT) && (count < IMU_NOTCH_COUNT); i++)
+	{
+		if ( (peaks->frequency[i] > 0.0f) && (peaks->amplitude[i] >= analyser->min_amplitude) )
+		{
+			frequency[count++] = peaks->frequency[i];
+		}
+	}
+
+	for (i = 1; i < count; i++)
+	{
+		for (j = i; (j > 0) && (frequency[j] < frequency[j - 1]); j--)
+		{
+			tmp = frequency[j];
+			frequency[j] = frequency[j - 1];
+			frequency[j - 1] = tmp;
+		}
+	}
+
+	// a notch without peak stays where it is
+	for (i = 0; i < count; i++)
+	{
+		if (maths_f_abs(frequency[i] - filter_config->notch_frequency[i]) > VIBRATION_NOTCH_HYSTERESIS)
+		{
+			filter_config->notch_frequency[i] = frequency[i];
+		}
+	}
+
+	imu_update_filter(analyser->imu);
+}
+
+
+static void vibration_analyser_run_step(vibration_analyser_t* analyser, vibration_step_t step)
+{
+	uint32_t start = time_keeper_get_micros();
+	uint32_t duration;
+
+	switch (step)
+	{
+		case VIBRATION_STEP_COPY:
+			vibration_analyser_copy_pair(analyser);
+			break;
+
+		case VIBRATION_STEP_BUTTERFLIES:
+			fft_butterflies(&analyser->fft, analyser->re, analyser->im, analyser->stage, analyser->step_start, VIBRATION_STEP_BATCH);
+			break;
+
+		case VIBRATION_STEP_SPECTRUM:
+			vibration_analyser_add_spectrum(analyser);
+			break;
+
+		case VIBRATION_STEP_PEAKS:
+			vibration_analyser_find_peaks(analyser);
+			break;
+
+		case VIBRATION_STEP_NOTCHES:
+			vibration_analyser_track_notches(analyser);
+			break;
+
+		default:
+			break;
+	}
+
+	duration = time_keeper_get_micros() - start;
+	if (duration > analyser->step_time_max[step])
+	{
+		analyser->step_time_max[step] = duration;
+	}
+}
+
+//------------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+void vibration_analyser_init(vibration_analyser_t* analyser, const vibration_analyser_conf_t* config, imu_t* imu)
+{
+	uint16_t i, j;
+
+	analyser->imu = imu;
+
+	analyser->decimation = (config->decimation > 0) ? config->decimation : 1;
+	analyser->decimation_count = 0;
+	analyser->head = 0;
+	analyser->sample_count = 0;
+	for (i = 0; i < VIBRATION_CHANNEL_COUNT; i++)
+	{
+		analyser->sum[i] = 0.0f;
+	}
+
+	fft_init(&analyser->fft, VIBRATION_FFT_SIZE);
+	for (i = 0; i < VIBRATION_FFT_SIZE; i++)
+	{
+		analyser->window[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / VIBRATION_FFT_SIZE);
+	}
+
+	for (i = 0; i < VIBRATION_SENSOR_COUNT; i++)
+	{
+		for (j = 0; j < VIBRATION_PEAK_COUNT; j++)
+		{
+			analyser->peaks[i].frequency[j] = 0.0f;
+			analyser->peaks[i].amplitude[j] = 0.0f;
+		}
+	}
+	analyser->analysis_count = 0;
+
+	analyser->min_frequency = config->min_frequency;
+	analyser->min_amplitude = config->min_amplitude;
+	analyser->notch_tracking = config->notch_tracking;
+
+	coroutine_init(&analyser->coroutine, config->time_budget);
+	analyser->pair = 0;
+	analyser->stage = 0;
+	analyser->step_start = 0;
+	for (i = 0; i < VIBRATION_STEP_COUNT; i++)
+	{
+		analyser->step_time_max[i] = 0;
+	}
+
+	print_util_dbg_print("[VIBRATION] Initialised\r\n");
+}
+
+
+void vibration_analyser_add_sample(vibration_analyser_t* analyser)
+{
+	imu_t* imu = analyser->imu;
+	uint16_t i;
+
+	for (i = 0; i < 3; i++)
+	{
+		analyser->sum[i]     += (imu->oriented_gyro.data[i]     - imu->calib_gyro.bias[i])     * imu->calib_gyro.scale_factor[i];
+		analyser->sum[3 + i] += (imu->oriented_accelero.data[i] - imu->calib_accelero.bias[i]) * imu->calib_accelero.scale_factor[i];
+	}
+
+	if (++analyser->decimation_count >= analyser->decimation)
+	{
+		for (i = 0; i < VIBRATION_CHANNEL_COUNT; i++)
+		{
+			analyser->samples[i][analyser->head] = analyser->sum[i] / analyser->decimation_count;
+			analyser->sum[i] = 0.0f;
+		}
+		analyser->decimation_count = 0;
+
+		analyser->head = (analyser->head + 1) & VIBRATION_FFT_MASK;
+		if (analyser->sample_count < VIBRATION_FFT_SIZE)
+		{
+			analyser->sample_count++;
+		}
+	}
+}
+
+
+task_return_t vibration_analyser_update(vibration_analyser_t* analyser)
+{
+	coroutine_t* cr = &analyser->coroutine;
+
+	// wait for a full buffer before the first analysis
+	if ( !coroutine_is_running(cr) && (analyser->sample_count < VIBRATION_FFT_SIZE) )
+	{
+		return TASK_RUN_SUCCESS;
+	}
+
+	COROUTINE_BEGIN(cr);
+
+	for (analyser->pair = 0; analyser->pair < VIBRATION_CHANNEL_COUNT / 2; analyser->pair++)
+	{
+		COROUTINE_YIELD_UNLESS_TIME_LEFT(cr, analyser->step_time_max[VIBRATION_STEP_COPY]);
+		vibration_analyser_run_step(analyser, VIBRATION_STEP_COPY);
+
+		for (analyser->stage = 0; analyser->stage < analyser->fft.stage_count; analyser->stage++)
+		{
+			for (analyser->step_start = 0; analyser->step_start < VIBRATION_FFT_SIZE / 2; analyser->step_start += VIBRATION_STEP_BATCH)
+			{
+				COROUTINE_YIELD_UNLESS_TIME_LEFT(cr, analyser->step_time_max[VIBRATION_STEP_BUTTERFLIES]);
+				vibration_analyser_run_step(analyser, VIBRATION_STEP_BUTTERFLIES);
+			}
+		}
+
+		for (analyser->step_start = 0; analyser->step_start < VIBRATION_FFT_SIZE / 2; analyser->step_start += VIBRATION_STEP_BATCH)
+		{
+			COROUTINE_YIELD_UNLESS_TIME_LEFT(cr, analyser->step_time_max[VIBRATION_STEP_SPECTRUM]);
+			vibration_analyser_run_step(analyser, VIBRATION_STEP_SPECTRUM);
+		}
+	}
+
+	COROUTINE_YIELD_UNLESS_TIME_LEFT(cr, analyser->step_time_max[VIBRATION_STEP_PEAKS]);
+	vibration_analyser_run_step(analyser, VIBRATION_STEP_PEAKS);
+
+	if (analyser->notch_tracking)
+	{
+		COROUTINE_YIELD_UNLESS_TIME_LEFT(cr, analyser->step_time_max[VIBRATION_STEP_NOTCHES]);
+		vibration_analyser_run_step(analyser, VIBRATION_STEP_NOTCHES);
+	}
+
+	COROUTINE_END(cr);
+
+	return TASK_RUN_SUCCESS;
+}
\ No newline at end of file
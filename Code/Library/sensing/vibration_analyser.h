@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file vibration_analyser.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Spectrum analysis of the gyroscope and accelerometer vibrations
+ *
+ * \details The scaled gyroscope and accelerometer values, before the filters of
+ * the IMU, are decimated into a ring buffer. A low priority task computes the
+ * spectrum of the last VIBRATION_FFT_SIZE samples of each axis, finds the
+ * strongest peaks of each sensor and can move the notch filters of the IMU
+ * onto the gyroscope peaks.
+ *
+ * The analysis is a resumable task: it yields before any step which would not
+ * end within the time budget of the invocation.
+ *
+ ******************************************************************************/
+
+
+#ifndef VIBRATION_ANALYSER_H_
+#define VIBRATION_ANALYSER_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "imu.h"
+#include "fft.h"
+#include "coroutine.h"
+
+#define VIBRATION_FFT_SIZE 128					///< Number of samples of each spectrum, power of 2
+#define VIBRATION_CHANNEL_COUNT 6				///< Gyroscope X, Y, Z then accelerometer X, Y, Z
+#define VIBRATION_PEAK_COUNT 3					///< Number of peaks found for each sensor
+#define VIBRATION_STEP_BATCH 16					///< Number of butterflies or spectrum bins computed in one step
+
+
+/**
+ * \brief	The analysed sensors
+ */
+typedef enum
+{
+	VIBRATION_GYRO = 0,							///< The gyroscope, channels 0 to 2
+	VIBRATION_ACCELERO = 1,						///< The accelerometer, channels 3 to 5
+	VIBRATION_SENSOR_COUNT = 2					///< Number of sensors
+} vibration_sensor_t;
+
+
+/**
+ * \brief	The kinds of steps of the analysis, each with its own execution time
+ */
+typedef enum
+{
+	VIBRATION_STEP_COPY = 0,					///< Copy two channels with the window into the FFT input
+	VIBRATION_STEP_BUTTERFLIES,					///< A batch of FFT butterflies
+	VIBRATION_STEP_SPECTRUM,					///< Add a batch of bins to the power spectra
+	VIBRATION_STEP_PEAKS,						///< Find the peaks of the spectra
+	VIBRATION_STEP_NOTCHES,						///< Move the notch filters of the IMU
+	VIBRATION_STEP_COUNT						///< Number of kinds of steps
+} vibration_step_t;
+
+
+/**
+ * \brief	The strongest peaks of the spectrum of a sensor
+ */
+typedef struct
+{
+	float frequency[VIBRATION_PEAK_COUNT];		///< The frequencies of the peaks by decreasing amplitude, 0 if there is no peak (Hz)
+	float amplitude[VIBRATION_PEAK_COUNT];		///< The amplitudes of the peaks, in the scaled units of the sensor
+} vibration_peaks_t;
+
+
+/**
+ * \brief	The configuration of the vibration analyser
+ */
+typedef struct
+{
+	uint32_t decimation;						///< Number of IMU updates averaged into one sample
+	float min_frequency;						///< The peaks below this frequency are ignored (Hz)
+	float min_amplitude;						///< The gyroscope amplitude from which a peak gets a notch (rad/s)
+	uint32_t time_budget;						///< Maximum execution time of one invocation of the analysis (us)
+	bool notch_tracking;						///< Whether the notch filters of the IMU follow the gyroscope peaks
+} vibration_analyser_conf_t;
+
+
+/**
+ * \brief	The vibration analyser structure
+ */
+typedef struct
+{
+	float samples[VIBRATION_CHANNEL_COUNT][VIBRATION_FFT_SIZE];		///< The ring buffer of decimated samples of each channel
+	float sum[VIBRATION_CHANNEL_COUNT];								///< The sum of the IMU values of the sample being decimated
+	uint32_t decimation;											///< Number of IMU updates averaged into one sample
+	uint32_t decimation_count;										///< Number of IMU values in sum
+	uint16_t head;													///< Position of the next sample, and of the oldest one once the buffer is full
+	uint16_t sample_count;											///< Number of samples in the buffer
+
+	fft_t fft;														///< The tables of the FFT
+	float window[VIBRATION_FFT_SIZE];								///< The Hann window
+	float re[VIBRATION_FFT_SIZE];									///< The FFT of two channels, real parts
+	float im[VIBRATION_FFT_SIZE];									///< The FFT of two channels, imaginary parts
+	float power[VIBRATION_SENSOR_COUNT][VIBRATION_FFT_SIZE / 2];	///< The power spectrum of each sensor, sum of its 3 axes
+	vibration_peaks_t peaks[VIBRATION_SENSOR_COUNT];				///< The peaks found by the last analysis
+	uint32_t analysis_count;										///< Number of analyses completed
+
+	float min_frequency;											///< The peaks below this frequency are ignored (Hz)
+	float min_amplitude;											///< The gyroscope amplitude from which a peak gets a notch (rad/s)
+	int32_t notch_tracking;											///< Whether the notch filters of the IMU follow the gyroscope peaks
+
+	coroutine_t coroutine;											///< The state of the analysis task, its time slice is the time budget
+	uint16_t pair;													///< The pair of channels being transformed
+	uint8_t stage;													///< The FFT stage being computed
+	uint16_t step_start;											///< The first butterfly or bin of the next step
+	uint32_t step_time_max[VIBRATION_STEP_COUNT];					///< The longest execution time of each kind of step (us)
+
+	imu_t* imu;														///< The pointer to the IMU structure
+} vibration_analyser_t;
+
+
+/**
+ * \brief	Initialises the vibration analyser
+ *
+ * \param	analyser				The pointer to the vibration analyser structure
+ * \param	config					The configuration
+ * \param	imu						The pointer to the IMU structure
+ */
+void vibration_analyser_init(vibration_analyser_t* analyser, const vibration_analyser_conf_t* config, imu_t* imu);
+
+
+/**
+ * \brief	Adds the current scaled values of the IMU, without the filters, to the samples
+ *
+ * \details	To be called after each imu_update
+ *
+ * \param	analyser				The pointer to the vibration analyser structure
+ */
+void vibration_analyser_add_sample(vibration_analyser_t* analyser);
+
+
+/**
+ * \brief	Runs the analysis of the last samples, as a resumable task
+ *
+ * \param	analyser				The pointer to the vibration analyser structure
+ *
+ * \return	TASK_RUN_BLOCKED until the analysis is over
+ */
+task_return_t vibration_analyser_update(vibration_analyser_t* analyser);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VIBRATION_ANALYSER_H_ */
\ No newline at end of file
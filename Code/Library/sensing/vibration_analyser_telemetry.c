@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file vibration_analyser_telemetry.c
+ * 
+ * \author MAV'RIC Team
+ *   
+ * \brief This module takes care of sending periodic telemetric messages for
+ * the vibration analyser
+ *
+ ******************************************************************************/
+
+#include "vibration_analyser_telemetry.h"
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS DECLARATION
+//------------------------------------------------------------------------------
+
+/**
+ * \brief	Pack three values of the peaks in a MAVLink DEBUG_VECT message
+ * 
+ * \param	analyser				The pointer to the vibration analyser structure
+ * \param	mavlink_stream			The pointer to the MAVLink stream structure
+ * \param	msg						The pointer to the MAVLink message
+ * \param	name					The name of the vector
+ * \param	values					The values of the peaks
+ */
+static void vibration_analyser_telemetry_pack(const vibration_analyser_t* analyser, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg, const char* name, const float values[VIBRATION_PEAK_COUNT]);
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+static void vibration_analyser_telemetry_pack(const vibration_analyser_t* analyser, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg, const char* name, const float values[VIBRATION_PEAK_COUNT])
+{
+	mavlink_msg_debug_vect_pack(	mavlink_stream->sysid,
+									mavlink_stream->compid,
+									msg,
+									name,
+									analyser->analysis_count,
+									values[0],
+									values[1],
+									values[2]);
+}
+
+//------------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+void vibration_analyser_telemetry_send_peaks(const vibration_analyser_t* analyser, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg)
+{
+	vibration_analyser_telemetry_pack(analyser, mavlink_stream, msg, "vibF_gyro", analyser->peaks[VIBRATION_GYRO].frequency);
+	mavlink_stream_send(mavlink_stream, msg);
+	
+	vibration_analyser_telemetry_pack(analyser, mavlink_stream, msg, "vibA_gyro", analyser->peaks[VIBRATION_GYRO].amplitude);
+	mavlink_stream_send(mavlink_stream, msg);
+	
+	vibration_analyser_telemetry_pack(analyser, mavlink_stream, msg, "vibF_acc", analyser->peaks[VIBRATION_ACCELERO].frequency);
+	mavlink_stream_send(mavlink_stream, msg);
+	
+	// the last message is sent by the caller
+	vibration_analyser_telemetry_pack(analyser, mavlink_stream, msg, "vibA_acc", analyser->peaks[VIBRATION_ACCELERO].amplitude);
+}
\ No newline at end of file
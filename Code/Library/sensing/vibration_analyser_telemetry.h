@@ -0,0 +1,71 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file vibration_analyser_telemetry.h
+ * 
+ * \author MAV'RIC Team
+ *   
+ * \brief This module takes care of sending periodic telemetric messages for
+ * the vibration analyser
+ *
+ ******************************************************************************/
+
+
+#ifndef VIBRATION_ANALYSER_TELEMETRY_H_
+#define VIBRATION_ANALYSER_TELEMETRY_H_
+
+#include "mavlink_stream.h"
+#include "vibration_analyser.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief	Function to send the peaks of the vibration spectra
+ *
+ * \details	Two DEBUG_VECT messages for each sensor: "vibF_gyro" and "vibF_acc" hold
+ *			the frequencies of the 3 strongest peaks (Hz), "vibA_gyro" and "vibA_acc"
+ *			their amplitudes. The time field is the number of analyses.
+ * 
+ * \param	analyser				The pointer to the vibration analyser structure
+ * \param	mavlink_stream			The pointer to the MAVLink stream structure
+ * \param	msg						The pointer to the MAVLink message
+ */
+void vibration_analyser_telemetry_send_peaks(const vibration_analyser_t* analyser, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* VIBRATION_ANALYSER_TELEMETRY_H_ */
\ No newline at end of file
@@ -0,0 +1,210 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file biquad_bank.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Bank of cascaded second order filters (biquads) applied to several channels
+ *
+ ******************************************************************************/
+
+
+#include "biquad_bank.h"
+#include "maths.h"
+#include <math.h>
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS DECLARATION
+//------------------------------------------------------------------------------
+
+/**
+ * \brief					Sets the coefficients of a stage of some channels, normalised by a0
+ *
+ * \param bank 				Pointer to the filter bank
+ * \param stage 			The stage
+ * \param first_channel 	The first channel
+ * \param channel_count 	The number of channels
+ * \param coefficients		The coefficients {b0, b1, b2, a0, a1, a2}
+ */
+static void biquad_bank_set_stage(biquad_bank_t* bank, uint8_t stage, uint8_t first_channel, uint8_t channel_count, const float coefficients[6]);
+
+//------------------------------------------------------------------------------
+// PRIVATE FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+static void biquad_bank_set_stage(biquad_bank_t* bank, uint8_t stage, uint8_t first_channel, uint8_t channel_count, const float coefficients[6])
+{
+	uint8_t i;
+
+	if ( (stage >= BIQUAD_BANK_STAGES) || (first_channel + channel_count > BIQUAD_BANK_CHANNELS) )
+	{
+		return;
+	}
+
+	for (i = first_channel; i < first_channel + channel_count; i++)
+	{
+		bank->b0[stage][i] = coefficients[0] / coefficients[3];
+		bank->b1[stage][i] = coefficients[1] / coefficients[3];
+		bank->b2[stage][i] = coefficients[2] / coefficients[3];
+		bank->a1[stage][i] = coefficients[4] / coefficients[3];
+		bank->a2[stage][i] = coefficients[5] / coefficients[3];
+	}
+
+	if (stage >= bank->stage_count)
+	{
+		bank->stage_count = stage + 1;
+	}
+}
+
+//------------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+void biquad_bank_init(biquad_bank_t* bank)
+{
+	uint8_t i, j;
+
+	for (i = 0; i < BIQUAD_BANK_STAGES; i++)
+	{
+		for (j = 0; j < BIQUAD_BANK_CHANNELS; j++)
+		{
+			bank->b0[i][j] = 1.0f;
+			bank->b1[i][j] = 0.0f;
+			bank->b2[i][j] = 0.0f;
+			bank->a1[i][j] = 0.0f;
+			bank->a2[i][j] = 0.0f;
+			bank->z1[i][j] = 0.0f;
+			bank->z2[i][j] = 0.0f;
+		}
+	}
+
+	bank->stage_count = 0;
+}
+
+
+void biquad_bank_set_lowpass(biquad_bank_t* bank, uint8_t stage, uint8_t first_channel, uint8_t channel_count, float cutoff, float sample_rate)
+{
+	float omega, cos_omega, alpha;
+	float coefficients[6] = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f};
+
+	if ( (cutoff > 0.0f) && (cutoff < 0.5f * sample_rate) )
+	{
+		// Q = 1/sqrt(2) gives the maximally flat pass band
+		omega = 2.0f * PI * cutoff / sample_rate;
+		cos_omega = cosf(omega);
+		alpha = sinf(omega) / (2.0f * 0.70710678f);
+
+		coefficients[0] = (1.0f - cos_omega) / 2.0f;
+		coefficients[1] = 1.0f - cos_omega;
+		coefficients[2] = (1.0f - cos_omega) / 2.0f;
+		coefficients[3] = 1.0f + alpha;
+		coefficients[4] = -2.0f * cos_omega;
+		coefficients[5] = 1.0f - alpha;
+	}
+
+	biquad_bank_set_stage(bank, stage, first_channel, channel_count, coefficients);
+}
+
+
+void biquad_bank_set_notch(biquad_bank_t* bank, uint8_t stage, uint8_t first_channel, uint8_t channel_count, float frequency, float bandwidth, float sample_rate)
+{
+	float omega, cos_omega, alpha;
+	float coefficients[6] = {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f};
+
+	if ( (frequency > 0.0f) && (frequency < 0.5f * sample_rate) && (bandwidth > 0.0f) )
+	{
+		// with alpha = tan(pi bandwidth / sample_rate), the -3dB points are exactly bandwidth apart
+		omega = 2.0f * PI * frequency / sample_rate;
+		cos_omega = cosf(omega);
+		alpha = tanf(PI * bandwidth / sample_rate);
+
+		coefficients[0] = 1.0f;
+		coefficients[1] = -2.0f * cos_omega;
+		coefficients[2] = 1.0f;
+		coefficients[3] = 1.0f + alpha;
+		coefficients[4] = -2.0f * cos_omega;
+		coefficients[5] = 1.0f - alpha;
+	}
+
+	biquad_bank_set_stage(bank, stage, first_channel, channel_count, coefficients);
+}
+
+
+void biquad_bank_prime(biquad_bank_t* bank, const float values[BIQUAD_BANK_CHANNELS])
+{
+	uint8_t i, j;
+	float x, y;
+
+	for (j = 0; j < BIQUAD_BANK_CHANNELS; j++)
+	{
+		x = values[j];
+
+		for (i = 0; i < BIQUAD_BANK_STAGES; i++)
+		{
+			// output of the stage for a constant input
+			y = x * (bank->b0[i][j] + bank->b1[i][j] + bank->b2[i][j]) / (1.0f + bank->a1[i][j] + bank->a2[i][j]);
+
+			bank->z2[i][j] = bank->b2[i][j] * x - bank->a2[i][j] * y;
+			bank->z1[i][j] = y - bank->b0[i][j] * x;
+
+			x = y;
+		}
+	}
+}
+
+
+void biquad_bank_update(biquad_bank_t* bank, float values[BIQUAD_BANK_CHANNELS])
+{
+	uint8_t i, j;
+	float x, y;
+
+	for (i = 0; i < bank->stage_count; i++)
+	{
+		const float* b0 = bank->b0[i];
+		const float* b1 = bank->b1[i];
+		const float* b2 = bank->b2[i];
+		const float* a1 = bank->a1[i];
+		const float* a2 = bank->a2[i];
+		float* z1 = bank->z1[i];
+		float* z2 = bank->z2[i];
+
+		for (j = 0; j < BIQUAD_BANK_CHANNELS; j++)
+		{
+			x = values[j];
+			y = b0[j] * x + z1[j];
+			z1[j] = b1[j] * x - a1[j] * y + z2[j];
+			z2[j] = b2[j] * x - a2[j] * y;
+			values[j] = y;
+		}
+	}
+}
\ No newline at end of file
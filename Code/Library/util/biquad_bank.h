@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file biquad_bank.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Bank of cascaded second order filters (biquads) applied to several channels
+ *
+ * \details The coefficients and the states are stored stage by stage, as one
+ * array per coefficient with one entry per channel, so that each stage updates
+ * all the channels in one loop.
+ *
+ ******************************************************************************/
+
+
+#ifndef BIQUAD_BANK_H_
+#define BIQUAD_BANK_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+
+#define BIQUAD_BANK_CHANNELS 9					///< Number of filtered channels
+#define BIQUAD_BANK_STAGES 3					///< Maximum number of cascaded stages
+
+
+/**
+ * \brief 		Filter bank structure
+ *
+ * \details 	Each stage is in transposed direct form II:
+ *				y = b0 x + z1, z1 = b1 x - a1 y + z2, z2 = b2 x - a2 y
+ */
+typedef struct
+{
+	float b0[BIQUAD_BANK_STAGES][BIQUAD_BANK_CHANNELS];		///<	Feed forward coefficients
+	float b1[BIQUAD_BANK_STAGES][BIQUAD_BANK_CHANNELS];		///<	Feed forward coefficients
+	float b2[BIQUAD_BANK_STAGES][BIQUAD_BANK_CHANNELS];		///<	Feed forward coefficients
+	float a1[BIQUAD_BANK_STAGES][BIQUAD_BANK_CHANNELS];		///<	Feedback coefficients, normalised by a0
+	float a2[BIQUAD_BANK_STAGES][BIQUAD_BANK_CHANNELS];		///<	Feedback coefficients, normalised by a0
+	float z1[BIQUAD_BANK_STAGES][BIQUAD_BANK_CHANNELS];		///<	First state of each stage
+	float z2[BIQUAD_BANK_STAGES][BIQUAD_BANK_CHANNELS];		///<	Second state of each stage
+	uint8_t stage_count;									///<	Number of stages run by biquad_bank_update
+} biquad_bank_t;
+
+
+/**
+ * \brief        	Initialises the bank with all the stages passing the signal through, and no stage run
+ *
+ * \param bank 		Pointer to the filter bank
+ */
+void biquad_bank_init(biquad_bank_t* bank);
+
+
+/**
+ * \brief        	Sets a stage of some channels to a second order Butterworth low-pass filter
+ *
+ * \details 		A cutoff frequency of 0, or above the Nyquist frequency, lets the signal through
+ *
+ * \param bank 				Pointer to the filter bank
+ * \param stage 			The stage
+ * \param first_channel 	The first channel
+ * \param channel_count 	The number of channels
+ * \param cutoff 			The cutoff frequency (Hz)
+ * \param sample_rate 		The rate of biquad_bank_update (Hz)
+ */
+void biquad_bank_set_lowpass(biquad_bank_t* bank, uint8_t stage, uint8_t first_channel, uint8_t channel_count, float cutoff, float sample_rate);
+
+
+/**
+ * \brief        	Sets a stage of some channels to a notch filter
+ *
+ * \details 		A centre frequency of 0, or above the Nyquist frequency, lets the signal through
+ *
+ * \param bank 				Pointer to the filter bank
+ * \param stage 			The stage
+ * \param first_channel 	The first channel
+ * \param channel_count 	The number of channels
+ * \param frequency 		The centre frequency (Hz)
+ * \param bandwidth 		The -3dB bandwidth (Hz)
+ * \param sample_rate 		The rate of biquad_bank_update (Hz)
+ */
+void biquad_bank_set_notch(biquad_bank_t* bank, uint8_t stage, uint8_t first_channel, uint8_t channel_count, float frequency, float bandwidth, float sample_rate);
+
+
+/**
+ * \brief        	Sets the states so that the outputs are steady at the given values
+ *
+ * \details 		To avoid a transient after the coefficients are changed
+ *
+ * \param bank 		Pointer to the filter bank
+ * \param values 	The input of each channel
+ */
+void biquad_bank_prime(biquad_bank_t* bank, const float values[BIQUAD_BANK_CHANNELS]);
+
+
+/**
+ * \brief        	Filters one sample of every channel
+ *
+ * \param bank 		Pointer to the filter bank
+ * \param values 	The input of each channel, replaced by the output
+ */
+void biquad_bank_update(biquad_bank_t* bank, float values[BIQUAD_BANK_CHANNELS]);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BIQUAD_BANK_H_ */
\ No newline at end of file
@@ -0,0 +1,150 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file fft.c
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Radix-2 fast Fourier transform on floats, which can be run in parts
+ *
+ ******************************************************************************/
+
+
+#include "fft.h"
+#include "maths.h"
+#include <math.h>
+
+//------------------------------------------------------------------------------
+// PUBLIC FUNCTIONS IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+bool fft_init(fft_t* fft, uint16_t size)
+{
+	uint16_t i, j;
+	uint8_t stage_count = 0;
+
+	while ( ((uint16_t)1 << stage_count) < size )
+	{
+		stage_count++;
+	}
+
+	if ( (size < 2) || (size > FFT_MAX_SIZE) || (((uint16_t)1 << stage_count) != size) )
+	{
+		fft->size = 0;
+		fft->stage_count = 0;
+		return false;
+	}
+
+	fft->size = size;
+	fft->stage_count = stage_count;
+
+	for (i = 0; i < size / 2; i++)
+	{
+		fft->cos_table[i] = cosf(2.0f * PI * i / size);
+		fft->sin_table[i] = sinf(2.0f * PI * i / size);
+	}
+
+	for (i = 0; i < size; i++)
+	{
+		fft->reversed[i] = 0;
+		for (j = 0; j < stage_count; j++)
+		{
+			if (i & (1 << j))
+			{
+				fft->reversed[i] |= 1 << (stage_count - 1 - j);
+			}
+		}
+	}
+
+	return true;
+}
+
+
+void fft_butterflies(const fft_t* fft, float re[], float im[], uint8_t stage, uint16_t first, uint16_t count)
+{
+	uint16_t b, top, bottom, k;
+	uint16_t half = 1 << stage;
+	uint8_t twiddle_shift = fft->stage_count - 1 - stage;
+	float w_re, w_im, t_re, t_im;
+
+	if (first + count > fft->size / 2)
+	{
+		count = fft->size / 2 - first;
+	}
+
+	for (b = first; b < first + count; b++)
+	{
+		// butterfly k of group b / half, between the points top and top + half
+		k = b & (half - 1);
+		top = ((b >> stage) << (stage + 1)) + k;
+		bottom = top + half;
+
+		// w = exp(-2 i pi k / (2 half))
+		w_re = fft->cos_table[k << twiddle_shift];
+		w_im = -fft->sin_table[k << twiddle_shift];
+
+		t_re = w_re * re[bottom] - w_im * im[bottom];
+		t_im = w_re * im[bottom] + w_im * re[bottom];
+
+		re[bottom] = re[top] - t_re;
+		im[bottom] = im[top] - t_im;
+		re[top] += t_re;
+		im[top] += t_im;
+	}
+}
+
+
+void fft_transform(const fft_t* fft, float re[], float im[])
+{
+	uint16_t i, j;
+	uint8_t stage;
+	float tmp;
+
+	for (i = 0; i < fft->size; i++)
+	{
+		j = fft->reversed[i];
+		if (j > i)
+		{
+			tmp = re[i];
+			re[i] = re[j];
+			re[j] = tmp;
+			tmp = im[i];
+			im[i] = im[j];
+			im[j] = tmp;
+		}
+	}
+
+	for (stage = 0; stage < fft->stage_count; stage++)
+	{
+		fft_butterflies(fft, re, im, stage, 0, fft->size / 2);
+	}
+}
\ No newline at end of file
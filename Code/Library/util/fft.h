@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file fft.h
+ *
+ * \author MAV'RIC Team
+ *
+ * \brief Radix-2 fast Fourier transform on floats, which can be run in parts
+ *
+ * \details The transform is in place, on separate arrays of real and imaginary
+ * parts. The input is stored in bit reversed order (fft_bit_reversed_index()),
+ * then each of the log2(size) stages runs size/2 butterflies. The butterflies
+ * of a stage are independent, they can be run in batches over several calls.
+ *
+ ******************************************************************************/
+
+
+#ifndef FFT_H_
+#define FFT_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FFT_MAX_SIZE 128						///< Maximum number of points, power of 2
+
+
+/**
+ * \brief 		Tables of a transform size
+ */
+typedef struct
+{
+	uint16_t size;								///<	Number of points
+	uint8_t stage_count;						///<	log2(size)
+	float cos_table[FFT_MAX_SIZE / 2];			///<	cos(2 pi k / size)
+	float sin_table[FFT_MAX_SIZE / 2];			///<	sin(2 pi k / size)
+	uint16_t reversed[FFT_MAX_SIZE];			///<	Bit reversed index of each point
+} fft_t;
+
+
+/**
+ * \brief        	Computes the tables of a transform size
+ *
+ * \param fft 		Pointer to the fft structure
+ * \param size 		Number of points, power of 2 up to FFT_MAX_SIZE
+ *
+ * \return 			False if the size is not supported
+ */
+bool fft_init(fft_t* fft, uint16_t size);
+
+
+/**
+ * \brief        	Returns the position at which an input point is stored before the stages
+ *
+ * \param fft 		Pointer to the fft structure
+ * \param index 	The index of the point in the input sequence
+ *
+ * \return 			The bit reversed index
+ */
+static inline uint16_t fft_bit_reversed_index(const fft_t* fft, uint16_t index)
+{
+	return fft->reversed[index];
+}
+
+
+/**
+ * \brief        	Runs a batch of butterflies of a stage of the forward transform
+ *
+ * \param fft 		Pointer to the fft structure
+ * \param re 		Real parts, in place
+ * \param im 		Imaginary parts, in place
+ * \param stage 	The stage, from 0 to stage_count - 1
+ * \param first 	The first butterfly, from 0 to size/2 - 1
+ * \param count 	The number of butterflies
+ */
+void fft_butterflies(const fft_t* fft, float re[], float im[], uint8_t stage, uint16_t first, uint16_t count);
+
+
+/**
+ * \brief        	Runs the whole forward transform, the input being in natural order
+ *
+ * \param fft 		Pointer to the fft structure
+ * \param re 		Real parts, in place
+ * \param im 		Imaginary parts, in place
+ */
+void fft_transform(const fft_t* fft, float re[], float im[]);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FFT_H_ */
\ No newline at end of file
@@ -283,6 +283,58 @@ static inline quat_t quaternions_normalise(const quat_t q)
 }
 
 
+/**
+ * \brief 			Creates the unit quaternion of a rotation vector (exponential map)
+ * 
+ * \details 		The rotation vector is the rotation axis scaled by the rotation angle
+ * 
+ * \param 	rotation	Rotation vector (rad)
+ * 
+ * \return 			Unit quaternion
+ */
+static inline quat_t quaternions_from_rotation_vector(const float rotation[3])
+{
+	quat_t q;
+	float scale;
+	float s_angle = SQR(rotation[0]) + SQR(rotation[1]) + SQR(rotation[2]);
+	
+	if (s_angle < 1e-6f)
+	{
+		// 2nd order expansion of cos(angle / 2) and sin(angle / 2) / angle
+		q.s = 1.0f - s_angle / 8.0f;
+		scale = 0.5f - s_angle / 48.0f;
+	}
+	else
+	{
+		float angle = sqrtf(s_angle);
+		q.s = cosf(0.5f * angle);
+		scale = sinf(0.5f * angle) / angle;
+	}
+	
+	q.v[0] = scale * rotation[0];
+	q.v[1] = scale * rotation[1];
+	q.v[2] = scale * rotation[2];
+	
+	return q;
+}
+
+
+/**
+ * \brief 			Rotates an attitude quaternion by a rotation vector expressed in the local frame
+ * 
+ * \details 		This is the exact integration of constant angular rates: rotation = rates * dt
+ * 
+ * \param 	qe 			Attitude quaternion
+ * \param 	rotation	Rotation vector in local frame (rad)
+ * 
+ * \return 			Normalised attitude quaternion
+ */
+static inline quat_t quaternions_integrate(const quat_t qe, const float rotation[3])
+{
+	return quaternions_normalise(quaternions_multiply(qe, quaternions_from_rotation_vector(rotation)));
+}
+
+
 #ifdef __cplusplus
 }
 #endif
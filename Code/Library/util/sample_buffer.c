@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file sample_buffer.c
+ * 
+ * \author MAV'RIC Team
+ *   
+ * \brief Ring buffer of timestamped 3 axis sensor samples
+ *
+ ******************************************************************************/
+
+
+#include "sample_buffer.h"
+
+
+void sample_buffer_init(sample_buffer_t* buffer)
+{
+	buffer->head = 0;
+	buffer->tail = 0;
+	buffer->lost_count = 0;
+}
+
+
+void sample_buffer_put_lossy(sample_buffer_t* buffer, const float data[3], uint32_t time)
+{
+	uint8_t tmp = (buffer->head + 1) & SAMPLE_BUFFER_MASK;
+	
+	if (tmp == buffer->tail)
+	{
+		// buffer overflow: lose the oldest sample
+		buffer->tail = (buffer->tail + 1) & SAMPLE_BUFFER_MASK;
+		buffer->lost_count++;
+	}
+	
+	buffer->data[buffer->head][0] = data[0];
+	buffer->data[buffer->head][1] = data[1];
+	buffer->data[buffer->head][2] = data[2];
+	buffer->time[buffer->head] = time;
+	buffer->head = tmp;
+}
+
+
+bool sample_buffer_get(sample_buffer_t* buffer, float data[3], uint32_t* time)
+{
+	if (buffer->head == buffer->tail)
+	{
+		return false;
+	}
+	
+	data[0] = buffer->data[buffer->tail][0];
+	data[1] = buffer->data[buffer->tail][1];
+	data[2] = buffer->data[buffer->tail][2];
+	*time = buffer->time[buffer->tail];
+	buffer->tail = (buffer->tail + 1) & SAMPLE_BUFFER_MASK;
+	
+	return true;
+}
+
+
+uint32_t sample_buffer_count(const sample_buffer_t* buffer)
+{
+	return (buffer->head - buffer->tail) & SAMPLE_BUFFER_MASK;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * Copyright (c) 2009-2014, MAV'RIC Development Team
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, 
+ * this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, 
+ * this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ * may be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR 
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF 
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS 
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN 
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) 
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE 
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * \file sample_buffer.h
+ * 
+ * \author MAV'RIC Team
+ *   
+ * \brief Ring buffer of timestamped 3 axis sensor samples
+ *
+ ******************************************************************************/
+
+
+#ifndef SAMPLE_BUFFER_H_
+#define SAMPLE_BUFFER_H_
+
+#ifdef __cplusplus
+extern "C" 
+{
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SAMPLE_BUFFER_SIZE 64							///< Number of slots, must be a power of 2 (one slot stays free)
+#define SAMPLE_BUFFER_MASK (SAMPLE_BUFFER_SIZE - 1)		///< Mask to wrap the indexes
+
+
+/**
+ * \brief 		Sample buffer structure
+ */
+typedef struct 
+{
+	float data[SAMPLE_BUFFER_SIZE][3];		///<	The samples, in sensor units
+	uint32_t time[SAMPLE_BUFFER_SIZE];		///<	The time of each sample (us)
+	uint8_t head;							///<	Head of the buffer (next free slot)
+	uint8_t tail;							///<	Tail of the buffer (oldest sample)
+	uint32_t lost_count;					///<	Number of samples overwritten before being read
+} sample_buffer_t;
+
+
+/**
+ * \brief        	Sample buffer initialisation
+ * 
+ * \param buffer 	Pointer to buffer
+ */
+void sample_buffer_init(sample_buffer_t* buffer);
+
+
+/**
+ * \brief        	Stores a sample in the buffer, the oldest sample is lost if the buffer is full
+ * 
+ * \param buffer 	Pointer to buffer
+ * \param data   	The sample
+ * \param time   	The time of the sample (us)
+ */
+void sample_buffer_put_lossy(sample_buffer_t* buffer, const float data[3], uint32_t time);
+
+
+/**
+ * \brief        	Gets the oldest sample in the buffer
+ * 
+ * \param buffer 	Pointer to buffer
+ * \param data   	The sample, output
+ * \param time   	The time of the sample (us), output
+ * 
+ * \return       	False if the buffer is empty
+ */
+bool sample_buffer_get(sample_buffer_t* buffer, float data[3], uint32_t* time);
+
+
+/**
+ * \brief        	Returns the number of samples in the buffer
+ * 
+ * \param buffer 	Pointer to buffer
+ * 
+ * \return       	Number of samples
+ */
+uint32_t sample_buffer_count(const sample_buffer_t* buffer);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_BUFFER_H_ */
\ No newline at end of file
@@ -84,6 +84,7 @@ void boardsupport_init(central_data_t *central_data)
 	time_keeper_init();
 		
 	INTC_init_interrupts();
+	time_keeper_init_interrupt();
 
 	// Switch on the red LED
 	LED_On(LED2);
@@ -72,7 +72,14 @@ void central_data_init()
 	scheduler_conf_t scheduler_config =
 	{
 		.max_task_count = 15,
-		.schedule_strategy = ROUND_ROBIN,
+		.schedule_strategy = EARLIEST_DEADLINE_FIRST,
+		.backend = SCHEDULER_BACKEND_HEAP,
+		.time_budget = 2000,
+		.utilisation_max = 1.0f,
+		.wcet_default = 1000,			// Budget of the tasks until they are measured
+		.max_task_id = 14,				// IDs of tasks_create_tasks(), found by direct index
+		.idle_function = &time_keeper_sleep_until64,	// Sleep until the next task, the nested MAVLink scheduler polls
+		.histograms = true,				// Reported by the deadline & execution statistics streams
 		.debug = true
 	};
 	scheduler_init(	&central_data.scheduler, 
@@ -87,6 +94,11 @@ void central_data_init()
 		{
 			.max_task_count = 30,
 			.schedule_strategy = ROUND_ROBIN,
+			.backend = SCHEDULER_BACKEND_HEAP,
+			.time_budget = 0,				// One message per empty transmit buffer
+			.cpu_budget = 800,				// Share of the CPU the telemetry may take from the control tasks,
+			.cpu_budget_period = 4000,		// per period of mavlink_communication_update
+			.wcet_default = 300,
 			.debug = true
 		},
 		.mavlink_stream_config = 
@@ -108,7 +120,7 @@ void central_data_init()
 			.max_param_count = MAX_ONBOARD_PARAM_COUNT,
 			.debug           = true
 		},
-		.max_msg_sending_count = 22
+		.max_msg_sending_count = 26			// One per mavlink_communication_add_msg_send() of mavlink_telemetry_init()
 	};
 	mavlink_communication_init(&central_data.mavlink_communication, &mavlink_config);
 	
@@ -131,7 +143,8 @@ void central_data_init()
 	};
 	state_init(	&central_data.state,
 				&state_config,
-				&central_data.analog_monitor); 
+				&central_data.analog_monitor,
+				&central_data.scheduler); 
 	
 	delay_ms(100);
 	
@@ -160,10 +173,38 @@ void central_data_init()
 	delay_ms(100);
 
 	
-	// Init qfilter
-	qfilter_init(   &(central_data.attitude_filter), 
-					&central_data.imu, 
-					&central_data.ahrs);
+	// Init attitude estimation filter
+	central_data.attitude_estimator = AHRS_QFILTER;
+	switch (central_data.attitude_estimator)
+	{
+		case AHRS_MEKF:
+			mekf_init(	&(central_data.attitude_mekf), 
+						&central_data.imu, 
+						&central_data.ahrs);
+			break;
+		
+		case AHRS_QFILTER:
+		default:
+			qfilter_init(   &(central_data.attitude_filter), 
+							&central_data.imu, 
+							&central_data.ahrs);
+			break;
+	}
+	
+	delay_ms(100);
+	
+	// Init vibration analyser
+	vibration_analyser_conf_t vibration_config = 
+	{
+		.decimation = 1,
+		.min_frequency = 20.0f,
+		.min_amplitude = 0.02f,
+		.time_budget = 300,
+		.notch_tracking = false
+	};
+	vibration_analyser_init(	&central_data.vibration_analyser,
+								&vibration_config,
+								&central_data.imu);
 	
 	delay_ms(100);
 	
@@ -53,6 +53,8 @@ extern "C" {
 
 #include "time_keeper.h"
 #include "qfilter.h"
+#include "mekf.h"
+#include "vibration_analyser.h"
 #include "imu.h"
 #include "ahrs.h"
 #include "stabilisation_copter.h"
@@ -111,7 +113,10 @@ typedef struct  {
 	analog_monitor_t analog_monitor;							///< The analog to digital converter structure
 
 	imu_t imu;													///< The IMU structure
+	ahrs_estimator_t attitude_estimator;						///< The filter used for the attitude estimation
 	qfilter_t attitude_filter;									///< The qfilter structure
+	mekf_t attitude_mekf;										///< The MEKF structure
+	vibration_analyser_t vibration_analyser;					///< The vibration analyser structure
 	ahrs_t ahrs;												///< The attitude estimation structure
 	control_command_t controls;									///< The control structure used for rate and attitude modes
 	control_command_t controls_nav;								///< The control nav structure used for velocity modes
@@ -59,7 +59,9 @@
 #include "stabilisation_telemetry.h"
 #include "joystick_parsing_telemetry.h"
 #include "simulation_telemetry.h"
+#include "vibration_analyser_telemetry.h"
 #include "scheduler_telemetry.h"
+#include "scheduler_analysis.h"
 #include "data_logging_telemetry.h"
 
 central_data_t *central_data;
@@ -210,6 +212,21 @@ void mavlink_telemetry_add_onboard_parameters(onboard_parameters_t * onboard_par
 	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.calib_compass.scale_factor[X]                        , "Scale_Mag_X"      );
 	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.calib_compass.scale_factor[Y]                        , "Scale_Mag_Y"      );
 	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.calib_compass.scale_factor[Z]                        , "Scale_Mag_Z"      );
+	
+	// IMU filters, recomputed by the imu filter task
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.filter_config.gyro_cutoff                            , "Filt_Gyro_LPF"    );
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.filter_config.acc_cutoff                             , "Filt_Acc_LPF"     );
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.filter_config.mag_cutoff                             , "Filt_Mag_LPF"     );
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.filter_config.notch_frequency[0]                     , "Filt_Notch1_F"    );
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.filter_config.notch_bandwidth[0]                     , "Filt_Notch1_BW"   );
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.filter_config.notch_frequency[1]                     , "Filt_Notch2_F"    );
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->imu.filter_config.notch_bandwidth[1]                     , "Filt_Notch2_BW"   );
+	
+	// Vibration analyser
+	onboard_parameters_add_parameter_int32  ( onboard_parameters , &central_data->vibration_analyser.notch_tracking                        , "Vib_notch_trk"    );
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->vibration_analyser.min_frequency                         , "Vib_min_freq"     );
+	onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->vibration_analyser.min_amplitude                         , "Vib_min_amp"      );
+	onboard_parameters_add_parameter_uint32 ( onboard_parameters , &central_data->vibration_analyser.coroutine.time_slice                  , "Vib_budget"       );
 
 	//onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->position_estimator.kp_alt_baro                              , "Pos_kp_alt_baro"       );
 	//onboard_parameters_add_parameter_float  ( onboard_parameters , &central_data->position_estimator.kp_vel_baro                              , "Pos_kp_velb"      );
@@ -222,6 +239,19 @@ void mavlink_telemetry_add_onboard_parameters(onboard_parameters_t * onboard_par
 	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->navigation.dist2vel_gain                            , "vel_dist2Vel"     );
 	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->navigation.cruise_speed                            , "vel_cruiseSpeed"  );
 	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->navigation.max_climb_rate                          , "vel_climbRate"    );
+	
+	// Track following predictor
+	onboard_parameters_add_parameter_int32    ( onboard_parameters , (int32_t*)&central_data->track_following.predictor                , "TF_predictor"     );
+	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->track_following.imm.cv_noise                       , "IMM_cv_noise"     );
+	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->track_following.imm.ca_noise                       , "IMM_ca_noise"     );
+	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->track_following.imm.turn_rate                      , "IMM_turn_rate"    );
+	onboard_parameters_add_parameter_int32    ( onboard_parameters , (int32_t*)&central_data->track_following.guidance                 , "TF_guidance"      );
+	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->track_following.kalman_batch.gate_threshold        , "KF_gate"          );
+	onboard_parameters_add_parameter_int32    ( onboard_parameters , &central_data->track_following.kalman_batch.gate_max_rejections   , "KF_gate_rejects"  );
+	onboard_parameters_add_parameter_int32    ( onboard_parameters , &central_data->track_following.kalman_batch.adaptation.enabled    , "KF_adapt"         );
+	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->track_following.kalman_batch.adaptation.max_acc_estimate           , "KF_max_acc"       );
+	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->track_following.kalman_batch.adaptation.position_variance_estimate , "KF_R_pos"         );
+	onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->track_following.kalman_batch.adaptation.velocity_variance_estimate , "KF_R_vel"         );
 	//onboard_parameters_add_parameter_float    ( onboard_parameters , &central_data->navigation.soft_zone_size							  , "vel_softZone"     );
 	
 	onboard_parameters_add_parameter_int32(onboard_parameters, (int32_t*) &central_data->state.remote_active,"Remote_Active");
@@ -260,6 +290,7 @@ void mavlink_telemetry_add_data_logging_parameters(data_logging_t* data_logging)
 	data_logging_add_parameter_uint8(data_logging,&central_data->neighbor_selection.number_of_neighbors, "num_neighbors");
 	
 	data_logging_add_parameter_float(data_logging,&central_data->track_following.dist2following,"dist2follow");
+	data_logging_add_parameter_float(data_logging,&central_data->track_following.intercept_time,"intercept_t");
 };
 
 void mavlink_telemetry_init_communication_module(central_data_t *central_data)
@@ -281,6 +312,9 @@ void mavlink_telemetry_init_communication_module(central_data_t *central_data)
 								
 	data_logging_telemetry_init(&central_data->data_logging,
 								&central_data->mavlink_communication.message_handler);
+
+	scheduler_telemetry_init(	&central_data->scheduler,
+								&central_data->mavlink_communication.message_handler);
 }
 
 
@@ -325,11 +359,18 @@ void mavlink_telemetry_init(void)
 	mavlink_communication_add_msg_send(mavlink_communication,	500000,	RUN_NEVER,		PERIODIC_ABSOLUTE, PRIORITY_NORMAL, (mavlink_send_msg_function_t)&simulation_telemetry_send_quaternions,					&central_data->sim_model,			MAVLINK_MSG_ID_HIL_STATE_QUATERNION);					// ID 115
 	
 	//mavlink_communication_add_msg_send(mavlink_communication,	250000,	RUN_NEVER,		PERIODIC_ABSOLUTE, PRIORITY_NORMAL, (mavlink_send_msg_function_t)&scheduler_telemetry_send_rt_stats,						&central_data->scheduler, 			MAVLINK_MSG_ID_NAMED_VALUE_FLOAT);						// ID 251
+	mavlink_communication_add_msg_send(mavlink_communication,	1000000,	RUN_NEVER,		PERIODIC_ABSOLUTE, PRIORITY_LOW, (mavlink_send_msg_function_t)&scheduler_telemetry_send_deadline_stats,				&central_data->scheduler, 			MAVLINK_MSG_ID_MEMORY_VECT);						// ID 249
+	mavlink_communication_add_msg_send(mavlink_communication,	1000000,	RUN_NEVER,		PERIODIC_ABSOLUTE, PRIORITY_LOW, (mavlink_send_msg_function_t)&scheduler_telemetry_send_execution_stats,				&central_data->scheduler, 			MAVLINK_MSG_ID_DEBUG_VECT);						// ID 250
 	// mavlink_communication_add_msg_send(mavlink_communication,	100000,	RUN_REGULAR,	PERIODIC_ABSOLUTE, PRIORITY_NORMAL, (mavlink_send_msg_function_t)&sonar_i2cxl_telemetry_send_telemetery,								&central_data->i2cxl_sonar, 		MAVLINK_MSG_ID_NAMED_VALUE_FLOAT);						// ID 251
 
 	mavlink_communication_add_msg_send(mavlink_communication, 250000, RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_NORMAL, (mavlink_send_msg_function_t)&track_following_send_dist, &central_data->track_following, MAVLINK_MSG_ID_NAMED_VALUE_FLOAT);
+	mavlink_communication_add_msg_send(mavlink_communication, 1000000, RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_NORMAL, (mavlink_send_msg_function_t)&track_following_send_rejections, &central_data->track_following, MAVLINK_MSG_ID_NAMED_VALUE_INT);
+	mavlink_communication_add_msg_send(mavlink_communication, 1000000, RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_NORMAL, (mavlink_send_msg_function_t)&track_following_send_adaptation, &central_data->track_following, MAVLINK_COMMUNICATION_TASK_ID_ADAPTATION);
+	mavlink_communication_add_msg_send(mavlink_communication, 1000000, RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_LOW, (mavlink_send_msg_function_t)&vibration_analyser_telemetry_send_peaks, &central_data->vibration_analyser, MAVLINK_COMMUNICATION_TASK_ID_VIBRATION_PEAKS);
+	mavlink_communication_add_msg_send(mavlink_communication, 1000000, RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_LOW, (mavlink_send_msg_function_t)&scheduler_telemetry_send_budget, &central_data->mavlink_communication.scheduler, MAVLINK_COMMUNICATION_TASK_ID_BUDGET);
 
 	scheduler_sort_tasks(&central_data->mavlink_communication.scheduler);
+	scheduler_analysis_admission_control(&central_data->mavlink_communication.scheduler);
 	
 	print_util_dbg_print("MAVlink telemetry initialiased\r\n");
 }
\ No newline at end of file
@@ -95,7 +95,7 @@ task_return_t simu_gps_track_pack_msg(simu_gps_track_t* simu_gps_track)
 	return TASK_RUN_SUCCESS;
 }
 
-void simu_gps_track_send_neighbor_heartbeat(simu_gps_track_t* simu_gps_track)
+task_return_t simu_gps_track_send_neighbor_heartbeat(simu_gps_track_t* simu_gps_track)
 {
 	mavlink_message_t msg;
 
@@ -109,6 +109,8 @@ void simu_gps_track_send_neighbor_heartbeat(simu_gps_track_t* simu_gps_track)
 								MAV_STATE_ACTIVE);
 
 	mavlink_stream_send(simu_gps_track->mavlink_stream,&msg);
+
+	return TASK_RUN_SUCCESS;
 }
 
 void simu_gps_track_send_msg(simu_gps_track_t* simu_gps_track, const mavlink_stream_t* mavlink_stream, mavlink_message_t* msg)
@@ -88,7 +88,7 @@ void simu_gps_track_send_msg(simu_gps_track_t* simu_gps_track, const mavlink_str
  *
  * \param	simu_gps_track			The pointer to the simulated GPS track structure
  */
-void simu_gps_track_send_neighbor_heartbeat(simu_gps_track_t* simu_gps_track);
+task_return_t simu_gps_track_send_neighbor_heartbeat(simu_gps_track_t* simu_gps_track);
 
 /**
  * \brief	Initialise the simulated GPS track module
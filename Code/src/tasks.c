@@ -54,6 +54,8 @@
 #include "hmc5883l.h"
 #include "stdio_usb.h"
 #include "data_logging.h"
+#include "scheduler_analysis.h"
+#include <stdio.h>
 
 #include "pwm_servos.h"
 
@@ -79,13 +81,25 @@ void tasks_run_imu_update(void* arg)
 	} 
 	else 
 	{
-		lsm330dlc_gyro_update(&(central_data->imu.raw_gyro));
-		lsm330dlc_acc_update(&(central_data->imu.raw_accelero));
+		lsm330dlc_gyro_fifo_update(&(central_data->imu.gyro_samples));
+		lsm330dlc_acc_fifo_update(&(central_data->imu.acc_samples));
 		hmc5883l_update(&(central_data->imu.raw_compass));
 	}
 	
 	imu_update(	&central_data->imu);
-	qfilter_update(&central_data->attitude_filter);
+	vibration_analyser_add_sample(&central_data->vibration_analyser);
+	
+	switch (central_data->attitude_estimator)
+	{
+		case AHRS_MEKF:
+			mekf_update(&central_data->attitude_mekf);
+			break;
+		
+		case AHRS_QFILTER:
+		default:
+			qfilter_update(&central_data->attitude_filter);
+			break;
+	}
 	
 	if (central_data->imu.calibration_level == OFF)
 	{
@@ -233,36 +247,116 @@ task_return_t tasks_led_toggle(void* arg)
 }
 
 
-void tasks_create_tasks() 
-{	
-	central_data = central_data_get_pointer_to_struct();
-	
-	scheduler_t* scheduler = &central_data->scheduler;
+task_return_t tasks_run_navigation_update(void* arg)
+{
+	return navigation_update(&central_data->navigation);
+}
+
+
+task_return_t tasks_run_state_machine_update(void* arg)
+{
+	return state_machine_update(&central_data->state_machine);
+}
+
+
+task_return_t tasks_run_mavlink_update(void* arg)
+{
+	return mavlink_communication_update(&central_data->mavlink_communication);
+}
+
+
+task_return_t tasks_run_analog_monitor_update(void* arg)
+{
+	return analog_monitor_update(&central_data->analog_monitor);
+}
+
+
+task_return_t tasks_run_waypoint_time_out(void* arg)
+{
+	return waypoint_handler_control_time_out_waypoint_msg(&central_data->waypoint_handler);
+}
+
+
+task_return_t tasks_run_data_logging_update(void* arg)
+{
+	return data_logging_update(&central_data->data_logging);
+}
 
-	scheduler_add_task(scheduler, 4000,	RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_HIGHEST, &tasks_run_stabilisation                                          , 0															, 0);
-	// scheduler_add_task(scheduler, 4000, 	RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_HIGHEST, &tasks_run_stabilisation_quaternion                               , 0 													, 0);
 
-	//scheduler_add_task(scheduler, 20000, 	RUN_REGULAR, PERIODIC_RELATIVE, PRIORITY_HIGH   , (task_function_t)&remote_update 									, (task_argument_t)&central_data->remote 				, 1);
+task_return_t tasks_run_imu_filter_update(void* arg)
+{
+	return imu_update_filter(&central_data->imu);
+}
+
+
+task_return_t tasks_run_vibration_analysis(void* arg)
+{
+	return vibration_analyser_update(&central_data->vibration_analyser);
+}
+
+
+task_return_t tasks_run_simu_gps_track_update(void* arg)
+{
+	return simu_gps_track_pack_msg(&central_data->simu_gps_track);
+}
+
+
+task_return_t tasks_run_neighbor_heartbeat(void* arg)
+{
+	return simu_gps_track_send_neighbor_heartbeat(&central_data->simu_gps_track);
+}
+
+
+/**
+ * \brief	Tasks of the main scheduler, by decreasing priority then increasing period (see scheduler_sort_tasks())
+ *
+ * \details	The table stays in flash, the arguments are taken from central_data by the task functions
+ */
+static const task_table_entry_t tasks_table[] =
+{
+	{ .descriptor = { .call_function = &tasks_run_stabilisation, .task_id = 0, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_HIGHEST }, .run_mode = RUN_REGULAR, .repeat_period = 4000, .deadline = 2000 },
+	// { .descriptor = { .call_function = &tasks_run_stabilisation_quaternion, .task_id = 0, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_HIGHEST }, .run_mode = RUN_REGULAR, .repeat_period = 4000 },
+	{ .descriptor = { .call_function = &tasks_run_navigation_update, .task_id = 4, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_HIGH }, .run_mode = RUN_REGULAR, .repeat_period = 10000 },
+	{ .descriptor = { .call_function = &tasks_run_barometer_update, .task_id = 2, .timing_mode = PERIODIC_RELATIVE, .priority = PRIORITY_HIGH }, .run_mode = RUN_REGULAR, .repeat_period = 15000 },
+	{ .descriptor = { .call_function = &tasks_run_gps_update, .task_id = 3, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_HIGH }, .run_mode = RUN_REGULAR, .repeat_period = 100000 },
 	
-	scheduler_add_task(scheduler, 15000, 	RUN_REGULAR, PERIODIC_RELATIVE, PRIORITY_HIGH   , &tasks_run_barometer_update                                       , 0 													, 2);
-	scheduler_add_task(scheduler, 100000, 	RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_HIGH   , &tasks_run_gps_update                                             , 0 													, 3);
-	scheduler_add_task(scheduler, 10000, 	RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_HIGH   , (task_function_t)&navigation_update										, (task_argument_t)&central_data->navigation					, 4);
+	{ .descriptor = { .call_function = &tasks_run_mavlink_update, .task_id = 6, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_NORMAL }, .run_mode = RUN_REGULAR, .repeat_period = 4000 },
+	{ .descriptor = { .call_function = &tasks_run_state_machine_update, .task_id = 5, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_NORMAL }, .run_mode = RUN_REGULAR, .repeat_period = 200000 },
 	
-	scheduler_add_task(scheduler, 200000,   RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_NORMAL , (task_function_t)&state_machine_update              				, (task_argument_t)&central_data->state_machine         , 5);
+	{ .descriptor = { .call_function = &tasks_run_waypoint_time_out, .task_id = 8, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_LOW }, .run_mode = RUN_REGULAR, .repeat_period = 10000 },
+	{ .descriptor = { .call_function = &tasks_run_analog_monitor_update, .task_id = 7, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_LOW }, .run_mode = RUN_REGULAR, .repeat_period = 100000 },
+	{ .descriptor = { .call_function = &tasks_run_data_logging_update, .task_id = 9, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_LOW }, .run_mode = RUN_REGULAR, .repeat_period = 100000 },
+	{ .descriptor = { .call_function = &tasks_run_imu_filter_update, .task_id = 13, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_LOW }, .run_mode = RUN_REGULAR, .repeat_period = 500000 },
+	
+	{ .descriptor = { .call_function = &tasks_run_vibration_analysis, .task_id = 14, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_LOWEST }, .run_mode = RUN_REGULAR, .repeat_period = 250000 },
+	{ .descriptor = { .call_function = &tasks_led_toggle, .task_id = 10, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_LOWEST }, .run_mode = RUN_REGULAR, .repeat_period = 500000 },
+	//comment line to test with other robot
+	{ .descriptor = { .call_function = &tasks_run_neighbor_heartbeat, .task_id = 12, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_LOWEST }, .run_mode = RUN_REGULAR, .repeat_period = 1000000 },
+	//comment line to test with other robot
+	{ .descriptor = { .call_function = &tasks_run_simu_gps_track_update, .task_id = 11, .timing_mode = PERIODIC_ABSOLUTE, .priority = PRIORITY_LOWEST }, .run_mode = RUN_REGULAR, .repeat_period = MSG_PERIOD_SEC * 1000000 },
+};
+
 
-	scheduler_add_task(scheduler, 4000, 	RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_NORMAL , (task_function_t)&mavlink_communication_update                    , (task_argument_t)&central_data->mavlink_communication , 6);
-	scheduler_add_task(scheduler, 100000, 	RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_LOW    , (task_function_t)&analog_monitor_update                           , (task_argument_t)&central_data->analog_monitor 		, 7);
-	scheduler_add_task(scheduler, 10000, 	RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_LOW    , (task_function_t)&waypoint_handler_control_time_out_waypoint_msg  , (task_argument_t)&central_data->waypoint_handler 		, 8);
+void tasks_create_tasks() 
+{	
+	central_data = central_data_get_pointer_to_struct();
+	
+	scheduler_t* scheduler = &central_data->scheduler;
 	
-	scheduler_add_task(scheduler, 100000,   RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_LOW	, (task_function_t)&data_logging_update								, (task_argument_t)&central_data->data_logging			, 9);
+	scheduler_add_task_table(scheduler, tasks_table, sizeof(tasks_table) / sizeof(tasks_table[0]));
 	
-	scheduler_add_task(scheduler, 500000,	RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_LOWEST , &tasks_led_toggle													, 0														, 10);
+	scheduler_analysis_admission_control(scheduler);
 
-	//comment line to test with other robot
-	scheduler_add_task(scheduler, MSG_PERIOD_SEC * 1000000, RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_LOWEST, (task_function_t)&simu_gps_track_pack_msg			,(task_argument_t)&central_data->simu_gps_track			, 11);
+	// The navigation follows the neighbors, update it as soon as one of their position is received
+	central_data->neighbor_selection.new_message_task = scheduler_get_task_by_id(scheduler, 4);
 
-	//comment line to test with other robot
-	scheduler_add_task(scheduler, 1000000, RUN_REGULAR, PERIODIC_ABSOLUTE, PRIORITY_LOWEST, (task_function_t)&simu_gps_track_send_neighbor_heartbeat			,(task_argument_t)&central_data->simu_gps_track			, 12);
+	// Log the worst case execution time of every task, the task entries do not move once sorted
+	for (uint32_t i = 0; i < scheduler->task_set->task_count; i++)
+	{
+		char name[MAVLINK_MSG_PARAM_SET_FIELD_PARAM_ID_LEN];
+		task_entry_t* te = scheduler_get_task_by_index(scheduler, i);
 
-	scheduler_sort_tasks(scheduler);
+		snprintf(name, MAVLINK_MSG_PARAM_SET_FIELD_PARAM_ID_LEN, "wcet_%lu", (unsigned long)te->descriptor->task_id);
+		data_logging_add_parameter_uint32(&central_data->data_logging, &te->wcet, name);
+	}
 }
@@ -126,6 +126,60 @@ task_return_t adc_update(void* arg);
  */
 task_return_t tasks_led_toggle(void* arg);
 
+
+/**
+ * \brief            Run the state machine task
+ */
+task_return_t tasks_run_state_machine_update(void* arg);
+
+
+/**
+ * \brief            Run the MAVLink communication task
+ */
+task_return_t tasks_run_mavlink_update(void* arg);
+
+
+/**
+ * \brief            Run the analog monitor task
+ */
+task_return_t tasks_run_analog_monitor_update(void* arg);
+
+
+/**
+ * \brief            Run the waypoint message time out task
+ */
+task_return_t tasks_run_waypoint_time_out(void* arg);
+
+
+/**
+ * \brief            Run the data logging task
+ */
+task_return_t tasks_run_data_logging_update(void* arg);
+
+
+/**
+ * \brief            Run the task recomputing the IMU filters when their parameters change
+ */
+task_return_t tasks_run_imu_filter_update(void* arg);
+
+
+/**
+ * \brief            Run the vibration analysis, resumable within its time budget
+ */
+task_return_t tasks_run_vibration_analysis(void* arg);
+
+
+/**
+ * \brief            Run the task sending the position of the simulated target
+ */
+task_return_t tasks_run_simu_gps_track_update(void* arg);
+
+
+/**
+ * \brief            Run the task sending the heartbeat of the simulated neighbor
+ */
+task_return_t tasks_run_neighbor_heartbeat(void* arg);
+
 #ifdef __cplusplus
 }
 #endif